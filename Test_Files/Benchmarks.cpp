@@ -0,0 +1,292 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include <SampleComponents.hpp>
+#include <SampleMessages.hpp>
+#include <SampleSystems.hpp>
+
+#include <OCS/OCS.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ocs;
+
+namespace bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+//!Run a benchmark body several times and report the best time per operation
+template<typename Func>
+void run(const std::string& name, std::size_t operations, Func body)
+{
+    const int repetitions = 5;
+    double best = 0.0;
+
+    for(int i = 0; i < repetitions; ++i)
+    {
+        auto start = Clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if(i == 0 || seconds < best)
+            best = seconds;
+    }
+
+    std::cout << name << ": " << (best * 1e9 / operations) << " ns/op, "
+              << static_cast<std::size_t>(operations / best) << " ops/s\n";
+}
+
+void BENCH_POST_MESSAGES()
+{
+    const std::size_t messagesPerFrame = 200000;
+
+    MessageHub msgHub;
+    Transceiver sender;
+
+    run("Post Explosion", messagesPerFrame, [&]()
+    {
+        for(std::size_t i = 0; i < messagesPerFrame; ++i)
+            msgHub.postMessage<Explosion>(sender, static_cast<int>(i), 10);
+        msgHub.clearPostedMessages();
+    });
+
+    run("Post and read Explosion", messagesPerFrame, [&]()
+    {
+        for(std::size_t i = 0; i < messagesPerFrame; ++i)
+            msgHub.postMessage<Explosion>(sender, static_cast<int>(i), 10);
+
+        long total = 0;
+        auto explosions = msgHub.readPostedMessages<Explosion>();
+        for(std::size_t i = 0; i < explosions.size(); ++i)
+            total += explosions[i].radius;
+
+        msgHub.clearPostedMessages();
+        if(total < 0)
+            std::cout << total;
+    });
+
+    msgHub.enableStatistics();
+
+    run("Post and read Explosion with statistics", messagesPerFrame, [&]()
+    {
+        for(std::size_t i = 0; i < messagesPerFrame; ++i)
+            msgHub.postMessage<Explosion>(sender, static_cast<int>(i), 10);
+
+        long total = 0;
+        auto explosions = msgHub.readPostedMessages<Explosion>();
+        for(std::size_t i = 0; i < explosions.size(); ++i)
+            total += explosions[i].radius;
+
+        msgHub.advanceFrame();
+        msgHub.clearPostedMessages();
+        if(total < 0)
+            std::cout << total;
+    });
+
+    msgHub.disableStatistics();
+}
+
+void BENCH_SCHEDULED_MESSAGES()
+{
+    const std::size_t totalTimers = 500000;
+
+    MessageHub msgHub;
+    Transceiver sender;
+
+    run("Schedule and deliver Explosion", totalTimers, [&]()
+    {
+        double start = msgHub.getTime();
+        for(std::size_t i = 0; i < totalTimers; ++i)
+            msgHub.postMessageAt<Explosion>(start + (i % 10000) * 0.001, sender, static_cast<int>(i), 10);
+
+        while(msgHub.getTotalScheduledMessages() > 0)
+        {
+            msgHub.advanceTime(1.0 / 60.0);
+            msgHub.clearPostedMessages();
+        }
+    });
+}
+
+void BENCH_SHARED_MESSAGES()
+{
+    const std::size_t messagesPerFrame = 10000;
+
+    MessageHub msgHub, remoteHub;
+    Transceiver sender;
+
+    SharedMessageWriter writer;
+    writer.bindMessageType<Explosion>("Explosion");
+    writer.create("/ocs_bench_messages", 1 << 20);
+
+    SharedMessageReader reader;
+    reader.bindMessageType<Explosion>("Explosion");
+    reader.open("/ocs_bench_messages");
+
+    msgHub.addMessageTap(&writer);
+
+    run("Post Explosion through shared memory", messagesPerFrame, [&]()
+    {
+        for(std::size_t i = 0; i < messagesPerFrame; ++i)
+            msgHub.postMessage<Explosion>(sender, static_cast<int>(i), 10);
+        msgHub.clearPostedMessages();
+
+        reader.poll(remoteHub);
+        remoteHub.clearPostedMessages();
+    });
+
+    msgHub.removeMessageTap(&writer);
+}
+
+//!A component and system pair that do a fixed amount of arithmetic per object and conflict with nothing else
+template<int N>
+struct Workload : public Component<Workload<N>>
+{
+    float value = 1.0f;
+};
+
+template<int N>
+struct WorkloadSystem : public System
+{
+    WorkloadSystem() { writesComponents<Workload<N>>(); }
+
+    void update(ObjectManager& objManager, MessageHub&, double dt)
+    {
+        for(auto& workload : objManager.getComponentArray<Workload<N>>())
+            for(int i = 0; i < 200; ++i)
+                workload.value = std::sqrt(workload.value * workload.value + static_cast<float>(dt));
+    }
+};
+
+template<int N>
+void addWorkload(ObjectManager& objManager, SystemManager& sysManager, const std::vector<ID>& objects)
+{
+    for(auto objectID : objects)
+        objManager.addComponents(objectID, Workload<N>());
+
+    sysManager.addSystem<WorkloadSystem<N>>();
+}
+
+void BENCH_PARALLEL_SYSTEMS()
+{
+    const std::size_t totalObjects = 2000;
+    const std::size_t totalFrames = 20;
+
+    ObjectManager objManager;
+    MessageHub msgHub;
+    SystemManager sysManager(objManager, msgHub);
+
+    std::vector<ID> objects;
+    for(std::size_t i = 0; i < totalObjects; ++i)
+    {
+        objects.push_back(objManager.createObject());
+        objManager.addComponents(objects.back(), Position(0, 0), Motion(10, static_cast<float>(i)));
+    }
+
+    sysManager.addSystem<MovementSystem>();
+    addWorkload<0>(objManager, sysManager, objects);
+    addWorkload<1>(objManager, sysManager, objects);
+    addWorkload<2>(objManager, sysManager, objects);
+    addWorkload<3>(objManager, sysManager, objects);
+    addWorkload<4>(objManager, sysManager, objects);
+    addWorkload<5>(objManager, sysManager, objects);
+    addWorkload<6>(objManager, sysManager, objects);
+
+    auto updateFrames = [&]()
+    {
+        for(std::size_t frame = 0; frame < totalFrames; ++frame)
+            sysManager.updateAllSystems(1.0 / 60.0);
+    };
+
+    run("Update 8 systems sequentially", totalFrames, updateFrames);
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads = 1; threads <= cores; threads *= 2)
+    {
+        //The updating thread helps, so one fewer worker than threads
+        JobSystem jobs(threads - 1);
+        sysManager.setJobSystem(&jobs);
+
+        run("Update 8 systems on " + std::to_string(threads) + " thread(s)", totalFrames, updateFrames);
+
+        sysManager.setJobSystem(nullptr);
+    }
+}
+
+//Moves a fixed set of objects every tick
+struct MovingWorld : public State
+{
+    MovingWorld()
+    {
+        sysManager.addSystem<MovementSystem>();
+
+        for(int i = 0; i < 10000; ++i)
+            objManager.createObject(Position(0, 0), Motion(10, i * 0.01));
+    }
+
+    void configure() {}
+    void initialize() {}
+    void update(double dt) { sysManager.updateAllSystems(dt); }
+};
+
+void BENCH_HEADLESS_RUN()
+{
+    const uint64_t ticks = 2000;
+
+    MovingWorld world;
+    HeadlessRunStats stats = world.runHeadless(ticks, 1.0 / 60.0);
+
+    std::cout << "Headless run of " << ticks << " ticks with 10000 moving objects: "
+              << static_cast<std::size_t>(stats.ticksPerSecond) << " ticks/s\n";
+}
+
+}//bench
+
+int main(int argc, char** argv)
+{
+    //Pass a benchmark group name to only run that group
+    auto selected = [&](const char* group) { return argc < 2 || std::strcmp(argv[1], group) == 0; };
+
+    if(selected("messages"))
+        bench::BENCH_POST_MESSAGES();
+
+    if(selected("timers"))
+        bench::BENCH_SCHEDULED_MESSAGES();
+
+    if(selected("shm"))
+        bench::BENCH_SHARED_MESSAGES();
+
+    if(selected("systems"))
+        bench::BENCH_PARALLEL_SYSTEMS();
+
+    if(selected("headless"))
+        bench::BENCH_HEADLESS_RUN();
+
+    return 0;
+}
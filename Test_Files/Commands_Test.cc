@@ -29,6 +29,8 @@ freely, subject to the following restrictions:
 
 #include <iostream>
 #include <cassert>
+#include <thread>
+#include <algorithm>
 
 using namespace ocs;
 
@@ -143,14 +145,14 @@ void TEST_ADD_COMPONENTS_COMMAND()
 
     assert(objManager.getTotalComponents<Position>() == 1);
     assert(objManager.getTotalComponents<Collidable>() == 1);
-    assert(!objManager.getComponent<Motion>(id2));
+    assert(!objManager.getComponent<Position>(id2));
     assert(!objManager.getComponent<Collidable>(id2));
 
     addMultiple.execute();
 
     assert(objManager.getTotalComponents<Position>() == 2);
     assert(objManager.getTotalComponents<Collidable>() == 2);
-    assert(objManager.getComponent<Motion>(id2));
+    assert(objManager.getComponent<Position>(id2));
     assert(objManager.getComponent<Collidable>(id2));
 
     //Create a blank object and execute the component pack command on it
@@ -159,7 +161,7 @@ void TEST_ADD_COMPONENTS_COMMAND()
 
     assert(objManager.getTotalComponents<Position>() == 2);
     assert(objManager.getTotalComponents<Collidable>() == 2);
-    assert(!objManager.getComponent<Motion>(id4));
+    assert(!objManager.getComponent<Position>(id4));
     assert(!objManager.getComponent<Collidable>(id4));
 
     addMultiple.setObjectId(id4);
@@ -168,7 +170,7 @@ void TEST_ADD_COMPONENTS_COMMAND()
 
     assert(objManager.getTotalComponents<Position>() == 3);
     assert(objManager.getTotalComponents<Collidable>() == 3);
-    assert(objManager.getComponent<Motion>(id4));
+    assert(objManager.getComponent<Position>(id4));
     assert(objManager.getComponent<Collidable>(id4));
 
     //Try to add to object that doesn't exist
@@ -200,6 +202,89 @@ void TEST_REMOVE_COMPONENTS_COMMAND()
     std::cout << "Finished Testing Remove Components Command\n";
 }
 
+void TEST_COMMAND_BUFFERS()
+{
+    std::cout << "Testing Command Buffers\n";
+
+    auto existing = objManager.createObject(Position(1, 1), Motion(1, 1));
+
+    //Record from several threads at once. Nothing is applied until the sync point.
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t]()
+        {
+            CommandBuffer::setSortKey(t);
+            auto& commands = objManager.getCommandBuffer();
+
+            for(int i = 0; i < 25; ++i)
+            {
+                ID deferred = commands.createObject();
+                assert(CommandBuffer::isDeferredID(deferred));
+                commands.addComponents(deferred, Position(t, i), Motion(t, i));
+            }
+        });
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+
+    assert(objManager.getTotalObjects() == 1);
+
+    auto& commands = objManager.getCommandBuffer();
+    commands.removeComponents<Motion>(existing);
+    commands.addComponents(existing, Name("Existing"));
+    assert(commands.getTotalCommands() == 2);
+
+    objManager.applyDeferredCommands();
+    assert(objManager.getTotalObjects() == 101);
+    assert(objManager.getTotalComponents<Position>() == 101);
+    assert(objManager.getTotalComponents<Motion>() == 100);
+    assert((objManager.hasComponents<Position, Name>(existing)));
+    assert(!objManager.hasComponents<Motion>(existing));
+    assert(commands.getTotalCommands() == 0);
+
+    //Objects are created in sort key order regardless of which thread recorded first
+    auto created = objManager.getObjects<Motion>();
+    std::sort(created.begin(), created.end());
+    for(std::size_t i = 0; i < created.size(); ++i)
+        assert((*objManager.getComponent<Position>(created[i]) == Position(i / 25, i % 25)));
+
+    //Commands on a deferred id, and destroying in the same frame
+    ID deferred = commands.createObject();
+    commands.addComponents(deferred, Position(5, 5));
+    commands.destroyObject(existing);
+    commands.destroyObject(deferred);
+    objManager.applyDeferredCommands();
+    assert(objManager.getTotalObjects() == 100);
+    assert(objManager.getTotalComponents<Position>() == 100);
+
+    //Adding then removing a component leaves it removed
+    ID target = objManager.createObject(Position(1, 1));
+    commands.addComponents(target, Name("Added"));
+    commands.removeComponents<Name>(target);
+    objManager.applyDeferredCommands();
+    assert(!objManager.hasComponents<Name>(target));
+
+    //Removing then adding a component replaces it
+    commands.removeComponents<Position>(target);
+    commands.addComponents(target, Position(2, 3));
+    objManager.applyDeferredCommands();
+    assert((*objManager.getComponent<Position>(target) == Position(2, 3)));
+
+    //Commands for other objects are still batched in between
+    commands.addComponents(target, Motion(1, 2));
+    commands.addComponents(created[0], Name("Other"));
+    commands.removeComponents<Motion>(target);
+    objManager.applyDeferredCommands();
+    assert(!objManager.hasComponents<Motion>(target));
+    assert(objManager.getComponent<Name>(created[0])->name == "Other");
+
+    CommandBuffer::setSortKey(0);
+    objManager.destroyAllObjects();
+    std::cout << "Finished Testing Command Buffers\n";
+}
+
 void TEST_RUN_SCRIPT_COMMAND()
 {
     std::cout << "Testing Run Script Command\n";
@@ -217,6 +302,9 @@ int testCommands()
     cmdtest::TEST_DESTROY_OBJECT_COMMAND();
     cmdtest::TEST_ADD_COMPONENTS_COMMAND();
     cmdtest::TEST_REMOVE_COMPONENTS_COMMAND();
+    cmdtest::TEST_COMMAND_BUFFERS();
     // cmdtest::TEST_RUN_SCRIPT_COMMAND();
     std::cout << "Finished Testing Commands\n";
+
+    return 0;
 }
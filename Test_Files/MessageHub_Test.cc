@@ -28,6 +28,16 @@ freely, subject to the following restrictions:
 
 #include <iostream>
 #include <cassert>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace ocs;
 
@@ -48,11 +58,11 @@ void TEST_MESSAGE_POSTING()
 
     auto txtMsgs = msgHub.readPostedMessages<TextMessage>();
 
-    assert(txtMsgs[0]->getSender() == 0);
-    assert(txtMsgs[0]->msg == "Hello\n");
+    assert(txtMsgs[0].getSender() == 0);
+    assert(txtMsgs[0].msg == "Hello\n");
 
-    assert(txtMsgs[1]->getSender() == 1);
-    assert(txtMsgs[1]->msg == "Hi!\n");
+    assert(txtMsgs[1].getSender() == 1);
+    assert(txtMsgs[1].msg == "Hi!\n");
 
     std::cout << "Finished Testing Message Posting\n";
 }
@@ -66,7 +76,7 @@ void TEST_MESSAGE_PM()
     auto privateTxtMsgs = msgHub.readPrivateMessages<TextMessage>(t2);
 
     assert(privateTxtMsgs.size() == 1);
-    assert(privateTxtMsgs[0]->msg == "Hello t2!\n");
+    assert(privateTxtMsgs[0].msg == "Hello t2!\n");
 
     msgHub.clearPrivateMessages(t2);
 
@@ -77,7 +87,886 @@ void TEST_MESSAGE_PM()
     std::cout << "Finished Testing Private Messaging\n";
 }
 
+void TEST_MESSAGE_SLOTS()
+{
+    std::cout << "Testing Message Slots\n";
+
+    MessageHub hub;
+    assert(hub.readPostedMessages<Explosion>().empty());
+
+    for(int i = 0; i < 1000; ++i)
+        hub.postMessage<Explosion>(t1, i, i * 2);
+
+    auto explosions = hub.readPostedMessages<Explosion>();
+    assert(explosions.size() == 1000);
+
+    int total = 0;
+    for(const auto& explosion : explosions)
+        total += explosion.radius;
+    assert(total == 999 * 1000 / 2);
+    assert(explosions.back().damage == 999 * 2);
+
+    //Other message types are stored separately
+    assert(hub.readPostedMessages<TextMessage>().size() == 0);
+
+    //Clearing keeps the slot's memory so the next frame's messages reuse it
+    const Explosion* first = explosions.begin();
+    hub.clearPostedMessages();
+    assert(hub.readPostedMessages<Explosion>().empty());
+
+    for(int i = 0; i < 1000; ++i)
+        hub.postMessage<Explosion>(t1, i, i);
+    assert(hub.readPostedMessages<Explosion>().begin() == first);
+
+    std::cout << "Finished Testing Message Slots\n";
+}
+
+void TEST_MESSAGE_METADATA()
+{
+    std::cout << "Testing Message Metadata\n";
+
+    MessageHub hub;
+    hub.postMessage<TextMessage>(t1, "First");
+    hub.postMessage<Explosion>(t1, 1, 1);
+    hub.advanceFrame();
+    hub.sendPrivateMessage<TextMessage>(t2.getID(), t1, "Second");
+
+    const auto& first = hub.readPostedMessages<TextMessage>()[0].getMetadata();
+    const auto& explosion = hub.readPostedMessages<Explosion>()[0].getMetadata();
+    const auto& second = hub.readPrivateMessages<TextMessage>(t2)[0].getMetadata();
+
+    //Sequence ids are shared by every message type and slot
+    assert(first.sequence == 0 && explosion.sequence == 1 && second.sequence == 2);
+    assert(first.frame == 0 && second.frame == 1);
+    assert(first.timeNanoseconds <= second.timeNanoseconds);
+    assert(second.timeNanoseconds <= BaseMessage::getMonotonicTime());
+
+    //The readable time is only built when asked for
+    assert(!hub.readPostedMessages<TextMessage>()[0].getTimeStamp().empty());
+
+    std::cout << "Finished Testing Message Metadata\n";
+}
+
+void TEST_MESSAGE_SUBSCRIPTIONS()
+{
+    std::cout << "Testing Message Subscriptions\n";
+
+    MessageHub hub;
+    hub.postMessage<Explosion>(t1, 1, 1);
+
+    int immediateDamage = 0;
+    int deferredDamage = 0;
+    std::vector<std::string> texts;
+
+    hub.subscribe<Explosion>(t2, [&](const Explosion& msg) { immediateDamage += msg.damage; }, DispatchMode::Immediate);
+    hub.subscribe<Explosion>(t3, [&](const Explosion& msg)
+    {
+        deferredDamage += msg.damage;
+
+        //Messages posted from a handler are delivered in the same dispatch
+        if(msg.damage == 10)
+            hub.postMessage<TextMessage>(t3, "Chain");
+    });
+    hub.subscribe<TextMessage>(t4, [&](const TextMessage& msg) { texts.push_back(msg.msg); });
+
+    hub.postMessage<Explosion>(t1, 5, 10);
+    hub.postMessage<Explosion>(t1, 5, 20);
+    assert(immediateDamage == 30);
+    assert(deferredDamage == 0);
+
+    //The message posted before subscribing is not dispatched
+    hub.dispatchMessages();
+    assert(deferredDamage == 30);
+    assert(texts.size() == 1 && texts[0] == "Chain");
+
+    //Nothing new to dispatch
+    hub.dispatchMessages();
+    assert(deferredDamage == 30);
+    assert(texts.size() == 1);
+
+    hub.clearPostedMessages();
+    hub.postMessage<Explosion>(t1, 1, 1);
+    hub.unsubscribe<Explosion>(t2);
+    hub.dispatchMessages();
+    assert(deferredDamage == 31);
+    assert(immediateDamage == 31);
+
+    //Unsubscribing from inside a handler takes effect for later messages
+    hub.subscribe<Explosion>(t2, [&](const Explosion&) { hub.unsubscribeAll(t3); }, DispatchMode::Immediate);
+    hub.postMessage<Explosion>(t1, 1, 1);
+    hub.postMessage<Explosion>(t1, 1, 1);
+    hub.dispatchMessages();
+    assert(deferredDamage == 31);
+
+    hub.unsubscribeAll(t2);
+    hub.unsubscribeAll(t4);
+    hub.postMessage<TextMessage>(t1, "Ignored");
+    hub.dispatchMessages();
+    assert(texts.size() == 1);
+
+    //A handler that posts its own type must still see the message it was given
+    MessageHub chainHub;
+    const std::string longText(64, 'x');
+    int chained = 0;
+    int nested = 0;
+    bool intact = true;
+
+    chainHub.subscribe<TextMessage>(t2, [&](const TextMessage& msg)
+    {
+        if(++chained < 40)
+            chainHub.postMessage<TextMessage>(t2, longText);
+
+        intact = intact && msg.msg == longText;
+    });
+    chainHub.subscribe<TextMessage>(t3, [&](const TextMessage& msg)
+    {
+        //Immediate handlers nest, so only go a few levels deep
+        if(++nested % 4 != 0)
+            chainHub.postMessage<TextMessage>(t3, longText);
+
+        intact = intact && msg.msg == longText;
+    }, DispatchMode::Immediate);
+
+    chainHub.postMessage<TextMessage>(t1, longText);
+    chainHub.dispatchMessages();
+    assert(chained >= 40);
+    assert(intact);
+
+    std::cout << "Finished Testing Message Subscriptions\n";
+}
+
+void TEST_COALESCED_MESSAGES()
+{
+    std::cout << "Testing Coalesced Messages\n";
+
+    MessageHub hub;
+    hub.setDoubleBuffered(true);
+
+    //Only the newest message per key is kept, in the order keys were first posted
+    for(int i = 0; i < 100; ++i)
+        hub.postCoalescedMessage<Explosion>(i % 10, t1, i % 10, i);
+
+    hub.postMessage<Explosion>(t1, -1, -1);
+    hub.advanceFrame();
+
+    auto explosions = hub.readPostedMessages<Explosion>();
+    assert(explosions.size() == 11);
+    for(int key = 0; key < 10; ++key)
+    {
+        assert(explosions[key].radius == key);
+        assert(explosions[key].damage == 90 + key);
+    }
+    assert(explosions[10].radius == -1);
+
+    //Keys start over every frame
+    hub.postCoalescedMessage<Explosion>(3, t1, 3, 1000);
+    hub.advanceFrame();
+    assert(hub.readPostedMessages<Explosion>().size() == 1);
+    assert(hub.readPostedMessages<Explosion>()[0].damage == 1000);
+
+    //Enough keys to grow the index
+    hub.setDoubleBuffered(false);
+    for(int round = 0; round < 2; ++round)
+        for(int key = 0; key < 5000; ++key)
+            hub.postCoalescedMessage<Explosion>(key * 7919, t1, key, round);
+
+    explosions = hub.readPostedMessages<Explosion>();
+    assert(explosions.size() == 5000);
+    assert(explosions[4999].radius == 4999 && explosions[4999].damage == 1);
+
+    //Deferred handlers see the latest value even when a key is overwritten after it was dispatched
+    MessageHub latestHub;
+    std::vector<int> latest;
+    latestHub.subscribe<Explosion>(t2, [&](const Explosion& msg)
+    {
+        latest.push_back(msg.damage);
+
+        //Overwriting from inside the dispatch is delivered before it returns
+        if(msg.damage == 2)
+            latestHub.postCoalescedMessage<Explosion>(1, t1, 1, 3);
+    });
+
+    latestHub.postCoalescedMessage<Explosion>(1, t1, 1, 1);
+    latestHub.dispatchMessages();
+    latestHub.postCoalescedMessage<Explosion>(1, t1, 1, 5);
+    latestHub.postCoalescedMessage<Explosion>(1, t1, 1, 2);
+    latestHub.dispatchMessages();
+    assert((latest == std::vector<int>{1, 2, 3}));
+    assert(latestHub.readPostedMessages<Explosion>().size() == 1);
+
+    latestHub.dispatchMessages();
+    assert(latest.size() == 3);
+
+    std::cout << "Finished Testing Coalesced Messages\n";
+}
+
+void TEST_MESSAGE_RECORDING()
+{
+    std::cout << "Testing Message Recording\n";
+
+    const std::string path = "recorded_messages.ocsm";
+
+    //Record three frames of mixed traffic
+    {
+        MessageHub hub;
+        MessageRecorder recorder;
+        recorder.bindMessageType<Explosion>("Explosion");
+        recorder.bindMessageType<TextMessage>("TextMessage");
+        assert(recorder.start(path));
+        hub.addMessageTap(&recorder);
+
+        for(int frame = 0; frame < 3; ++frame)
+        {
+            for(int i = 0; i < 100; ++i)
+                hub.postMessage<Explosion>(t1, frame, i);
+
+            hub.postCoalescedMessage<Explosion>(9, t3, -1, frame);
+            hub.postTopicMessage<TextMessage>(42, t2, "Topic");
+            hub.sendPrivateMessage<TextMessage>(t4.getID(), t2, "Private " + std::to_string(frame));
+            hub.advanceFrame();
+            hub.clearPostedMessages();
+        }
+
+        hub.removeMessageTap(&recorder);
+        recorder.stop();
+        assert(recorder.getTotalRecorded() == 3 * 103);
+    }
+
+    MessageHub hub;
+    MessageReplayer replayer;
+    replayer.bindMessageType<Explosion>("Explosion");
+    replayer.bindMessageType<TextMessage>("TextMessage");
+    assert(replayer.open(path));
+
+    for(int frame = 0; frame < 3; ++frame)
+    {
+        assert(replayer.replayFrame(hub));
+
+        auto explosions = hub.readPostedMessages<Explosion>();
+        assert(explosions.size() == 101);
+        for(int i = 0; i < 100; ++i)
+        {
+            assert(explosions[i].radius == frame && explosions[i].damage == i);
+            assert(explosions[i].getSender() == t1.getID());
+        }
+        assert(explosions[100].radius == -1 && explosions[100].getSender() == t3.getID());
+
+        assert(hub.readPostedMessages<TextMessage>(42).size() == 1);
+
+        auto privateMsgs = hub.readPrivateMessages<TextMessage>(t4);
+        assert(privateMsgs.size() == 1);
+        assert(privateMsgs[0].msg == "Private " + std::to_string(frame));
+        assert(privateMsgs[0].getSender() == t2.getID());
+
+        hub.clearPostedMessages();
+    }
+
+    assert(!replayer.replayFrame(hub));
+    assert(replayer.isFinished());
+    assert(replayer.getFramesReplayed() == 3);
+
+    //Types that are not bound for replay are skipped
+    MessageReplayer partial;
+    partial.bindMessageType<TextMessage>("TextMessage");
+    assert(partial.open(path));
+    assert(partial.replayFrame(hub));
+    assert(hub.readPostedMessages<Explosion>().empty());
+    assert(hub.readPostedMessages<TextMessage>().size() == 1);
+
+    //Damaged logs fail instead of growing the type table or stopping mid-record
+    std::vector<char> header;
+    {
+        std::ifstream file(path, std::ios::binary);
+        header.resize(8);
+        file.read(header.data(), header.size());
+    }
+
+    auto replayDamaged = [&](const BinaryWriter& records)
+    {
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(header.data(), header.size());
+            file.write(records.getBuffer().data(), records.size());
+        }
+
+        MessageReplayer damaged;
+        damaged.bindMessageType<TextMessage>("TextMessage");
+        assert(damaged.open(path));
+        assert(!damaged.replayFrame(hub));
+        assert(damaged.isFinished());
+        assert(damaged.getFramesReplayed() == 0);
+    };
+
+    BinaryWriter hugeIndex;
+    hugeIndex.write(static_cast<uint8_t>(0));
+    hugeIndex.writeVarint(uint64_t(1) << 40);
+    hugeIndex.writeString("TextMessage");
+    hugeIndex.write(static_cast<uint8_t>(2));
+    replayDamaged(hugeIndex);
+
+    BinaryWriter truncated;
+    truncated.write(static_cast<uint8_t>(0));
+    truncated.writeVarint(0);
+    truncated.writeString("TextMessage");
+    truncated.write(static_cast<uint8_t>(1));
+    truncated.writeVarint(0);
+    truncated.write(static_cast<uint8_t>(PostKind::Posted));
+    truncated.writeVarint(t1.getID());
+    truncated.writeVarint(1000);
+    truncated.writeString("Cut short");
+    hub.clearPostedMessages();
+    replayDamaged(truncated);
+    assert(hub.readPostedMessages<TextMessage>().empty());
+
+    std::remove(path.c_str());
+
+    std::cout << "Finished Testing Message Recording\n";
+}
+
+void TEST_SHARED_MESSAGE_TRANSPORT()
+{
+    std::cout << "Testing Shared Message Transport\n";
+
+    const std::string name = "/ocs_test_messages";
+
+    //Wrap around and drop messages on a small ring in one process
+    {
+        MessageHub hub, remoteHub;
+        SharedMessageWriter writer;
+        writer.bindMessageType<Explosion>("Explosion");
+        assert(writer.create(name, 256));
+        hub.addMessageTap(&writer);
+
+        SharedMessageReader reader;
+        reader.bindMessageType<Explosion>("Explosion");
+        assert(reader.open(name));
+
+        for(int i = 0; i < 100; ++i)
+        {
+            hub.postMessage<Explosion>(t1, i, -i);
+            hub.postCoalescedMessage<Explosion>(5, t2, i, i);
+            assert(reader.poll(remoteHub) == 2);
+
+            auto explosions = remoteHub.readPostedMessages<Explosion>();
+            assert(explosions.size() == 2);
+            assert(explosions[0].radius == i && explosions[0].damage == -i && explosions[0].getSender() == t1.getID());
+            assert(explosions[1].radius == i && explosions[1].getSender() == t2.getID());
+            remoteHub.clearPostedMessages();
+        }
+
+        //The ring only has room for a few messages when nobody reads it
+        for(int i = 0; i < 20; ++i)
+            hub.postMessage<Explosion>(t1, i, i);
+        assert(writer.getDroppedMessages() > 0);
+        assert(reader.getDroppedMessages() == writer.getDroppedMessages());
+        assert(reader.poll(remoteHub) == 20 - writer.getDroppedMessages());
+
+        hub.removeMessageTap(&writer);
+    }
+
+    //Mirror messages to a second process
+    const int totalFrames = 50;
+    const int messagesPerFrame = 100;
+
+    MessageHub hub;
+    SharedMessageWriter writer;
+    writer.bindMessageType<Explosion>("Explosion");
+    writer.bindMessageType<TextMessage>("TextMessage");
+    assert(writer.create(name));
+    hub.addMessageTap(&writer);
+
+    pid_t child = fork();
+    assert(child >= 0);
+
+    if(child == 0)
+    {
+        MessageHub remoteHub;
+        SharedMessageReader reader;
+        reader.bindMessageType<Explosion>("Explosion");
+        reader.bindMessageType<TextMessage>("TextMessage");
+        if(!reader.open(name))
+            _exit(1);
+
+        int explosionsRead = 0;
+        int privateRead = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+        while((explosionsRead < totalFrames * messagesPerFrame || privateRead < totalFrames) &&
+              std::chrono::steady_clock::now() < deadline)
+        {
+            reader.poll(remoteHub);
+
+            for(auto& explosion : remoteHub.readPostedMessages<Explosion>())
+            {
+                if(explosion.damage != explosionsRead % messagesPerFrame || explosion.getSender() != t1.getID())
+                    _exit(2);
+                ++explosionsRead;
+            }
+
+            for(auto& text : remoteHub.readPrivateMessages<TextMessage>(t4))
+            {
+                if(text.msg != "Frame " + std::to_string(privateRead) || text.getSender() != t2.getID())
+                    _exit(3);
+                ++privateRead;
+            }
+
+            remoteHub.clearPostedMessages();
+        }
+
+        _exit((explosionsRead == totalFrames * messagesPerFrame && privateRead == totalFrames) ? 0 : 4);
+    }
+
+    for(int frame = 0; frame < totalFrames; ++frame)
+    {
+        for(int i = 0; i < messagesPerFrame; ++i)
+            hub.postMessage<Explosion>(t1, frame, i);
+
+        hub.sendPrivateMessage<TextMessage>(t4.getID(), t2, "Frame " + std::to_string(frame));
+        hub.advanceFrame();
+        hub.clearPostedMessages();
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(writer.getTotalSent() == totalFrames * (messagesPerFrame + 1));
+    assert(writer.getDroppedMessages() == 0);
+
+    hub.removeMessageTap(&writer);
+
+    std::cout << "Finished Testing Shared Message Transport\n";
+}
+
+void TEST_MESSAGE_STATISTICS()
+{
+    std::cout << "Testing Message Statistics\n";
+
+    MessageHub hub;
+    hub.enableStatistics(1);
+    hub.setMessageName<Explosion>("Explosion");
+    assert(hub.isCollectingStatistics());
+
+    for(int frame = 0; frame < 3; ++frame)
+    {
+        for(int i = 0; i <= frame * 10; ++i)
+            hub.postMessage<Explosion>(t1, i, i);
 
+        hub.sendPrivateMessage<TextMessage>(t4.getID(), t2, "Hello");
+
+        //Reads from another thread are counted too
+        std::thread reader([&hub]() { assert(hub.readPostedMessages<Explosion>().size() > 0); });
+        reader.join();
+
+        assert(hub.readPostedMessages<Explosion>().size() > 0);
+        assert(hub.readPrivateMessages<TextMessage>(t4).size() == 1);
+
+        //Empty reads are not counted
+        assert(hub.readPostedMessages<TextMessage>().empty());
+
+        hub.advanceFrame();
+        hub.clearPostedMessages();
+    }
+
+    const MessageStatistics* stats = hub.getStatistics();
+    assert(stats && stats->getFramesRecorded() == 3);
+
+    auto explosions = stats->getFamily<Explosion>();
+    assert(explosions->name == "Explosion");
+    assert(explosions->totalPosts == 1 + 11 + 21);
+    assert(explosions->lastFramePosts == 21 && explosions->peakPostsPerFrame == 21);
+    assert(explosions->totalReads == 2 * (1 + 11 + 21) && explosions->lastFrameReads == 42);
+    assert(explosions->peakSlotSize == 21);
+    assert(explosions->allocatedBytes >= 21 * sizeof(Explosion));
+    assert(explosions->latency.getTotalSamples() == 6);
+    assert(explosions->latency.getPercentile(0.5) <= explosions->latency.getMax());
+
+    auto texts = stats->getFamily<TextMessage>();
+    assert(texts->totalPosts == 3 && texts->totalReads == 3);
+    assert(texts->latency.getTotalSamples() == 3);
+
+    std::ostringstream json;
+    hub.writeStatistics(json);
+    assert(json.str().find("\"frames\": 3") != std::string::npos);
+    assert(json.str().find("\"name\": \"Explosion\"") != std::string::npos);
+    assert(json.str().find("\"totalPosts\": 33") != std::string::npos);
+
+    LatencyHistogram histogram;
+    for(uint64_t ns : {0, 1, 100, 1000, 1000, 1000000})
+        histogram.record(ns);
+    assert(histogram.getTotalSamples() == 6 && histogram.getMax() == 1000000);
+    assert(histogram.getPercentile(0.5) >= 100 && histogram.getPercentile(0.5) < 128);
+    assert(histogram.getPercentile(1.0) == 1000000);
+
+    hub.disableStatistics();
+    assert(hub.getStatistics() == nullptr);
+
+    std::cout << "Finished Testing Message Statistics\n";
+}
+
+void TEST_TOPIC_MESSAGES()
+{
+    std::cout << "Testing Topic Messages\n";
+
+    MessageHub hub;
+    assert(hub.readPostedMessages<Explosion>(7).empty());
+
+    for(int i = 0; i < 1000; ++i)
+        hub.postTopicMessage<Explosion>(i % 100, t1, i, i % 100);
+    hub.postMessage<Explosion>(t1, -1, -1);
+
+    //A topic read only visits that topic's messages, in posting order
+    auto topic7 = hub.readPostedMessages<Explosion>(7);
+    assert(topic7.size() == 10);
+
+    int expected = 7;
+    for(const auto& explosion : topic7)
+    {
+        assert(explosion.radius == expected);
+        assert(explosion.damage == 7);
+        assert(explosion.getMetadata().topic == 7);
+        expected += 100;
+    }
+
+    assert(hub.readPostedMessages<Explosion>(1000).empty());
+    assert(hub.readPostedMessages<Explosion>().size() == 1001);
+    assert(hub.readPostedMessages<Explosion>()[1000].getMetadata().topic == MessageMetadata::noTopic);
+
+    //Topics start over when the board is cleared
+    hub.clearPostedMessages();
+    assert(hub.readPostedMessages<Explosion>(7).empty());
+    hub.postTopicMessage<Explosion>(42, t1, 1, 1);
+    assert(hub.readPostedMessages<Explosion>(42).size() == 1);
+    assert(hub.readPostedMessages<Explosion>(7).empty());
+
+    //Double-buffered boards keep their topics with their messages
+    hub.setDoubleBuffered(true);
+    hub.postTopicMessage<Explosion>(5, t1, 5, 5);
+    assert(hub.readPostedMessages<Explosion>(5).empty());
+    hub.advanceFrame();
+    assert(hub.readPostedMessages<Explosion>(5).size() == 1);
+    assert(hub.readPostedMessages<Explosion>(5)[0].radius == 5);
+
+    std::cout << "Finished Testing Topic Messages\n";
+}
+
+void TEST_SCHEDULED_MESSAGES()
+{
+    std::cout << "Testing Scheduled Messages\n";
+
+    MessageHub hub;
+
+    hub.postMessageAfter<TextMessage>(5.0, t1, "Respawn");
+    hub.postMessageAfter<Explosion>(0.2, t1, 1, 1);
+    hub.postMessageAt<Explosion>(0.2, t1, 2, 2);
+    hub.postMessageAfter<Explosion>(-1.0, t1, 0, 0);
+    assert(hub.getTotalScheduledMessages() == 3);
+
+    //Past times are posted right away
+    assert(hub.readPostedMessages<Explosion>().size() == 1);
+    hub.clearPostedMessages();
+
+    hub.advanceTime(0.1);
+    assert(hub.readPostedMessages<Explosion>().empty());
+
+    //Messages due at the same time arrive in the order they were scheduled
+    hub.advanceTime(0.1);
+    auto explosions = hub.readPostedMessages<Explosion>();
+    assert(explosions.size() == 2);
+    assert(explosions[0].radius == 1 && explosions[1].radius == 2);
+    assert(hub.readPostedMessages<TextMessage>().empty());
+
+    hub.advanceTime(4.0);
+    assert(hub.readPostedMessages<TextMessage>().empty());
+    hub.advanceTime(0.8);
+    assert(hub.readPostedMessages<TextMessage>().size() == 1);
+    assert(hub.getTotalScheduledMessages() == 0);
+
+    //Many timers spread over several wheel levels, advanced in uneven steps
+    hub.clearPostedMessages();
+    const int totalTimers = 200000;
+    double start = hub.getTime();
+    for(int i = 0; i < totalTimers; ++i)
+        hub.postMessageAt<Explosion>(start + (i * 7919 % 100000) * 0.001, t1, i * 7919 % 100000, i);
+
+    //One timer far beyond the wheel's range
+    hub.postMessageAt<TextMessage>(start + 6000000.0, t1, "Far");
+
+    int delivered = 0;
+    int lastDelay = -1;
+    while(hub.getTime() < start + 100.0)
+    {
+        hub.advanceTime(0.0167);
+
+        for(const auto& explosion : hub.readPostedMessages<Explosion>())
+        {
+            assert(explosion.radius >= lastDelay);
+            assert(explosion.getMetadata().timeNanoseconds != 0);
+            lastDelay = explosion.radius;
+
+            //Never delivered before its time
+            assert(start + explosion.radius * 0.001 <= hub.getTime() + 1e-9);
+        }
+
+        delivered += hub.readPostedMessages<Explosion>().size();
+        hub.clearPostedMessages();
+    }
+
+    assert(delivered == totalTimers);
+    assert(hub.getTotalScheduledMessages() == 1);
+
+    hub.advanceTime(5999800.0);
+    assert(hub.readPostedMessages<TextMessage>().empty());
+    hub.advanceTime(200.0);
+    assert(hub.readPostedMessages<TextMessage>().size() == 1);
+    hub.clearPostedMessages();
+
+    //A delay posted from another thread is measured from when the hub syncs it
+    std::thread([&]() { hub.postMessageAfter<TextMessage>(1.0, t1, "Delayed"); }).join();
+    hub.advanceTime(0.5);
+    hub.syncMessages();
+
+    double dueTime = 0.0;
+    assert(hub.getNextScheduledTime(dueTime) && std::abs(dueTime - (hub.getTime() + 1.0)) < 1e-3);
+
+    std::cout << "Finished Testing Scheduled Messages\n";
+}
+
+void TEST_MAILBOXES()
+{
+    std::cout << "Testing Mailboxes\n";
+
+    MessageHub hub;
+
+    //Reading removes the messages
+    hub.sendPrivateMessage<TextMessage>(t2.getID(), t1, "One");
+    assert(hub.readPrivateMessages<TextMessage>(t2).size() == 1);
+    assert(hub.readPrivateMessages<TextMessage>(t2).empty());
+
+    hub.configureMailbox(t2, 3, OverflowPolicy::DropOldest);
+    for(int i = 0; i < 5; ++i)
+        assert(hub.sendPrivateMessage<Explosion>(t2.getID(), t1, i, i));
+
+    auto explosions = hub.readPrivateMessages<Explosion>(t2);
+    assert(explosions.size() == 3);
+    assert(explosions[0].radius == 2 && explosions[2].radius == 4);
+    assert(hub.getDroppedMessages(t2) == 2);
+
+    hub.configureMailbox(t3, 2, OverflowPolicy::DropNewest);
+    //A discarded new message still counts as sent
+    for(int i = 0; i < 4; ++i)
+        assert(hub.sendPrivateMessage<Explosion>(t3.getID(), t1, i, i));
+
+    explosions = hub.readPrivateMessages<Explosion>(t3);
+    assert(explosions.size() == 2);
+    assert(explosions[0].radius == 0 && explosions[1].radius == 1);
+    assert(hub.getDroppedMessages(t3) == 2);
+
+    hub.configureMailbox(t4, 1, OverflowPolicy::Reject);
+    assert(hub.sendPrivateMessage<TextMessage>(t4.getID(), t1, "Accepted"));
+    assert(!hub.sendPrivateMessage<TextMessage>(t4.getID(), t1, "Rejected"));
+    assert(hub.getDroppedMessages(t4) == 1);
+
+    //Each message type has its own ring
+    assert(hub.sendPrivateMessage<Explosion>(t4.getID(), t1, 1, 1));
+    assert(hub.readPrivateMessages<TextMessage>(t4)[0].msg == "Accepted");
+
+    //Space frees up once the mailbox is read
+    assert(hub.sendPrivateMessage<TextMessage>(t4.getID(), t1, "Again"));
+
+    //The ring wraps around without losing order
+    hub.setDefaultMailbox(4, OverflowPolicy::Reject);
+    Transceiver receiver;
+    for(int round = 0; round < 3; ++round)
+    {
+        for(int i = 0; i < 3; ++i)
+            assert(hub.sendPrivateMessage<Explosion>(receiver.getID(), t1, round * 3 + i, 0));
+
+        explosions = hub.readPrivateMessages<Explosion>(receiver);
+        assert(explosions.size() == 3);
+        for(int i = 0; i < 3; ++i)
+            assert(explosions[i].radius == round * 3 + i);
+    }
+
+    std::cout << "Finished Testing Mailboxes\n";
+}
+
+void TEST_DOUBLE_BUFFERED_BOARD()
+{
+    std::cout << "Testing Double-Buffered Board\n";
+
+    MessageHub hub;
+    hub.setDoubleBuffered(true);
+    assert(hub.isDoubleBuffered());
+
+    //Messages posted this frame are not visible until the next one
+    hub.postMessage<Explosion>(t1, 1, 1);
+    hub.postMessage<Explosion>(t1, 2, 2);
+    assert(hub.readPostedMessages<Explosion>().empty());
+
+    hub.advanceFrame();
+    assert(hub.readPostedMessages<Explosion>().size() == 2);
+
+    //Writers fill the next frame while readers still see the previous one
+    hub.postMessage<Explosion>(t1, 3, 3);
+    hub.postMessage<TextMessage>(t1, "Next");
+    assert(hub.readPostedMessages<Explosion>().size() == 2);
+    assert(hub.readPostedMessages<Explosion>()[1].radius == 2);
+    assert(hub.readPostedMessages<TextMessage>().empty());
+
+    hub.advanceFrame();
+    assert(hub.readPostedMessages<Explosion>().size() == 1);
+    assert(hub.readPostedMessages<Explosion>()[0].radius == 3);
+    assert(hub.readPostedMessages<TextMessage>().size() == 1);
+
+    //A frame with no posts leaves nothing to read
+    hub.advanceFrame();
+    hub.advanceFrame();
+    assert(hub.readPostedMessages<Explosion>().empty());
+    assert(hub.readPostedMessages<TextMessage>().empty());
+
+    //Switching back to a single board reads messages as soon as they are posted
+    hub.postMessage<Explosion>(t1, 4, 4);
+    hub.setDoubleBuffered(false);
+    assert(hub.readPostedMessages<Explosion>().empty());
+    hub.postMessage<Explosion>(t1, 5, 5);
+    assert(hub.readPostedMessages<Explosion>().size() == 1);
+
+    std::cout << "Finished Testing Double-Buffered Board\n";
+}
+
+//Only posted from worker threads, so its family is first assigned off the main thread
+struct WorkerMessage : public Message<WorkerMessage>
+{
+    WorkerMessage(const Transceiver& transceiver, int _thread, int _index) : Message(transceiver), thread(_thread), index(_index) {}
+
+    int thread;
+    int index;
+};
+
+void TEST_MULTITHREADED_POSTING()
+{
+    std::cout << "Testing Multithreaded Posting\n";
+
+    const int totalThreads = 4;
+    const int messagesPerThread = 50000;
+
+    MessageHub hub;
+    int immediateCalls = 0;
+    hub.subscribe<WorkerMessage>(t1, [&](const WorkerMessage&) { ++immediateCalls; }, DispatchMode::Immediate);
+
+    std::atomic<int> finished(0);
+    std::vector<std::thread> threads;
+    std::vector<ID> transceiverIDs(totalThreads);
+
+    for(int t = 0; t < totalThreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            Transceiver sender;
+            transceiverIDs[t] = sender.getID();
+
+            for(int i = 0; i < messagesPerThread; ++i)
+            {
+                hub.postMessage<WorkerMessage>(sender, t, i);
+                if(i % 1000 == 0)
+                    hub.sendPrivateMessage<TextMessage>(t2.getID(), sender, "Progress");
+            }
+
+            ++finished;
+        });
+    }
+
+    //Merge while the workers are still posting
+    std::size_t merged = 0;
+    while(finished < totalThreads)
+        merged += hub.syncMessages();
+
+    for(auto& thread : threads)
+        thread.join();
+
+    merged += hub.syncMessages();
+    assert(merged == totalThreads * (messagesPerThread + messagesPerThread / 1000));
+
+    //Every message arrives once, and each thread's messages keep their order
+    auto messages = hub.readPostedMessages<WorkerMessage>();
+    assert(messages.size() == totalThreads * messagesPerThread);
+    assert(immediateCalls == totalThreads * messagesPerThread);
+
+    std::vector<int> nextIndex(totalThreads, 0);
+    for(std::size_t i = 0; i < messages.size(); ++i)
+    {
+        assert(messages[i].index == nextIndex[messages[i].thread]++);
+        assert(messages[i].getSender() == transceiverIDs[messages[i].thread]);
+        assert(i == 0 || messages[i].getMetadata().sequence > messages[i - 1].getMetadata().sequence);
+    }
+
+    assert(hub.readPrivateMessages<TextMessage>(t2).size() == totalThreads * messagesPerThread / 1000);
+
+    //Transceiver ids stay unique when handed out from several threads
+    assert(std::set<ID>(transceiverIDs.begin(), transceiverIDs.end()).size() == totalThreads);
+
+    //Queued messages are synced in order of their sort keys, not the order the threads first posted
+    MessageHub orderedHub;
+    std::thread([&]() { MessageQueue::setSortKey(1); orderedHub.postMessage<TextMessage>(t1, "Second"); }).join();
+    std::thread([&]() { MessageQueue::setSortKey(0); orderedHub.postMessage<TextMessage>(t1, "First"); }).join();
+
+    assert(orderedHub.syncMessages() == 2);
+    auto texts = orderedHub.readPostedMessages<TextMessage>();
+    assert(texts[0].msg == "First" && texts[1].msg == "Second");
+
+    std::cout << "Finished Testing Multithreaded Posting\n";
+}
+
+void TEST_WAITING_FOR_MESSAGES()
+{
+    std::cout << "Testing Waiting For Messages\n";
+
+    MessageHub hub;
+
+    //Nothing arrives, so the wait times out
+    assert(!hub.waitForMessages(0.01));
+
+    //A message posted from another thread wakes the hub's thread and is synced
+    std::thread poster([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        hub.postMessage<TextMessage>(t1, "Wake up");
+    });
+
+    hub.waitForMessages();
+    poster.join();
+    assert(hub.readPostedMessages<TextMessage>().size() == 1);
+
+    //Messages queued before waiting are returned right away
+    std::thread(([&]() { hub.postMessage<TextMessage>(t1, "Early"); })).join();
+    assert(hub.waitForMessages(10.0));
+    assert(hub.readPostedMessages<TextMessage>().size() == 2);
+
+    std::thread waker([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        hub.wake();
+    });
+
+    assert(hub.waitForMessages(10.0));
+    waker.join();
+
+    //The earliest scheduled message is found even if it was scheduled after a later one
+    double dueTime = 0.0;
+    assert(!hub.getNextScheduledTime(dueTime));
+    hub.postMessageAfter<TextMessage>(2.0, t1, "Later");
+    hub.advanceTime(0.5);
+    hub.postMessageAfter<TextMessage>(1.0, t1, "Sooner");
+    assert(hub.getNextScheduledTime(dueTime) && std::abs(dueTime - 1.5) < 1e-6);
+
+    //Once the earliest fires, the next one is found
+    hub.advanceTime(1.0);
+    assert(hub.getNextScheduledTime(dueTime) && std::abs(dueTime - 2.0) < 1e-6);
+    hub.advanceTime(1.0);
+    assert(!hub.getNextScheduledTime(dueTime));
+
+    std::cout << "Finished Testing Waiting For Messages\n";
+}
 
 }//msgtest
 
@@ -86,6 +975,19 @@ int testMessageHub()
     std::cout << "\nTesting Messaging\n";
     msgtest::TEST_MESSAGE_POSTING();
     msgtest::TEST_MESSAGE_PM();
+    msgtest::TEST_MESSAGE_SLOTS();
+    msgtest::TEST_MESSAGE_METADATA();
+    msgtest::TEST_MESSAGE_SUBSCRIPTIONS();
+    msgtest::TEST_COALESCED_MESSAGES();
+    msgtest::TEST_TOPIC_MESSAGES();
+    msgtest::TEST_MESSAGE_RECORDING();
+    msgtest::TEST_SHARED_MESSAGE_TRANSPORT();
+    msgtest::TEST_MESSAGE_STATISTICS();
+    msgtest::TEST_SCHEDULED_MESSAGES();
+    msgtest::TEST_MAILBOXES();
+    msgtest::TEST_DOUBLE_BUFFERED_BOARD();
+    msgtest::TEST_MULTITHREADED_POSTING();
+    msgtest::TEST_WAITING_FOR_MESSAGES();
     std::cout << "Finished Testing Messaging\n";
 
     return 0;
@@ -25,6 +25,8 @@ freely, subject to the following restrictions:
 #include <cassert>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <OCS/OCS.hpp>
 
@@ -234,6 +236,117 @@ void TEST_COMPONENT_REMOVING()
     std::cout << "Finished testing removing components\n";
 }
 
+void TEST_OBJECT_QUERIES()
+{
+    std::cout << "Testing object queries\n";
+
+    ID moving = objManager.createObject(Position(), Motion());
+    ID named = objManager.createObject(Position(), Motion(), Name("Named"));
+    ID still = objManager.createObject(Position());
+
+    auto ids = objManager.getObjects("Position & Motion");
+    assert((ids.size() == 2 && objManager.hasComponents<Position, Motion>(ids[0])));
+
+    ids = objManager.getObjects("Position&Motion & !Name");
+    assert((ids.size() == 1 && ids[0] == moving));
+
+    ids = objManager.getObjects("!Motion");
+    assert((ids.size() == 1 && ids[0] == still));
+
+    //Masks follow components as they are added and removed
+    objManager.removeComponents<Name>(named);
+    objManager.addComponents(still, Name("Still"));
+    ids = objManager.getObjects("Position & Motion & !Name");
+    assert(ids.size() == 2);
+    assert(objManager.getObjects("Name").size() == 1);
+    assert((objManager.getObjects<Position, Name>().size() == 1));
+
+    ObjectQuery query;
+    assert(objManager.compileQuery("Position & !Collidable", query));
+    assert(objManager.getObjects(query).size() == 3);
+
+    //Malformed queries and unbound names are rejected
+    assert(!objManager.compileQuery("Position Motion", query));
+    assert(!objManager.compileQuery("Position & ", query));
+    assert(!objManager.compileQuery("Unbound", query));
+    assert(objManager.getObjects("Position & Unbound").empty());
+
+    //Parallel systems may look up new query strings at the same time
+    std::vector<std::thread> threads;
+    std::vector<std::size_t> matched(4, 0);
+    for(std::size_t t = 0; t < matched.size(); ++t)
+        threads.emplace_back([&matched, t]()
+        {
+            for(int i = 0; i < 50; ++i)
+                matched[t] += objManager.getObjects("Motion & !Collidable" + std::string(i % (t + 2), ' ')).size();
+        });
+    for(auto& thread : threads)
+        thread.join();
+    for(auto total : matched)
+        assert(total == 50 * 2);
+
+    objManager.destroyAllObjects();
+    assert(objManager.getObjects("Position").empty());
+
+    std::cout << "Finished testing object queries\n";
+}
+
+void TEST_TRACKED_QUERIES()
+{
+    std::cout << "Testing tracked queries\n";
+
+    ID moving = objManager.createObject(Position(), Motion());
+
+    ObjectQuery query;
+    query.require({Position::getFamily(), Motion::getFamily()});
+    query.forbid({Name::getFamily()});
+
+    //Existing objects are found when the query is first tracked
+    TrackedQuery& tracked = objManager.trackQuery(query);
+    assert(tracked.size() == 1 && tracked.contains(moving));
+
+    //Identical queries share a set
+    assert(&objManager.trackQuery(query) == &tracked);
+
+    ID other = objManager.createObject(Position());
+    assert(!tracked.contains(other));
+
+    objManager.addComponents(other, Motion());
+    assert(tracked.size() == 2 && tracked.contains(other));
+
+    objManager.addComponents(moving, Name("Moving"));
+    assert(tracked.size() == 1 && !tracked.contains(moving) && tracked.getObjects()[0] == other);
+
+    objManager.removeComponents<Name>(moving);
+    assert(tracked.contains(moving));
+
+    //Objects copied from prototypes are added too
+    ID copy = objManager.createObject("Test3");
+    assert(tracked.contains(copy) && tracked.size() == 3);
+
+    objManager.removeAllComponents(other);
+    assert(!tracked.contains(other));
+
+    objManager.destroyObject(moving);
+    assert(!tracked.contains(moving) && tracked.size() == 1 && tracked.contains(copy));
+
+    //Queries that only exclude components match blank objects
+    ObjectQuery unnamed;
+    unnamed.forbid({Name::getFamily()});
+    TrackedQuery& trackedUnnamed = objManager.trackQuery(unnamed);
+    ID blank = objManager.createObject();
+    assert(trackedUnnamed.contains(blank));
+    objManager.releaseQuery(trackedUnnamed);
+
+    objManager.destroyAllObjects();
+    assert(tracked.empty());
+
+    objManager.releaseQuery(tracked);
+    objManager.releaseQuery(tracked);
+
+    std::cout << "Finished testing tracked queries\n";
+}
+
 }//objtest
 
 int testObjectManager()
@@ -246,6 +359,8 @@ int testObjectManager()
     objtest::TEST_COMPONENT_MODIFYING();
     objtest::TEST_COMPONENT_REMOVING();
     objtest::TEST_OBJECT_DESTRUCTION();
+    objtest::TEST_OBJECT_QUERIES();
+    objtest::TEST_TRACKED_QUERIES();
     std::cout << "Finished testing ObjectManager\n";
 
     return 0;
@@ -36,6 +36,9 @@ struct Position : public ocs::Component<Position>
     std::string serialize() { return serializer.serialize("Position % %", x, y); }
     void deSerialize(const std::string& str) { serializer.deSerialize("% %", str, x, y); }
 
+    void writeBinary(BinaryWriter& out) { out.write(x); out.write(y); }
+    bool readBinary(BinaryReader& in) { return in.read(x) && in.read(y); }
+
     float x, y;
 };
 
@@ -47,6 +50,9 @@ struct Motion : public ocs::Component<Motion>
     std::string serialize() { return serializer.serialize("Motion % %", speed, angle);}
     void deSerialize(const std::string& str) { serializer.deSerialize("% %", str, speed, angle); }
 
+    void writeBinary(BinaryWriter& out) { out.write(speed); out.write(angle); }
+    bool readBinary(BinaryReader& in) { return in.read(speed) && in.read(angle); }
+
     float speed, angle;
 };
 
@@ -57,6 +63,9 @@ struct Name : public ocs::Component<Name>
     std::string serialize() { return "Name " + name; }
     void deSerialize(const std::string& str) { name = str; }
 
+    void writeBinary(BinaryWriter& out) { out.writeString(name); }
+    bool readBinary(BinaryReader& in) { return in.readString(name); }
+
     std::string name;
 };
 
@@ -68,6 +77,9 @@ struct Collidable : public ocs::Component<Collidable>
     std::string serialize() { return serializer.serialize("Collidable % % % %", top, left, width, height); }
     void deSerialize(const std::string& str) { serializer.deSerialize("% % % %", str, top, left, width, height); }
 
+    void writeBinary(BinaryWriter& out) { out.write(top); out.write(left); out.write(width); out.write(height); }
+    bool readBinary(BinaryReader& in) { return in.read(top) && in.read(left) && in.read(width) && in.read(height); }
+
     float top, left, width, height;
 };
 
@@ -22,11 +22,16 @@ freely, subject to the following restrictions:
 
 #include "OCS/Messaging/Message.hpp"
 #include "OCS/Messaging/Transceiver.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
 
 struct TextMessage : public ocs::Message<TextMessage>
 {
     TextMessage(const ocs::Transceiver& transceiver, std::string _msg) : Message(transceiver), msg(_msg) {}
 
+    //Optional, for recording
+    TextMessage(const ocs::Transceiver& transceiver, BinaryReader& in) : Message(transceiver) { in.readString(msg); }
+    void writeBinary(BinaryWriter& out) const { out.writeString(msg); }
+
     //Optional
     void log(std::ostream& out)
     {
@@ -44,6 +49,10 @@ struct Explosion : public ocs::Message<Explosion>
     Explosion(const ocs::Transceiver& transceiver, int _radius, int _damage) : Message(transceiver),
                         radius(_radius), damage(_damage) {}
 
+    //Optional, for recording
+    Explosion(const ocs::Transceiver& transceiver, BinaryReader& in) : Message(transceiver), radius(0), damage(0) { in.read(radius); in.read(damage); }
+    void writeBinary(BinaryWriter& out) const { out.write(radius); out.write(damage); }
+
     //Optional
     void log(std::ostream& out)
     {
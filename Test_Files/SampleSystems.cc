@@ -28,22 +28,30 @@ freely, subject to the following restrictions:
 #include <cmath>
 #include <iostream>
 
+MovementSystem::MovementSystem()
+{
+    readsComponents<Motion>();
+    writesComponents<Position>();
+    requiresComponents<Position, Motion>();
+}
+
 void MovementSystem::update(ocs::ObjectManager& objManager, ocs::MessageHub& msgHub, double dt)
 {
-    for(auto& motion : objManager.getComponentArray<Motion>())
+    for(auto objectID : getMatchingObjects())
     {
-        auto objectID = motion.getOwnerID();
+        auto motion = objManager.getComponent<Motion>(objectID);
         auto pos = objManager.getComponent<Position>(objectID);
 
-        if(pos)
-        {
-            pos->x += cos(motion.angle) * motion.speed * dt;
-            pos->y += sin(motion.angle) * motion.speed * dt;
-        }
-
+        pos->x += cos(motion->angle) * motion->speed * dt;
+        pos->y += sin(motion->angle) * motion->speed * dt;
     }
 }
 
+NameDisplayer::NameDisplayer()
+{
+    readsComponents<Name>();
+}
+
 void NameDisplayer::update(ocs::ObjectManager& objManager, ocs::MessageHub& msgHub, double dt)
 {
     for(const auto& name : objManager.getComponentArray<Name>())
@@ -27,11 +27,13 @@ freely, subject to the following restrictions:
 
 struct MovementSystem : public ocs::System
 {
+    MovementSystem();
     void update(ocs::ObjectManager&, ocs::MessageHub&, double);
 };
 
 struct NameDisplayer : public ocs::System
 {
+    NameDisplayer();
     void update(ocs::ObjectManager&, ocs::MessageHub&, double);
 };
 
@@ -21,10 +21,18 @@ freely, subject to the following restrictions:
 */
 
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <OCS/OCS.hpp>
+#include <SampleComponents.hpp>
+#include <SampleMessages.hpp>
 #include <SampleSystems.hpp>
 
 using namespace ocs;
@@ -106,6 +114,807 @@ void TEST_REMOVE_SYSTEM()
     std::cout << "Finished Testing Removing Systems\n";
 }
 
+//The order parallel systems ran in, and which of them were running together
+std::atomic<int> updateCounter(0);
+std::atomic<int> waitingSystems(0);
+int updateOrder[6];
+bool ranTogether[6];
+
+//Wait a while for the other system in a pair to start, which only happens if both are running at once
+void meetOtherSystem(int index)
+{
+    ++waitingSystems;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(waitingSystems.load() < 2 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    ranTogether[index] = (waitingSystems.load() >= 2);
+}
+
+struct WritePosition : public System
+{
+    WritePosition() { writesComponents<Position>(); }
+    void update(ObjectManager&, MessageHub&, double) { updateOrder[0] = updateCounter++; meetOtherSystem(0); }
+};
+
+struct WriteName : public System
+{
+    WriteName() { writesComponents<Name>(); }
+    void update(ObjectManager&, MessageHub&, double) { updateOrder[1] = updateCounter++; meetOtherSystem(1); }
+};
+
+struct ReadPosition : public System
+{
+    ReadPosition() { readsComponents<Position>(); producesMessages<TextMessage>(); }
+
+    void update(ObjectManager&, MessageHub& hub, double)
+    {
+        updateOrder[2] = updateCounter++;
+        hub.postMessage<TextMessage>(*this, "Position read");
+    }
+};
+
+struct ReadText : public System
+{
+    ReadText() { consumesMessages<TextMessage>(); }
+
+    void update(ObjectManager&, MessageHub& hub, double)
+    {
+        updateOrder[3] = updateCounter++;
+        textsRead = hub.readPostedMessages<TextMessage>().size();
+    }
+
+    std::size_t textsRead = 0;
+};
+
+struct Undeclared : public System
+{
+    void update(ObjectManager&, MessageHub&, double) { updateOrder[4] = updateCounter++; }
+};
+
+struct WriteMotion : public System
+{
+    WriteMotion() { writesComponents<Motion>(); }
+    void update(ObjectManager&, MessageHub&, double) { updateOrder[5] = updateCounter++; }
+};
+
+//Declares nothing, and checks it behaves as if the systems were updated in order
+struct UndeclaredPoster : public System
+{
+    void update(ObjectManager&, MessageHub& hub, double)
+    {
+        updateThread = std::this_thread::get_id();
+        hub.postMessage<TextMessage>(*this, "Undeclared");
+        sawOwnPost = hub.readPostedMessages<TextMessage>().size() > 0;
+    }
+
+    static std::thread::id updateThread;
+    static bool sawOwnPost;
+};
+
+std::thread::id UndeclaredPoster::updateThread;
+bool UndeclaredPoster::sawOwnPost = false;
+
+void TEST_PARALLEL_SYSTEMS()
+{
+    std::cout << "Testing Parallel Systems\n";
+
+    ObjectManager parallelObjects;
+    MessageHub parallelHub;
+    SystemManager parallelSystems(parallelObjects, parallelHub);
+    JobSystem jobs(2);
+
+    parallelSystems.setJobSystem(&jobs);
+    parallelSystems.addSystem<WritePosition>();
+    parallelSystems.addSystem<WriteName>();
+    parallelSystems.addSystem<ReadPosition>();
+    parallelSystems.addSystem<ReadText>();
+    parallelSystems.addSystem<Undeclared>();
+    parallelSystems.addSystem<WriteMotion>();
+
+    for(int frame = 0; frame < 3; ++frame)
+    {
+        updateCounter = 0;
+        waitingSystems = 0;
+
+        parallelSystems.updateAllSystems(1.0 / 60.0);
+
+        //Systems that do not conflict run together
+        assert(ranTogether[0] && ranTogether[1]);
+
+        //Conflicting systems keep the order they were added in
+        assert(updateOrder[2] > updateOrder[0]);
+        assert(updateOrder[3] > updateOrder[2]);
+
+        //Undeclared systems run on their own
+        for(int i = 0; i < 6; ++i)
+            if(i != 4)
+                assert((i < 4) == (updateOrder[i] < updateOrder[4]));
+
+        parallelHub.clearPostedMessages();
+    }
+
+    //The consumer saw the message posted by the producer in the same update
+    parallelSystems.removeSystem<Undeclared>();
+    parallelSystems.updateAllSystems(1.0 / 60.0);
+    assert(parallelHub.readPostedMessages<TextMessage>().size() == 1);
+
+    //The sample systems can run in parallel too
+    parallelSystems.addSystem<MovementSystem>();
+    ID object = parallelObjects.createObject();
+    parallelObjects.addComponents(object, Position(0, 0), Motion(60, 0));
+    parallelSystems.updateAllSystems(1.0 / 60.0);
+    assert(parallelObjects.getComponent<Position>(object)->x > 0.9);
+
+    //Undeclared systems stay on the updating thread, where posts are immediate
+    int immediateCalls = 0;
+    Transceiver listener;
+    parallelHub.subscribe<TextMessage>(listener, [&](const TextMessage&) { ++immediateCalls; }, DispatchMode::Immediate);
+    parallelSystems.addSystem<UndeclaredPoster>();
+
+    for(int frame = 0; frame < 20; ++frame)
+    {
+        UndeclaredPoster::sawOwnPost = false;
+        immediateCalls = 0;
+        parallelSystems.updateAllSystems(1.0 / 60.0);
+
+        assert(UndeclaredPoster::updateThread == std::this_thread::get_id());
+        assert(UndeclaredPoster::sawOwnPost);
+        assert(immediateCalls == 2);
+        parallelHub.clearPostedMessages();
+    }
+
+    std::cout << "Finished Testing Parallel Systems\n";
+}
+
+//Posts a text message naming the system
+template<char N>
+struct NamedPoster : public System
+{
+    NamedPoster() { producesMessages<TextMessage>(); }
+    void update(ObjectManager&, MessageHub& hub, double) { hub.postMessage<TextMessage>(*this, std::string(1, N)); }
+};
+
+void TEST_PARALLEL_MESSAGE_ORDER()
+{
+    std::cout << "Testing Parallel Message Order\n";
+
+    ObjectManager orderObjects;
+    MessageHub orderHub;
+    SystemManager orderSystems(orderObjects, orderHub);
+    JobSystem jobs(3);
+
+    orderSystems.setJobSystem(&jobs);
+    orderSystems.addSystem<NamedPoster<'A'>>();
+    orderSystems.addSystem<WriteMotion>();
+    orderSystems.addSystem<NamedPoster<'B'>>();
+
+    //Messages reach the board in the order their systems were added, whichever threads ran them
+    for(int frame = 0; frame < 50; ++frame)
+    {
+        orderSystems.updateAllSystems(1.0 / 60.0);
+
+        auto texts = orderHub.readPostedMessages<TextMessage>();
+        assert(texts.size() == 2);
+        assert(texts[0].msg == "A" && texts[1].msg == "B");
+
+        orderHub.clearPostedMessages();
+    }
+
+    std::cout << "Finished Testing Parallel Message Order\n";
+}
+
+//Moves every position in parallel pieces
+struct ParallelMovement : public System
+{
+    ParallelMovement() { writesComponents<Position>(); }
+
+    void update(ObjectManager& objManager, MessageHub&, JobSystem& jobs, double dt)
+    {
+        auto& positions = objManager.getComponentArray<Position>();
+
+        jobs.parallelFor(0, positions.size(), 16, [&](std::size_t begin, std::size_t end)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+                positions[i].x += dt;
+        });
+    }
+};
+
+void TEST_JOB_SYSTEM()
+{
+    std::cout << "Testing Job System\n";
+
+    for(unsigned int totalWorkers : {0u, 3u})
+    {
+        JobSystem jobs(totalWorkers);
+        assert(jobs.getTotalWorkers() == totalWorkers);
+
+        //Counters track groups of jobs
+        std::atomic<int> total(0);
+        JobCounter counter;
+        for(int i = 0; i < 100; ++i)
+            jobs.submit(counter, [&total]() { ++total; });
+        jobs.wait(counter);
+        assert(counter.isDone() && total == 100);
+
+        //Nested parallel loops finish without extra threads, as waiting threads run queued jobs
+        std::vector<int> values(10000, 0);
+        jobs.parallelFor(0, 100, 1, [&](std::size_t begin, std::size_t end)
+        {
+            for(std::size_t row = begin; row < end; ++row)
+                jobs.parallelFor(row * 100, (row + 1) * 100, 10, [&](std::size_t first, std::size_t last)
+                {
+                    for(std::size_t i = first; i < last; ++i)
+                        ++values[i];
+                });
+        });
+        assert(std::count(values.begin(), values.end(), 1) == 10000);
+
+        //Jobs record commands with the sort key of the thread that queued them
+        CommandBuffer::setSortKey(7);
+        JobCounter keyCounter;
+        std::atomic<uint64_t> jobKey(0);
+        jobs.submit(keyCounter, [&jobKey]() { jobKey = CommandBuffer::getSortKey(); });
+        jobs.wait(keyCounter);
+        assert(jobKey == 7);
+        CommandBuffer::setSortKey(0);
+
+        //Each piece of a parallel loop records with its own key, so objects are created in piece order
+        ObjectManager pieceObjects;
+        for(int frame = 0; frame < 20; ++frame)
+        {
+            jobs.parallelFor(0, 4, 1, [&](std::size_t begin, std::size_t end)
+            {
+                auto& commands = pieceObjects.getCommandBuffer();
+                for(std::size_t i = begin; i < end; ++i)
+                    commands.addComponents(commands.createObject(), Position(i, 0));
+            });
+
+            //The caller's own commands come after the pieces'
+            auto& commands = pieceObjects.getCommandBuffer();
+            commands.addComponents(commands.createObject(), Position(4, 0));
+            pieceObjects.applyDeferredCommands();
+
+            auto created = pieceObjects.getObjects<Position>();
+            std::sort(created.begin(), created.end());
+            for(std::size_t i = 0; i < created.size(); ++i)
+                assert(pieceObjects.getComponent<Position>(created[i])->x == i);
+
+            pieceObjects.destroyAllObjects();
+            CommandBuffer::setSortKey(0);
+        }
+    }
+
+    //Systems get the job system from their manager
+    ObjectManager jobObjects;
+    MessageHub jobHub;
+    SystemManager jobSystems(jobObjects, jobHub);
+    JobSystem jobs(2);
+
+    std::vector<ID> objects;
+    for(int i = 0; i < 100; ++i)
+    {
+        objects.push_back(jobObjects.createObject());
+        jobObjects.addComponents(objects.back(), Position(0, 0));
+    }
+
+    jobSystems.addSystem<ParallelMovement>();
+    jobSystems.updateAllSystems(1.0);
+
+    jobSystems.setJobSystem(&jobs);
+    assert(&jobSystems.getJobSystem() == &jobs);
+    jobSystems.updateAllSystems(1.0);
+
+    for(auto objectID : objects)
+        assert(jobObjects.getComponent<Position>(objectID)->x == 2.0f);
+
+    std::cout << "Finished Testing Job System\n";
+}
+
+//Counts its updates and the time it was given
+template<int N>
+struct RateSystem : public System
+{
+    RateSystem() { readsComponents<Name>(); }
+
+    void update(ObjectManager&, MessageHub&, double dt)
+    {
+        ticks.push_back(updateTick);
+        totalTime += dt;
+    }
+
+    static std::vector<int> ticks;
+    static double totalTime;
+    static int updateTick;
+};
+
+template<int N> std::vector<int> RateSystem<N>::ticks;
+template<int N> double RateSystem<N>::totalTime = 0.0;
+template<int N> int RateSystem<N>::updateTick = 0;
+
+template<int N>
+void resetRateSystem()
+{
+    RateSystem<N>::ticks.clear();
+    RateSystem<N>::totalTime = 0.0;
+}
+
+struct FixedStepState : public State
+{
+    void configure() {}
+    void initialize() {}
+    void update(double dt) { ++updates; simulatedTime += dt; }
+
+    int updates = 0;
+    double simulatedTime = 0.0;
+};
+
+void TEST_UPDATE_RATES()
+{
+    std::cout << "Testing Update Rates\n";
+
+    JobSystem jobs(2);
+
+    for(JobSystem* jobSystem : {static_cast<JobSystem*>(nullptr), &jobs})
+    {
+        ObjectManager rateObjects;
+        MessageHub rateHub;
+        SystemManager rateSystems(rateObjects, rateHub);
+        rateSystems.setJobSystem(jobSystem);
+
+        rateSystems.addSystem<RateSystem<0>>();
+        rateSystems.addSystem<RateSystem<1>>();
+        rateSystems.addSystem<RateSystem<2>>();
+        rateSystems.addSystem<RateSystem<3>>();
+        resetRateSystem<0>();
+        resetRateSystem<1>();
+        resetRateSystem<2>();
+        resetRateSystem<3>();
+
+        rateSystems.setRateDivisor<RateSystem<1>>(3);
+        rateSystems.setRateDivisor<RateSystem<2>>(3);
+        rateSystems.setRateDivisor<RateSystem<3>>(6);
+
+        for(int tick = 0; tick < 12; ++tick)
+        {
+            RateSystem<0>::updateTick = RateSystem<1>::updateTick = RateSystem<2>::updateTick = RateSystem<3>::updateTick = tick;
+            rateSystems.updateAllSystems(0.1);
+        }
+
+        assert(rateSystems.getTick() == 12);
+        assert(RateSystem<0>::ticks.size() == 12);
+        assert(RateSystem<1>::ticks.size() == 4 && RateSystem<2>::ticks.size() == 4 && RateSystem<3>::ticks.size() == 2);
+
+        //Systems with a divisor are spread over different ticks
+        assert(RateSystem<1>::ticks[0] == 0);
+        assert(RateSystem<2>::ticks[0] == 1);
+        assert(RateSystem<3>::ticks[0] == 2);
+        assert(RateSystem<1>::ticks[1] == 3 && RateSystem<3>::ticks[1] == 8);
+
+        //Slower systems are given the time since they last updated
+        assert(std::abs(RateSystem<0>::totalTime - 1.2) < 1e-9);
+        assert(std::abs(RateSystem<1>::totalTime - 1.0) < 1e-9);
+        assert(std::abs(RateSystem<2>::totalTime - 1.1) < 1e-9);
+    }
+
+    FixedStepState state;
+    state.setFixedTimestep(0.01, 4);
+
+    state.advance(0.025);
+    assert(state.updates == 2);
+    assert(std::abs(state.getInterpolationAlpha() - 0.5) < 1e-6);
+
+    state.advance(0.005);
+    assert(state.updates == 3);
+
+    //Only four steps are run to catch up after a long frame
+    state.advance(1.0);
+    assert(state.updates == 7);
+    assert(std::abs(state.simulatedTime - 0.07) < 1e-9);
+
+    state.setFixedTimestep(0.0);
+    state.advance(0.5);
+    assert(state.updates == 8);
+
+    std::cout << "Finished Testing Update Rates\n";
+}
+
+struct SlowSystem : public System
+{
+    void update(ObjectManager&, MessageHub&, double)
+    {
+        lastID = getID();
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+
+    static ID lastID;
+};
+
+ID SlowSystem::lastID = 0;
+
+void TEST_SYSTEM_TIMINGS()
+{
+    std::cout << "Testing System Timings\n";
+
+    SystemTimings timings;
+    for(int i = 1; i <= 200; ++i)
+        timings.record(i * 0.001);
+
+    //Only the last 128 samples are kept
+    SystemTimingStats stats = timings.getStats();
+    assert(stats.samples == SystemTimings::windowSize);
+    assert(std::abs(stats.last - 0.2) < 1e-9);
+    assert(std::abs(stats.max - 0.2) < 1e-9);
+    assert(std::abs(stats.p50 - 0.136) < 1e-9);
+    assert(std::abs(stats.mean - 0.1365) < 1e-9);
+    assert(stats.p99 > stats.p50 && stats.p99 <= stats.max);
+
+    JobSystem jobs(2);
+
+    for(JobSystem* jobSystem : {static_cast<JobSystem*>(nullptr), &jobs})
+    {
+        ObjectManager timedObjects;
+        MessageHub timedHub;
+        SystemManager timedSystems(timedObjects, timedHub);
+        timedSystems.setJobSystem(jobSystem);
+
+        timedSystems.addSystem<SlowSystem>();
+        timedSystems.addSystem<RateSystem<4>>();
+        timedSystems.setTimeBudget<SlowSystem>(0.001);
+
+        timedSystems.updateAllSystems(0.1);
+
+        auto overBudget = timedHub.readPostedMessages<SystemOverBudget>();
+        assert(overBudget.size() == 1);
+        assert(overBudget.begin()->getSender() == SlowSystem::lastID);
+        assert(overBudget.begin()->elapsed >= 0.003 && overBudget.begin()->budget == 0.001);
+
+        timedHub.clearPostedMessages();
+        timedSystems.updateAllSystems(0.1);
+
+        SystemTimingStats slowStats = timedSystems.getTimingStats<SlowSystem>();
+        assert(slowStats.samples == 2 && slowStats.p50 >= 0.003 && slowStats.max >= slowStats.p50);
+        assert(slowStats.timesOverBudget == 2);
+        assert(timedSystems.getTimingStats<RateSystem<4>>().samples == 2);
+
+        //Removing the budget stops the messages
+        timedHub.clearPostedMessages();
+        timedSystems.setTimeBudget<SlowSystem>(0.0);
+        timedSystems.updateAllSystems(0.1);
+        assert(timedHub.readPostedMessages<SystemOverBudget>().size() == 0);
+    }
+
+    std::cout << "Finished Testing System Timings\n";
+}
+
+static std::vector<int> phaseOrder;
+
+struct SpawnSystem : public System
+{
+    SpawnSystem() { producesMessages<Explosion>(); }
+
+    void update(ObjectManager& objManager, MessageHub& hub, double)
+    {
+        phaseOrder.push_back(0);
+
+        auto& commands = objManager.getCommandBuffer();
+        commands.addComponents(commands.createObject(), Position(1, 2));
+        hub.postMessage<Explosion>(*this, 1, 2);
+    }
+};
+
+struct SpawnCounter : public System
+{
+    SpawnCounter() { consumesMessages<Explosion>(); }
+
+    void update(ObjectManager& objManager, MessageHub& hub, double)
+    {
+        phaseOrder.push_back(1);
+
+        lastSeen.first = objManager.getObjects().size();
+        lastSeen.second = hub.readPostedMessages<Explosion>().size();
+    }
+
+    //The number of objects and explosions seen in the last update
+    static std::pair<std::size_t, std::size_t> lastSeen;
+};
+
+std::pair<std::size_t, std::size_t> SpawnCounter::lastSeen;
+
+struct CommitSystem : public System
+{
+    void update(ObjectManager&, MessageHub&, double) { phaseOrder.push_back(2); }
+};
+
+void TEST_SYSTEM_PHASES()
+{
+    std::cout << "Testing System Phases\n";
+
+    JobSystem jobs(2);
+
+    for(JobSystem* jobSystem : {static_cast<JobSystem*>(nullptr), &jobs})
+    {
+        ObjectManager phaseObjects;
+        MessageHub phaseHub;
+        SystemManager phaseSystems(phaseObjects, phaseHub);
+        phaseSystems.setJobSystem(jobSystem);
+
+        //Systems run by phase, not by the order they were added in
+        phaseSystems.addSystem<CommitSystem>(SystemPhase::Commit);
+        phaseSystems.addSystem<SpawnCounter>();
+        phaseSystems.addSystem<SpawnSystem>(SystemPhase::PreUpdate);
+
+        for(std::size_t frame = 1; frame <= 2; ++frame)
+        {
+            phaseOrder.clear();
+            phaseSystems.updateAllSystems(0.1);
+
+            assert((phaseOrder == std::vector<int>{0, 1, 2}));
+
+            //The next phase sees the objects and messages from the one before it
+            assert(SpawnCounter::lastSeen.first == frame);
+            assert(SpawnCounter::lastSeen.second == 1);
+
+            phaseHub.clearPostedMessages();
+        }
+
+        assert(phaseObjects.getObjects().size() == 2);
+    }
+
+    std::cout << "Finished Testing System Phases\n";
+}
+
+struct MovingObjectCounter : public System
+{
+    MovingObjectCounter()
+    {
+        readsComponents<Position, Motion>();
+        requiresComponents<Position, Motion>();
+        excludesComponents<Collidable>();
+    }
+
+    void update(ObjectManager&, MessageHub&, double dt)
+    {
+        ++updates;
+        objectsSeen = getMatchingObjects().size();
+        lastDt = dt;
+    }
+
+    static int updates;
+    static std::size_t objectsSeen;
+    static double lastDt;
+};
+
+int MovingObjectCounter::updates = 0;
+std::size_t MovingObjectCounter::objectsSeen = 0;
+double MovingObjectCounter::lastDt = 0.0;
+
+//Creates a moving object through its command buffer on its first update
+struct MovingObjectSpawner : public System
+{
+    MovingObjectSpawner() { writesComponents<Position, Motion>(); }
+
+    void update(ObjectManager& objManager, MessageHub&, double)
+    {
+        if(spawned)
+            return;
+
+        auto& commands = objManager.getCommandBuffer();
+        commands.addComponents(commands.createObject(), Position(), Motion());
+        spawned = true;
+    }
+
+    bool spawned = false;
+};
+
+void TEST_SYSTEM_QUERIES()
+{
+    std::cout << "Testing System Queries\n";
+
+    JobSystem jobs(2);
+
+    for(JobSystem* jobSystem : {static_cast<JobSystem*>(nullptr), &jobs})
+    {
+        ObjectManager queryObjects;
+        MessageHub queryHub;
+        SystemManager querySystems(queryObjects, queryHub);
+        querySystems.setJobSystem(jobSystem);
+
+        MovingObjectCounter::updates = 0;
+        querySystems.addSystem<MovingObjectCounter>(SystemPhase::PostUpdate);
+        querySystems.addSystem<RateSystem<5>>();
+
+        //Systems with no matching objects are skipped
+        ID blocked = queryObjects.createObject(Position(), Motion(), Collidable());
+        querySystems.updateAllSystems(0.1);
+        assert(MovingObjectCounter::updates == 0);
+
+        //Objects created in an earlier phase are matched once the commands are applied at its sync point
+        querySystems.addSystem<MovingObjectSpawner>(SystemPhase::PreUpdate);
+        querySystems.updateAllSystems(0.1);
+        assert(MovingObjectCounter::updates == 1 && MovingObjectCounter::objectsSeen == 1);
+
+        //Time is not saved up while the system is skipped
+        assert(std::abs(MovingObjectCounter::lastDt - 0.1) < 1e-9);
+
+        queryObjects.removeComponents<Collidable>(blocked);
+        querySystems.updateAllSystems(0.1);
+        assert(MovingObjectCounter::updates == 2 && MovingObjectCounter::objectsSeen == 2);
+
+        querySystems.removeSystem<MovingObjectCounter>();
+        querySystems.updateAllSystems(0.1);
+        assert(MovingObjectCounter::updates == 2);
+    }
+
+    std::cout << "Finished Testing System Queries\n";
+}
+
+struct PacedState : public State
+{
+    void configure() {}
+    void initialize() {}
+
+    void update(double)
+    {
+        if(++updates == stopAfter || !msgHub.readPostedMessages<TextMessage>().empty())
+            stop();
+
+        msgHub.clearPostedMessages();
+    }
+
+    MessageHub& getHub() { return msgHub; }
+
+    int updates = 0;
+    int stopAfter = 0;
+};
+
+void TEST_FRAME_PACING()
+{
+    std::cout << "Testing Frame Pacing\n";
+
+    //Twenty frames at 200 per second take about a tenth of a second
+    PacedState paced;
+    paced.setTargetTickRate(200.0);
+    paced.stopAfter = 20;
+
+    Timer pacingTimer;
+    paced.run();
+    double elapsed = pacingTimer.getElapsedTime();
+    assert(paced.updates == 20);
+    assert(elapsed >= 0.09 && elapsed < 1.0);
+
+    //An idle state sleeps until a message arrives from another thread
+    PacedState idle;
+    idle.setIdle(true);
+
+    Transceiver sender;
+    std::thread poster([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        idle.getHub().postMessage<TextMessage>(sender, "Player joined");
+    });
+
+    pacingTimer.restart();
+    idle.run();
+    poster.join();
+    assert(idle.updates <= 3);
+    assert(pacingTimer.getElapsedTime() >= 0.04);
+
+    //Or until a scheduled message is due
+    PacedState scheduled;
+    scheduled.setIdle(true);
+    scheduled.getHub().postMessageAfter<TextMessage>(0.05, sender, "Round over");
+
+    pacingTimer.restart();
+    scheduled.run();
+    assert(scheduled.updates <= 3);
+    assert(pacingTimer.getElapsedTime() >= 0.04);
+
+    std::cout << "Finished Testing Frame Pacing\n";
+}
+
+//Spawns a moving object every few ticks, with its motion depending on how many it has spawned
+struct SpawnerSystem : public System
+{
+    SpawnerSystem() { writesComponents<Position, Motion>(); }
+
+    void update(ObjectManager& objManager, MessageHub&, double)
+    {
+        auto& commands = objManager.getCommandBuffer();
+        commands.addComponents(commands.createObject(), Position(0, 0), Motion(10 + spawned % 7, spawned * 0.37));
+        ++spawned;
+    }
+
+    int spawned = 0;
+};
+
+struct SimulationState : public State
+{
+    SimulationState(JobSystem& jobs = JobSystem::getShared()) : State(jobs)
+    {
+        sysManager.addSystem<SpawnerSystem>(SystemPhase::PreUpdate);
+        sysManager.addSystem<MovementSystem>();
+        sysManager.addSystem<RateSystem<6>>(SystemPhase::PostUpdate);
+
+        sysManager.setRateDivisor<SpawnerSystem>(4);
+
+        //Every update goes over this budget when timed
+        sysManager.setTimeBudget<RateSystem<6>>(1e-12);
+    }
+
+    void configure() {}
+    void initialize() {}
+
+    void update(double dt)
+    {
+        sysManager.updateAllSystems(dt);
+
+        overBudget += msgHub.readPostedMessages<SystemOverBudget>().size();
+        msgHub.clearPostedMessages();
+    }
+
+    //Get every object's position in id order
+    std::vector<std::pair<float, float>> getPositions()
+    {
+        std::vector<std::pair<float, float>> positions;
+
+        for(auto objectID : objManager.getObjects<Position>())
+        {
+            auto position = objManager.getComponent<Position>(objectID);
+            positions.emplace_back(position->x, position->y);
+        }
+
+        return positions;
+    }
+
+    double getSimulatedTime() const { return msgHub.getTime(); }
+
+    JobSystem& getJobs() { return jobSystem; }
+
+    std::size_t overBudget = 0;
+};
+
+void TEST_HEADLESS_RUNS()
+{
+    std::cout << "Testing Headless Runs\n";
+
+    SimulationState first;
+    HeadlessRunStats stats = first.runHeadless(400, 0.05);
+
+    assert(stats.ticks == 400);
+    assert(stats.ticksPerSecond > 0.0);
+    assert(std::abs(first.getSimulatedTime() - 20.0) < 1e-6);
+
+    //Systems are not timed, so nothing is posted about budgets
+    assert(first.overBudget == 0);
+
+    auto positions = first.getPositions();
+    assert(positions.size() == 100);
+
+    //The same run gives exactly the same world
+    SimulationState second;
+    second.runHeadless(400, 0.05);
+    assert(second.getPositions() == positions);
+
+    //States share one pool unless they are given their own. The number of workers doesn't change the result
+    assert(&first.getJobs() == &second.getJobs());
+    JobSystem ownJobs(3);
+    SimulationState own(ownJobs);
+    assert(&own.getJobs() == &ownJobs);
+    own.runHeadless(400, 0.05);
+    assert(own.getPositions() == positions);
+
+    //Without a step the fixed timestep is used
+    SimulationState fixed;
+    fixed.setFixedTimestep(0.1);
+    fixed.runHeadless(10);
+    assert(std::abs(fixed.getSimulatedTime() - 1.0) < 1e-6);
+
+    std::cout << "Finished Testing Headless Runs\n";
+}
+
 }//systest
 
 void testSystemManager()
@@ -114,5 +923,14 @@ void testSystemManager()
     systest::TEST_SYSTEM_VERSIONS();
     systest::TEST_ADD_SYSTEM();
     systest::TEST_REMOVE_SYSTEM();
+    systest::TEST_PARALLEL_SYSTEMS();
+    systest::TEST_PARALLEL_MESSAGE_ORDER();
+    systest::TEST_JOB_SYSTEM();
+    systest::TEST_UPDATE_RATES();
+    systest::TEST_SYSTEM_TIMINGS();
+    systest::TEST_SYSTEM_PHASES();
+    systest::TEST_SYSTEM_QUERIES();
+    systest::TEST_FRAME_PACING();
+    systest::TEST_HEADLESS_RUNS();
     std::cout << "Finished Testing Systems\n";
 }
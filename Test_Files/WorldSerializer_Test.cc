@@ -0,0 +1,401 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "WorldSerializer_Test.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <OCS/OCS.hpp>
+
+#include "SampleComponents.hpp"
+
+using namespace ocs;
+
+namespace worldtest
+{
+
+ObjectManager source;
+ObjectManager destination;
+
+void bindComponents(ObjectManager& objManager)
+{
+    objManager.bindStringToComponent<Position>("Position");
+    objManager.bindStringToComponent<Name>("Name");
+    objManager.bindStringToComponent<Motion>("Motion");
+    objManager.bindStringToComponent<Collidable>("Collidable");
+}
+
+void TEST_WORLD_ENCODING()
+{
+    std::cout << "Testing world encoding\n";
+
+    bindComponents(source);
+    bindComponents(destination);
+
+    source.createObject(Position(1, 2), Name("First"));
+    ID removed = source.createObject(Motion(3, 4));
+    source.createObject(Position(5, 6), Motion(7, 8), Collidable(1, 2, 3, 4));
+    source.createObject(Name("Last"));
+    source.destroyObject(removed);
+
+    BinaryWriter out;
+    WorldSerializer::encodeWorld(source, out);
+
+    BinaryReader in(out.getBuffer());
+    assert(WorldSerializer::decodeWorld(destination, in));
+
+    assert(destination.getTotalObjects() == 3);
+    assert(destination.getTotalComponents<Position>() == 2);
+    assert(destination.getTotalComponents<Motion>() == 1);
+    assert(destination.getTotalComponents<Name>() == 2);
+    assert(destination.getTotalComponents<Collidable>() == 1);
+
+    auto moving = destination.getObjects<Position, Motion, Collidable>();
+    assert(moving.size() == 1);
+    assert(destination.getComponent<Position>(moving[0])->x == 5);
+    assert(destination.getComponent<Motion>(moving[0])->angle == 8);
+    assert(destination.getComponent<Collidable>(moving[0])->height == 4);
+    assert(destination.getComponent<Motion>(moving[0])->getOwnerID() == moving[0]);
+
+    auto named = destination.getObjects<Position, Name>();
+    assert(named.size() == 1);
+    assert(destination.getComponent<Name>(named[0])->name == "First");
+
+    destination.destroyAllObjects();
+
+    //Data that is not a world should be rejected
+    BinaryReader bad(out.getBuffer().data() + 1, out.size() - 1);
+    assert(!WorldSerializer::decodeWorld(destination, bad));
+
+    //Saved ids are only used to match components to objects, so huge ids do not allocate anything
+    auto writeObjects = [](BinaryWriter& world, std::initializer_list<uint64_t> savedIDs)
+    {
+        world.writeBytes("OCSW", 4);
+        world.write(WorldSerializer::formatVersion);
+        world.writeVarint(0);
+        world.writeVarint(savedIDs.size());
+        for(auto savedID : savedIDs)
+            world.writeVarint(savedID);
+        world.writeVarint(0);
+    };
+
+    BinaryWriter hugeIDs;
+    writeObjects(hugeIDs, {uint64_t(-2), uint64_t(1) << 40});
+    BinaryReader hugeIn(hugeIDs.getBuffer());
+    assert(WorldSerializer::decodeWorld(destination, hugeIn));
+    assert(destination.getTotalObjects() == 2);
+    destination.destroyAllObjects();
+
+    //Repeated ids are rejected before any object is created
+    BinaryWriter repeatedIDs;
+    writeObjects(repeatedIDs, {4, 7, 4});
+    BinaryReader repeatedIn(repeatedIDs.getBuffer());
+    assert(!WorldSerializer::decodeWorld(destination, repeatedIn));
+    assert(destination.getTotalObjects() == 0);
+
+    //A section claiming more components than it has bytes fails, and the objects already created are removed
+    BinaryWriter hugeCount;
+    hugeCount.writeBytes("OCSW", 4);
+    hugeCount.write(WorldSerializer::formatVersion);
+    hugeCount.writeVarint(1);
+    hugeCount.writeString("Position");
+    hugeCount.writeVarint(1);
+    hugeCount.writeVarint(1);
+    hugeCount.writeVarint(1);
+    hugeCount.writeVarint(0);
+    hugeCount.writeVarint(uint64_t(1) << 60);
+    hugeCount.writeVarint(1);
+    hugeCount.write(char(1));
+
+    BinaryReader hugeCountIn(hugeCount.getBuffer());
+    assert(!WorldSerializer::decodeWorld(destination, hugeCountIn));
+    assert(destination.getTotalObjects() == 0);
+    assert(destination.getTotalComponents<Position>() == 0);
+
+    std::cout << "Finished testing world encoding\n";
+}
+
+void TEST_WORLD_FILE()
+{
+    std::cout << "Testing world files\n";
+
+    std::string file("world_test.bin");
+
+    assert(WorldSerializer::saveWorld(source, file));
+    assert(WorldSerializer::loadWorld(destination, file));
+
+    assert(destination.getTotalObjects() == source.getTotalObjects());
+    assert(destination.getTotalComponents<Position>() == source.getTotalComponents<Position>());
+    assert(destination.getTotalComponents<Name>() == source.getTotalComponents<Name>());
+
+    std::remove(file.c_str());
+
+    source.destroyAllObjects();
+    destination.destroyAllObjects();
+
+    std::cout << "Finished testing world files\n";
+}
+
+void TEST_WORLD_STREAMING()
+{
+    std::cout << "Testing world streaming\n";
+
+    std::string file("world_stream_test.bin");
+
+    for(int i = 0; i < 1000; ++i)
+    {
+        if(i % 2 == 0)
+            source.createObject(Position(i, i), Name("Streamed"));
+        else
+            source.createObject(Motion(i, 0));
+    }
+
+    assert(WorldSerializer::saveWorld(source, file));
+
+    MessageHub msgHub;
+    WorldStreamLoader loader(destination);
+
+    assert(loader.start(file));
+    assert(loader.isLoading());
+    assert(!loader.start(file));
+
+    //With no time budget only a small batch of objects is created each frame
+    int frames = 0;
+    while(!loader.update(msgHub, 0.0))
+        ++frames;
+
+    assert(frames > 1);
+    assert(!loader.isLoading());
+    assert(!loader.hasFailed());
+
+    auto progress = msgHub.readPostedMessages<WorldLoadProgress>();
+    assert(progress.size() > 1);
+    assert(progress.back().finished);
+    assert(progress.back().objectsLoaded == 1000);
+
+    assert(destination.getTotalObjects() == 1000);
+    assert(destination.getTotalComponents<Position>() == 500);
+    assert(destination.getTotalComponents<Name>() == 500);
+    assert(destination.getTotalComponents<Motion>() == 500);
+    assert((destination.getObjects<Position, Name>().size() == 500));
+
+    std::remove(file.c_str());
+
+    //A missing file can not be streamed
+    assert(!loader.start(file));
+
+    source.destroyAllObjects();
+    destination.destroyAllObjects();
+
+    //Write raw world bytes to the file and stream them, returning whether the load failed
+    auto streamBytes = [&](const BinaryWriter& world)
+    {
+        std::FILE* out = std::fopen(file.c_str(), "wb");
+        std::fwrite(world.getBuffer().data(), 1, world.size(), out);
+        std::fclose(out);
+
+        assert(loader.start(file));
+        while(!loader.update(msgHub))
+            std::this_thread::yield();
+
+        std::remove(file.c_str());
+        return loader.hasFailed();
+    };
+
+    auto writeHeader = [](BinaryWriter& world, std::size_t totalNames)
+    {
+        world.writeBytes("OCSW", 4);
+        world.write(WorldSerializer::formatVersion);
+        world.writeVarint(totalNames);
+        if(totalNames > 0)
+            world.writeString("Position");
+    };
+
+    //Huge saved ids are mapped, while repeated ones fail the load
+    for(bool repeated : {false, true})
+    {
+        BinaryWriter world;
+        writeHeader(world, 0);
+        world.writeVarint(2);
+        world.writeVarint(uint64_t(-2));
+        world.writeVarint(repeated ? uint64_t(-2) : uint64_t(1) << 40);
+        world.writeVarint(0);
+
+        assert(streamBytes(world) == repeated);
+        assert(destination.getTotalObjects() == (repeated ? 0 : 2));
+        destination.destroyAllObjects();
+    }
+
+    //Sections larger than the file, or with more components than bytes, fail without reserving for them
+    for(bool hugeSection : {false, true})
+    {
+        BinaryWriter world;
+        writeHeader(world, 1);
+        world.writeVarint(1);
+        world.writeVarint(1);
+        world.writeVarint(1);
+        world.writeVarint(0);
+        world.writeVarint(hugeSection ? 1 : uint64_t(1) << 60);
+        world.writeVarint(hugeSection ? uint64_t(1) << 50 : 1);
+        world.write(char(1));
+
+        assert(streamBytes(world));
+        assert(destination.getTotalObjects() == 0);
+    }
+
+    std::cout << "Finished testing world streaming\n";
+}
+
+void TEST_WORLD_DELTA()
+{
+    std::cout << "Testing world deltas\n";
+
+    WorldDeltaEncoder encoder(source);
+    WorldDeltaDecoder decoder(destination);
+
+    //Send the deltas through a byte stream
+    auto loopback = [&]()
+    {
+        BinaryWriter out;
+        encoder.encode(out);
+
+        BinaryReader in(out.getBuffer());
+        assert(decoder.apply(in));
+        assert(in.getRemaining() == 0);
+
+        return out.size();
+    };
+
+    ID first = source.createObject(Position(1, 2), Name("First"));
+    ID second = source.createObject(Position(3, 4), Motion(1, 0));
+    ID third = source.createObject(Name("Third"));
+
+    auto fullSize = loopback();
+
+    assert(destination.getTotalObjects() == 3);
+    assert(destination.getComponent<Name>(decoder.getLocalID(first))->name == "First");
+    assert(destination.getComponent<Position>(decoder.getLocalID(second))->y == 4);
+
+    //Nothing changed
+    auto emptySize = loopback();
+    assert(emptySize < fullSize);
+    assert(destination.getTotalObjects() == 3);
+
+    //Change a single value
+    source.getComponent<Position>(second)->x = 10;
+    auto changeSize = loopback();
+    assert(changeSize < fullSize);
+    assert(destination.getComponent<Position>(decoder.getLocalID(second))->x == 10);
+    assert(destination.getComponent<Position>(decoder.getLocalID(second))->y == 4);
+
+    //Change a component's size, add and remove components, create and destroy objects
+    source.getComponent<Name>(first)->name = "A longer name";
+    source.addComponents(third, Collidable(1, 2, 3, 4));
+    source.removeComponents<Motion>(second);
+    source.destroyObject(first);
+    ID fourth = source.createObject(Position(7, 8));
+    loopback();
+
+    assert(destination.getTotalObjects() == 3);
+    assert(decoder.getLocalID(first) == ID(-1) || fourth == first);
+    assert(destination.getComponent<Collidable>(decoder.getLocalID(third))->width == 3);
+    assert(!destination.getComponent<Motion>(decoder.getLocalID(second)));
+    assert(destination.getComponent<Position>(decoder.getLocalID(fourth))->y == 8);
+    assert(destination.getTotalComponents<Motion>() == 0);
+    assert(destination.getTotalComponents<Position>() == 2);
+
+    source.destroyAllObjects();
+    loopback();
+    assert(destination.getTotalObjects() == 0);
+
+    //A patch whose lengths would overflow when added is rejected
+    {
+        WorldDeltaEncoder positionEncoder(source);
+        WorldDeltaDecoder positionDecoder(destination);
+
+        ID moved = source.createObject(Position(1, 2));
+        BinaryWriter full;
+        positionEncoder.encode(full);
+        BinaryReader fullIn(full.getBuffer());
+        assert(positionDecoder.apply(fullIn));
+
+        BinaryWriter bad;
+        bad.writeVarint(0);
+        bad.writeVarint(0);
+        bad.writeVarint(0);
+        bad.writeVarint(1);
+        bad.writeVarint(moved);
+        bad.writeVarint(1);
+        bad.writeVarint(0 << 2 | 2);
+        bad.writeVarint(uint64_t(-1));
+        bad.writeVarint(1);
+        bad.write(char(1));
+
+        BinaryReader badIn(bad.getBuffer());
+        assert(!positionDecoder.apply(badIn));
+        assert(destination.getComponent<Position>(positionDecoder.getLocalID(moved))->x == 1);
+
+        source.destroyAllObjects();
+        destination.destroyAllObjects();
+    }
+
+    //Created ids from the wire are not used to size anything, so a huge id is mirrored without a huge allocation
+    {
+        WorldDeltaDecoder sparseDecoder(destination);
+        const ID hugeID = ID(1) << 61;
+
+        BinaryWriter sparse;
+        sparse.writeVarint(0);
+        sparse.writeVarint(0);
+        sparse.writeVarint(1);
+        sparse.writeVarint(hugeID);
+        sparse.writeVarint(0);
+
+        BinaryReader sparseIn(sparse.getBuffer());
+        assert(sparseDecoder.apply(sparseIn));
+        assert(sparseDecoder.getLocalID(hugeID) != ID(-1));
+        assert(sparseDecoder.getLocalID(hugeID - 1) == ID(-1));
+        assert(destination.getTotalObjects() == 1);
+
+        destination.destroyAllObjects();
+    }
+
+    std::cout << "Finished testing world deltas\n";
+}
+
+}//worldtest
+
+int testWorldSerializer()
+{
+    std::cout << "\nTesting World Serializer\n";
+    worldtest::TEST_WORLD_ENCODING();
+    worldtest::TEST_WORLD_FILE();
+    worldtest::TEST_WORLD_STREAMING();
+    worldtest::TEST_WORLD_DELTA();
+    std::cout << "Finished Testing World Serializer\n";
+
+    return 0;
+}
@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 #include "SystemManager_Test.hpp"
 #include "MessageHub_Test.hpp"
 #include "Commands_Test.hpp"
+#include "WorldSerializer_Test.hpp"
 
 int main()
 {
@@ -31,5 +32,6 @@ int main()
     testSystemManager();
     testMessageHub();
     testCommands();
+    testWorldSerializer();
     return 0;
 }
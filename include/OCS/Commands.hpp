@@ -30,5 +30,6 @@ freely, subject to the following restrictions:
 #include <OCS/Commands/AddComponent.hpp>
 #include <OCS/Commands/RemoveComponent.hpp>
 #include <OCS/Commands/RunScript.hpp>
+#include <OCS/Commands/CommandBuffer.hpp>
 
 #endif
@@ -0,0 +1,234 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_COMMANDBUFFER_H
+#define OCS_COMMANDBUFFER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "OCS/Misc/Config.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+#include "OCS/Objects/ObjectManager.hpp"
+
+namespace ocs
+{
+
+class DeferredCommands;
+
+/** \brief Records structural changes to an ObjectManager so they can be applied later at a sync point.
+ *         Each thread records into its own buffer, which it gets from ObjectManager::getCommandBuffer,
+ *         so systems running in parallel never touch the ObjectManager's arrays directly.
+ *
+ *         Objects created through a buffer get a deferred id that can be used with the same buffer's
+ *         other commands. It is replaced with the real id when the commands are applied.
+ *
+ *         e.g.
+ *             auto& commands = objManager.getCommandBuffer();
+ *             ID bullet = commands.createObject();
+ *             commands.addComponents(bullet, Position(x, y), Motion(10, angle));
+ *             ...at the sync point...
+ *             objManager.applyDeferredCommands();
+ */
+class CommandBuffer : NonCopyable
+{
+    public:
+
+        //!Set the sort key used for commands recorded on this thread. Commands are applied in order of their keys.
+        static void setSortKey(uint64_t);
+        static uint64_t getSortKey();
+
+        //!Check if an id was returned by a buffer's createObject and has not been applied yet.
+        static bool isDeferredID(ID id) { return (id & deferredFlag) != 0; }
+
+        //!Record the creation of an object with no components.
+        ID createObject();
+
+        //!Record the creation of an object from a prototype.
+        ID createObject(const std::string&);
+
+        //!Record adding components to an object.
+        template<typename C, typename ... Args>
+        void addComponents(ID, const C&, Args&& ...);
+
+        //!Record removing components from an object.
+        template<typename C, typename ... Args>
+        void removeComponents(ID);
+
+        //!Record the destruction of an object.
+        void destroyObject(ID);
+
+        //!Get the number of commands waiting to be applied.
+        std::size_t getTotalCommands() const { return operations.size(); }
+
+    private:
+
+        friend class DeferredCommands;
+
+        static const ID deferredFlag = ID(1) << 63;
+        static const unsigned int bufferShift = 40;
+
+        enum OperationType : uint8_t
+        {
+            Create,
+            CreateFromPrototype,
+            Add,
+            Remove,
+            Destroy
+        };
+
+        //!A single recorded command. Components and prototype names are stored separately and referred to by index.
+        struct Operation
+        {
+            uint64_t sortKey;
+            ID objectID;
+            Family family;
+            uint32_t payload;
+            OperationType type;
+        };
+
+        //!Stores the components waiting to be added for one component type.
+        struct BaseComponentStore
+        {
+            virtual ~BaseComponentStore() {}
+            virtual void reserve(ObjectManager&, std::size_t) = 0;
+            virtual void add(ObjectManager&, ID, uint32_t) = 0;
+            virtual void clear() = 0;
+        };
+
+        template<typename C>
+        struct ComponentStore : public BaseComponentStore
+        {
+            void reserve(ObjectManager& objManager, std::size_t total)
+            {
+                auto& compArray = objManager.getComponentArray<C>();
+                compArray.reserve(compArray.size() + total);
+            }
+
+            void add(ObjectManager& objManager, ID objectID, uint32_t index) { objManager.addComponents(objectID, components[index]); }
+            void clear() { components.clear(); }
+
+            std::vector<C> components;
+        };
+
+        CommandBuffer(uint64_t _bufferIndex) : bufferIndex(_bufferIndex), totalCreated(0) {}
+
+        //!Overload function with an empty template paramater list to allow recursion
+        void addComponents(ID) {}
+
+        template<typename C>
+        ComponentStore<C>& getStore();
+
+        void record(OperationType, ID, Family = 0, uint32_t = 0);
+
+        void clear();
+
+        uint64_t bufferIndex;
+
+        std::vector<Operation> operations;
+        std::unordered_map<Family, std::unique_ptr<BaseComponentStore>> stores;
+        std::vector<std::string> prototypeNames;
+
+        //!The real ids of the objects this buffer created, filled in when the commands are applied.
+        std::vector<ID> createdIDs;
+        ID totalCreated;
+};
+
+/** \brief Owns one CommandBuffer for every thread that records commands and applies them all at a sync point.
+ *
+ *         Commands are applied in order of their sort key, then by the order the buffers were first used, then
+ *         by the order they were recorded in. All creations are applied first. The other commands are applied in
+ *         batches of removals grouped by component type, then additions grouped by component type, then
+ *         destructions. A batch ends before a command that touches the same component of an object as an earlier
+ *         command in it, so adding then removing a component leaves it removed, and removing then adding replaces it.
+ */
+class DeferredCommands : NonCopyable
+{
+    public:
+
+        DeferredCommands();
+
+        //!Get the calling thread's command buffer.
+        CommandBuffer& getBuffer();
+
+        //!Apply every recorded command to the ObjectManager and empty the buffers.
+        void apply(ObjectManager&);
+
+        //!Get the number of commands waiting to be applied in all buffers.
+        std::size_t getTotalCommands();
+
+    private:
+
+        //!Used to tell instances apart in each thread's cached buffer lookup.
+        uint64_t instanceID;
+
+        std::mutex buffersMutex;
+        std::vector<std::unique_ptr<CommandBuffer>> buffers;
+        std::unordered_map<std::thread::id, CommandBuffer*> threadBuffers;
+};
+
+/** \brief Record adding one or more components to an object. The components are copied into the buffer.
+ *
+ * \param objectID The object's id, which may be a deferred id from this buffer.
+ * \param component The first component to add.
+ * \param others Any other components to add.
+ */
+template<typename C, typename ... Args>
+void CommandBuffer::addComponents(ID objectID, const C& component, Args&& ... others)
+{
+    auto& store = getStore<C>();
+
+    record(Add, objectID, C::getFamily(), store.components.size());
+    store.components.push_back(component);
+
+    addComponents(objectID, others...);
+}
+
+/** \brief Record removing one or more components from an object.
+ *
+ * \param objectID The object's id, which may be a deferred id from this buffer.
+ */
+template<typename C, typename ... Args>
+void CommandBuffer::removeComponents(ID objectID)
+{
+    for(auto compFamily : {C::getFamily(), Args::getFamily()...})
+        record(Remove, objectID, compFamily);
+}
+
+template<typename C>
+CommandBuffer::ComponentStore<C>& CommandBuffer::getStore()
+{
+    auto& store = stores[C::getFamily()];
+
+    if(!store)
+        store.reset(new ComponentStore<C>());
+
+    return static_cast<ComponentStore<C>&>(*store);
+}
+
+}//ocs
+
+#endif
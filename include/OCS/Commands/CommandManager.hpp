@@ -25,6 +25,7 @@ freely, subject to the following restrictions:
 
 #include <memory>
 #include <map>
+#include <string>
 
 #include "OCS/Commands/Command.hpp"
 #include <OCS/Misc/Config.hpp>
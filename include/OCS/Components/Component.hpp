@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 #define OCS_COMPONENT_H
 
 #include "OCS/Misc/Config.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
 #include "OCS/Utilities/Serializer.hpp"
 
 namespace ocs
@@ -47,6 +48,19 @@ struct BaseComponent
     virtual std::string serialize() { return (""); }
     virtual void deSerialize(const std::string&) {}
 
+    //!Write the component in binary form. Falls back to the string given by serialize.
+    virtual void writeBinary(BinaryWriter& out) { out.writeString(serialize()); }
+
+    //!Read the component from its binary form. Falls back to deSerialize.
+    virtual bool readBinary(BinaryReader& in)
+    {
+        std::string str;
+        if(!in.readString(str))
+            return false;
+        deSerialize(str);
+        return true;
+    }
+
     protected:
 
         Serializer serializer;
@@ -64,6 +78,9 @@ struct BaseComponent
  * Derived components may implement serialize and deSerialize functions if the user wishes to load them
  * from a file or pass the component's information in a string.
  *
+ * Derived components may also implement writeBinary and readBinary to be saved in binary world files.
+ * If they do not, the string produced by serialize is stored instead, which must be readable by deSerialize.
+ *
  * All derived components MUST implement a default constructor and SHOULD implement a paramaterized constructor.
  *
  */
@@ -23,7 +23,9 @@ freely, subject to the following restrictions:
 #ifndef OCS_COMPONENTARRAY_H
 #define OCS_COMPONENTARRAY_H
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <OCS/Components/Component.hpp>
 #include <OCS/Utilities/PackedArray.hpp>
@@ -35,11 +37,23 @@ struct BaseComponentArray
     virtual ocs::BaseComponent& getBaseComponent(Index) = 0;
     virtual Index createCopy(Index) = 0;
     virtual Index createCopy(Index, BaseComponentArray*) = 0;
+    virtual Index moveItem(Index, BaseComponentArray*) = 0;
+    virtual BaseComponentArray* createEmpty() const = 0;
     virtual void remove(Index) = 0;
     virtual void clear() = 0;
     virtual Index size() const = 0;
 
     virtual Index add_item(const std::string&) = 0;
+    virtual Index add_item(BinaryReader&) = 0;
+
+    //!Reserve room for the given total number of components.
+    virtual void reserve(Index) = 0;
+
+    //!Write every component in the array, each preceded by its owner's id.
+    virtual void writeBinary(BinaryWriter&) = 0;
+
+    //!Append components written by writeBinary. Returns how many were read.
+    virtual Index readBinary(BinaryReader&, Index, std::vector<ocs::ID>&, std::vector<Index>&) = 0;
 
 };
 
@@ -78,6 +92,19 @@ struct ComponentArray : public BaseComponentArray
 
         }
 
+        //!Move an item to the end of another array of the same type. The moved from item is left in this array.
+        Index moveItem(Index idx, BaseComponentArray* otherArry)
+        {
+            auto otherCompArry = dynamic_cast<ComponentArray<C>*>(otherArry);
+
+            if(otherCompArry)
+                return otherCompArry->arry.add_item(std::move(arry[idx]));
+            return -1;
+        }
+
+        //!Create a new empty array that stores the same type of component.
+        BaseComponentArray* createEmpty() const { return new ComponentArray<C>(); }
+
         void remove(Index idx) { arry.remove(idx); }
         void clear() { arry.clear(); }
         Index size() const { return arry.size(); }
@@ -90,6 +117,55 @@ struct ComponentArray : public BaseComponentArray
             return arry.add_item(newItem);
         }
 
+        //!Add a component read with its readBinary function. Returns an invalid index if it could not be read.
+        Index add_item(BinaryReader& in)
+        {
+            C newItem;
+            if(!newItem.readBinary(in))
+                return BasePackedArray::INVALID_INDEX;
+
+            return arry.add_item(std::move(newItem));
+        }
+
+        void reserve(Index total) { arry.reserve(total); }
+
+        void writeBinary(BinaryWriter& out)
+        {
+            for(auto& component : arry)
+            {
+                out.writeVarint(component.getOwnerID());
+                component.writeBinary(out);
+            }
+        }
+
+        /** \brief Append components that were written by writeBinary to the array.
+         *
+         * \param in The reader positioned at the first component.
+         * \param total The number of components to read.
+         * \param owners Receives the owner id that was stored with each component.
+         * \param indices Receives the index each component was stored at.
+         * \return The number of components that were read.
+         */
+        Index readBinary(BinaryReader& in, Index total, std::vector<ocs::ID>& owners, std::vector<Index>& indices)
+        {
+            //The total comes from the data, and each component takes at least one byte
+            arry.reserve(arry.size() + std::min<std::size_t>(total, in.getRemaining()));
+
+            for(Index i = 0; i < total; ++i)
+            {
+                uint64_t owner = 0;
+                C newItem;
+
+                if(!in.readVarint(owner) || !newItem.readBinary(in))
+                    return i;
+
+                owners.push_back(owner);
+                indices.push_back(arry.add_item(std::move(newItem)));
+            }
+
+            return total;
+        }
+
     private:
 
         PackedArray<C> arry;
@@ -23,8 +23,17 @@ freely, subject to the following restrictions:
  #ifndef OCS_MESSAGING_HPP
  #define OCS_MESSAGING_HPP
 
+ #include <OCS/Messaging/CoalescingIndex.hpp>
+ #include <OCS/Messaging/Mailbox.hpp>
  #include <OCS/Messaging/Message.hpp>
  #include <OCS/Messaging/MessageHub.hpp>
+ #include <OCS/Messaging/MessageQueue.hpp>
+ #include <OCS/Messaging/MessageRecording.hpp>
+ #include <OCS/Messaging/MessageSlot.hpp>
+ #include <OCS/Messaging/MessageStatistics.hpp>
+ #include <OCS/Messaging/MessageTap.hpp>
+ #include <OCS/Messaging/SharedMessageTransport.hpp>
+ #include <OCS/Messaging/TimerWheel.hpp>
  #include <OCS/Messaging/Transceiver.hpp>
 
  #endif
@@ -0,0 +1,79 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_COALESCINGINDEX_H
+#define OCS_COALESCINGINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "OCS/Misc/Config.hpp"
+
+namespace ocs
+{
+
+/** \brief A small open-addressing hash table from a message key to a position. Used by MessageHub to
+ *         overwrite keyed messages in place and to find the list of messages posted under a topic. Clearing only bumps a generation counter,
+ *         so a table that is emptied every frame is never walked.
+ */
+class CoalescingIndex
+{
+    public:
+
+        CoalescingIndex();
+
+        //!Look up a key. If it is missing it is added with the given position.
+        //!Returns the key's position and sets inserted to true if it was just added.
+        uint32_t findOrInsert(ID, uint32_t, bool&);
+
+        //!Look up a key without adding it. Returns false if it is missing.
+        bool find(ID, uint32_t&) const;
+
+        //!Remove every key.
+        void clear();
+
+        std::size_t size() const { return count; }
+
+    private:
+
+        struct Entry
+        {
+            ID key;
+            uint32_t position;
+
+            //!The entry is only in use if this matches the index's generation.
+            uint32_t generation;
+        };
+
+        static uint64_t hash(ID);
+
+        //!Double the table and re-insert the live entries.
+        void grow();
+
+        std::vector<Entry> entries;
+        uint32_t generation;
+        std::size_t count;
+};
+
+}//ocs
+
+#endif
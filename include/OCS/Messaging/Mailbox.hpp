@@ -0,0 +1,189 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MAILBOX_H
+#define OCS_MAILBOX_H
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "OCS/Messaging/MessageSlot.hpp"
+
+namespace ocs
+{
+
+//!What a full mailbox does with a new message
+enum class OverflowPolicy
+{
+    //!Discard the oldest message to make room
+    DropOldest,
+
+    //!Discard the new message. The sender is still told it was sent.
+    DropNewest,
+
+    //!Refuse the new message and report the failure to the sender
+    Reject
+};
+
+/** \brief Type-erased interface to a MailboxSlot so a mailbox can clear and log every message type.
+ */
+class BaseMailboxSlot
+{
+    public:
+
+        virtual ~BaseMailboxSlot() {}
+
+        virtual void clear() = 0;
+        virtual void log(std::ostream&) = 0;
+        virtual std::size_t size() const = 0;
+
+        //!Get the memory held for the ring and the last read's messages.
+        virtual std::size_t getAllocatedBytes() const = 0;
+};
+
+/** \brief A fixed-capacity ring of private messages of one type. Reading moves every message out into a
+ *         reusable buffer so the caller gets a contiguous view, and leaves the ring empty.
+ */
+template<typename T>
+class MailboxSlot : public BaseMailboxSlot
+{
+    public:
+
+        explicit MailboxSlot(std::size_t _capacity) :
+            storage(new Storage[_capacity]),
+            capacity(_capacity),
+            head(0),
+            count(0)
+        {
+            consumed.reserve(_capacity);
+        }
+
+        ~MailboxSlot() { clearRing(); }
+
+        /** \brief Construct a message at the back of the ring.
+         *
+         * \param policy What to do if the ring is full.
+         * \param dropped Set to true if a message was discarded.
+         * \return The stored message, or nullptr if the new message was not stored.
+         */
+        template<typename ... Args>
+        T* emplace(OverflowPolicy policy, bool& dropped, Args&& ... args)
+        {
+            dropped = false;
+
+            if(count == capacity)
+            {
+                dropped = true;
+                if(policy != OverflowPolicy::DropOldest || capacity == 0)
+                    return nullptr;
+
+                at(0).~T();
+                head = (head + 1) % capacity;
+                --count;
+            }
+
+            T* msg = new (&storage[(head + count) % capacity]) T(std::forward<Args>(args)...);
+            ++count;
+
+            return msg;
+        }
+
+        //!Move every message out of the ring. The view is valid until the next read or clear.
+        MessageSpan<T> consume()
+        {
+            consumed.clear();
+
+            for(std::size_t i = 0; i < count; ++i)
+                consumed.push_back(std::move(at(i)));
+
+            clearRing();
+
+            return MessageSpan<T>(consumed.data(), consumed.size());
+        }
+
+        void clear()
+        {
+            clearRing();
+            consumed.clear();
+        }
+
+        void log(std::ostream& out)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out << at(i).getTimeStamp() << std::endl;
+                at(i).log(out);
+                out << std::endl;
+            }
+        }
+
+        std::size_t size() const { return count; }
+
+        std::size_t getAllocatedBytes() const { return capacity * sizeof(Storage) + consumed.capacity() * sizeof(T); }
+
+    private:
+
+        using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+        T& at(std::size_t index) { return *reinterpret_cast<T*>(&storage[(head + index) % capacity]); }
+
+        void clearRing()
+        {
+            for(std::size_t i = 0; i < count; ++i)
+                at(i).~T();
+
+            head = 0;
+            count = 0;
+        }
+
+        std::unique_ptr<Storage[]> storage;
+        std::size_t capacity;
+        std::size_t head;
+        std::size_t count;
+
+        //!The messages returned by the last read.
+        std::vector<T> consumed;
+};
+
+/** \brief A transceiver's private messages, with one ring per message type.
+ */
+struct Mailbox
+{
+    Mailbox(std::size_t _capacity, OverflowPolicy _policy) : capacity(_capacity), policy(_policy), dropped(0) {}
+
+    //!The most messages of each type the mailbox holds
+    std::size_t capacity;
+    OverflowPolicy policy;
+
+    //!Messages discarded or rejected because a ring was full
+    std::size_t dropped;
+
+    //!Rings indexed by message family
+    std::vector<std::unique_ptr<BaseMailboxSlot>> slots;
+};
+
+}//ocs
+
+#endif
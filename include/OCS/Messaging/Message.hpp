@@ -23,6 +23,7 @@ freely, subject to the following restrictions:
 #ifndef OCS_MESSAGE_H
 #define OCS_MESSAGE_H
 
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -34,6 +35,24 @@ class Transceiver;
 
 using ID = uint64_t;
 
+/** \brief Cheap bookkeeping stored with every message. The time is only turned into a readable string when logging.
+ */
+struct MessageMetadata
+{
+    //!Nanoseconds on the steady clock when the message was created
+    uint64_t timeNanoseconds;
+
+    //!The MessageHub's frame number when the message was posted
+    uint64_t frame;
+
+    //!Order the message was posted in, counted across all message types in the hub
+    uint64_t sequence;
+
+    //!The topic the message was posted under, or noTopic
+    ID topic;
+
+    static const ID noTopic = ID(-1);
+};
 
 /** \brief This struct should not be inherited from. It is used internally to keep track of message ids
  *         and for storage in the MessageHub.
@@ -51,14 +70,22 @@ struct BaseMessage
     virtual void log(std::ostream&) {}
 
     ID getSender() const { return senderID; }
-    std::string getTimeStamp() const { return timeStamp; }
+    const MessageMetadata& getMetadata() const { return metadata; }
+
+    //!Format the time the message was created as local wall clock time
+    std::string getTimeStamp() const;
+
+    //!Get the current time on the clock used for message metadata
+    static uint64_t getMonotonicTime();
 
     protected:
 
-        static Family familyCounter;
+        friend class MessageHub;
+
+        static std::atomic<Family> familyCounter;
 
         ID senderID;
-        std::string timeStamp;
+        MessageMetadata metadata;
 };
 
 /** \brief A user defined message can be created by inheriting from "Message" and passing in the type as the template paramater.
@@ -23,14 +23,28 @@ freely, subject to the following restrictions:
 #ifndef OCS_MESSAGEHUB_H
 #define OCS_MESSAGEHUB_H
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stack>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "OCS/Messaging/Mailbox.hpp"
 #include "OCS/Messaging/Message.hpp"
+#include "OCS/Messaging/MessageQueue.hpp"
+#include "OCS/Messaging/MessageSlot.hpp"
+#include "OCS/Messaging/MessageStatistics.hpp"
+#include "OCS/Messaging/MessageTap.hpp"
+#include "OCS/Messaging/TimerWheel.hpp"
 #include "OCS/Messaging/Transceiver.hpp"
 #include "OCS/Utilities/PackedArray.hpp"
 #include "OCS/Misc/NonCopyable.hpp"
@@ -38,21 +52,55 @@ freely, subject to the following restrictions:
 namespace ocs
 {
 
-template<typename T>
-using messagePtr = std::shared_ptr<T>;
+class MessageReplayer;
+class SharedMessageReader;
 
-using MessageSlot = std::vector<messagePtr<BaseMessage>>;
-using MessageBoard = std::unordered_map<Family, MessageSlot>;
+//!When a subscribed handler is called
+enum class DispatchMode
+{
+    //!As soon as the message is posted on the owner thread. Messages posted from other threads are dispatched
+    //!on the owner thread when syncMessages moves them onto the board.
+    Immediate,
+
+    //!When MessageHub::dispatchMessages is called at the end of a phase
+    Deferred
+};
 
 /** \brief Handles the posting and retrieving of messages. Users called "Transceivers" may create an object
  *         that inheritys from "Message", and post this object for other transceivers to see. These messages
  *         should be cleared periodically.
- *         Registered Transceivers also receive a message slot that other transceivers can send messages to.
- *         These messages stay active until the recipient transceiver views these messages.
+ *         Registered Transceivers also receive a mailbox that other transceivers can send messages to.
+ *         These messages stay active until the recipient transceiver views these messages. Each mailbox
+ *         holds a fixed number of messages of each type, and what happens when it is full is set per
+ *         transceiver with configureMailbox.
  *
  *         Messages are sorted by their type. There is no need for a transceiver to subscribe to a certain message
  *         type. They can simply get a list of the desired message type from the message board.
  *
+ *         Messages of each type are stored by value in one contiguous slot that is reused between frames, and
+ *         are read through a MessageSpan that points into the slot.
+ *
+ *         In double-buffered mode, readers see the complete set of messages posted during the previous frame
+ *         while new messages go into a second board. The boards trade places in advanceFrame, so the order
+ *         systems run in no longer decides which messages they see.
+ *
+ *         Messages may be posted or sent from any thread. Messages from threads other than the one that created the
+ *         hub go into a lock-free queue for that thread and appear on the board when syncMessages is called.
+ *         Everything else must only be called from the hub's own thread.
+ *
+ *         The hub's thread can block in waitForMessages until another thread posts or sends a message, e.g. to let an
+ *         idle server sleep between frames.
+ *
+ *         Messages can also be scheduled for a later time with postMessageAt or postMessageAfter. The hub's clock
+ *         is moved forward by advanceTime, which State::run calls with each frame's dt.
+ *
+ *         Per-family traffic statistics can be turned on with enableStatistics and dumped as JSON with writeStatistics.
+ *
+ *         Alternatively a transceiver can subscribe a handler to a message type. Handlers are only called when
+ *         a message of that type is posted, so rare events cost nothing on frames where they don't happen.
+ *         e.g.
+ *             msgHub.subscribe<Explosion>(*this, [this](const Explosion& msg) { ... });
+ *
  *
  *  \author Kevin Miller
  *  \version 2-22-2014
@@ -61,22 +109,107 @@ class MessageHub : NonCopyable
 {
     public:
 
+        MessageHub();
+        ~MessageHub();
+
         //!Post a message that is available to all users.
         template<typename T, typename ... Args>
         void postMessage(const Transceiver&, Args&& ...);
 
-        //!Get a list of a specific type of message from the message board. Does not delete messages.
+        //!Post a message under a topic, such as the id of the object it is about.
+        template<typename T, typename ... Args>
+        void postTopicMessage(ID topic, const Transceiver&, Args&& ...);
+
+        //!Get a view of the messages of a type that were posted under a topic.
         template<typename T>
-        std::vector<messagePtr<T>> readPostedMessages();
+        TopicView<T> readPostedMessages(ID topic);
+
+        //!Post a message once the hub's clock reaches the given time in seconds.
+        template<typename T, typename ... Args>
+        void postMessageAt(double, const Transceiver&, Args&& ...);
+
+        //!Post a message once the given number of seconds have passed on the hub's clock.
+        template<typename T, typename ... Args>
+        void postMessageAfter(double, const Transceiver&, Args&& ...);
+
+        //!Pass every message to a tap, such as a recorder, as it reaches the board or a mailbox.
+        void addMessageTap(MessageTap*);
+
+        //!Stop passing messages to a tap.
+        void removeMessageTap(MessageTap*);
+
+        //!Move the hub's clock forward and post every scheduled message that has become due.
+        void advanceTime(double);
+
+        //!Get the hub's clock in seconds.
+        double getTime() const { return currentTime; }
+
+        //!Get the number of scheduled messages that have not been posted yet.
+        std::size_t getTotalScheduledMessages() const { return timers.size(); }
+
+        //!Get the time on the hub's clock the next scheduled message is due. Returns false if none are scheduled.
+        bool getNextScheduledTime(double&) const;
+
+        //!Post a message that replaces any message of the same type and key posted since the board was last cleared or swapped.
+        template<typename T, typename ... Args>
+        void postCoalescedMessage(ID key, const Transceiver&, Args&& ...);
+
+        //!Call a handler for each posted message of a type, either immediately or at the next dispatch.
+        template<typename T>
+        void subscribe(const Transceiver&, std::function<void(const T&)>, DispatchMode = DispatchMode::Deferred);
+
+        //!Remove a transceiver's handlers for a message type.
+        template<typename T>
+        void unsubscribe(const Transceiver&);
+
+        //!Remove all of a transceiver's handlers.
+        void unsubscribeAll(const Transceiver&);
+
+        //!Call deferred handlers for every message posted since the last dispatch.
+        void dispatchMessages();
+
+        //!Move messages posted from other threads onto the board. Returns the number of messages moved.
+        std::size_t syncMessages();
+
+        //!Make the calling thread the hub's own thread, e.g. when the hub was created on another thread.
+        void setOwnerThread() { ownerThread = std::this_thread::get_id(); }
+
+        //!Make the given thread the hub's own thread. With a default constructed id every post is queued until syncMessages.
+        void setOwnerThread(std::thread::id thread) { ownerThread = thread; }
+
+        std::thread::id getOwnerThread() const { return ownerThread; }
+
+        //!Block the hub's thread until another thread posts or sends a message, or wake is called. The messages are synced.
+        void waitForMessages();
+
+        //!Block like waitForMessages for at most the given number of seconds. Returns false if it timed out.
+        bool waitForMessages(double);
+
+        //!Wake the hub's thread if it is blocked in waitForMessages. May be called from any thread.
+        void wake();
+
+        //!Get a view of a specific type of message from the message board. Does not delete messages.
+        //!In double-buffered mode these are the messages posted during the previous frame.
+        template<typename T>
+        MessageSpan<T> readPostedMessages();
 
         /*!Send a message directly to a transceiver that only the recipient can view.
-        This message is available until the recipient views it.*/
+        This message is available until the recipient views it. Returns false if the mailbox did not take it.*/
         template<typename T, typename ... Args>
-        void sendPrivateMessage(ID receiverID, const Transceiver&, Args&& ...);
+        bool sendPrivateMessage(ID receiverID, const Transceiver&, Args&& ...);
 
-        //!Get a list of the specified message type from the personal message slot. Deletes the private messages.
+        //!Get the specified message type from the personal mailbox. Removes the messages from the mailbox.
         template<typename T>
-        std::vector<messagePtr<T>> readPrivateMessages(const Transceiver&);
+        MessageSpan<T> readPrivateMessages(const Transceiver&);
+
+        //!Set the size and overflow policy of a transceiver's mailbox. Clears its private messages.
+        void configureMailbox(const Transceiver&, std::size_t, OverflowPolicy);
+
+        //!Set the size and overflow policy used for mailboxes that have not been configured.
+        void setDefaultMailbox(std::size_t, OverflowPolicy);
+
+        //!Get the number of private messages dropped or rejected because a transceiver's mailbox was full.
+        std::size_t getDroppedMessages(const Transceiver&) const;
 
         //!Log all messages that are currently posted on the message board to the specified stream.
         void logPostedMessages(std::ostream&);
@@ -84,12 +217,41 @@ class MessageHub : NonCopyable
         //!Log all private messages for the given transceiver to the specified stream.
         void logPrivateMessages(const Transceiver&, std::ostream&);
 
-        //!Clear all messages from the message board.
+        //!Clear all messages from the message board. Messages that have not been dispatched are dropped.
         void clearPostedMessages();
 
-        //!Clear all messages from the message board.
+        //!Move to the next frame. In double-buffered mode this also swaps the boards.
+        void advanceFrame();
+
+        //!Switch between one board that is cleared manually and two boards swapped every frame. Clears all posted messages.
+        void setDoubleBuffered(bool);
+
+        bool isDoubleBuffered() const { return doubleBuffered; }
+
+        //!Get the current frame number.
+        uint64_t getFrame() const { return currentFrame; }
+
+        //!Clear all private messages of a transceiver.
         void clearPrivateMessages(const Transceiver&);
 
+        //!Start counting posts, reads and latency per message family. Latency is sampled every N reads per thread.
+        void enableStatistics(unsigned int = 16);
+
+        //!Stop counting and discard the statistics.
+        void disableStatistics();
+
+        bool isCollectingStatistics() const { return statistics != nullptr; }
+
+        //!Get the statistics, with the memory use of each family brought up to date. Returns nullptr if not enabled.
+        const MessageStatistics* getStatistics();
+
+        //!Write the statistics as JSON. Writes nothing if they are not enabled.
+        void writeStatistics(std::ostream&);
+
+        //!Set the name a message type is listed under in the statistics. Statistics must be enabled.
+        template<typename T>
+        void setMessageName(const std::string&);
+
     protected:
 
         //!Get a new Transceiver id.
@@ -99,8 +261,128 @@ class MessageHub : NonCopyable
 
         friend class Transceiver;
 
-        //!Clear a message slot.
-        void clearMessageSlot(MessageSlot&);
+        using Handler = std::function<void(const BaseMessage&)>;
+
+        struct Subscription
+        {
+            ID transceiverID;
+            Handler handler;
+
+            //!Cleared when unsubscribing during a dispatch. The entry is removed once the dispatch finishes.
+            bool active;
+        };
+
+        //!A deque so subscribing from inside a handler doesn't move the handler that is running.
+        using SubscriptionList = std::deque<Subscription>;
+
+        //!All handlers for one message family.
+        struct SubscriberList
+        {
+            SubscriptionList immediate;
+            SubscriptionList deferred;
+
+            //!Number of posted messages already passed to the deferred handlers.
+            std::size_t dispatched = 0;
+
+            //!Positions below dispatched that a coalesced post overwrote, to be passed to the deferred handlers again.
+            std::vector<std::size_t> redispatch;
+        };
+
+        //!Call the immediate handlers for a message that was just posted.
+        void dispatchImmediate(Family, std::size_t);
+
+        //!Call each active handler in a list with a message.
+        void callHandlers(SubscriptionList&, Family, std::size_t);
+
+        //!Remove a transceiver's handlers from a list, or deactivate them if a dispatch is running.
+        void removeSubscriptions(SubscriptionList&, ID);
+
+        //!Erase deactivated handlers once no dispatch is running.
+        void compactSubscriptions();
+
+        //!Get the calling thread's queue, creating and registering it on first use.
+        MessageQueue& getProducerQueue();
+
+        //!Push a message into the calling thread's queue and wake the hub's thread if it is waiting for messages.
+        template<typename T, typename ... Args>
+        void queueMessage(MessageQueue::CommitFunc, ID, Args&& ...);
+
+        //!Move a message from a producer queue onto the board.
+        template<typename T>
+        static void commitPostedMessage(MessageHub&, void*, ID);
+
+        //!Put a private message in a mailbox according to its overflow policy.
+        template<typename T, typename ... Args>
+        bool deliverPrivateMessage(ID, Args&& ...);
+
+        //!Get a transceiver's mailbox, creating it with the default settings if needed.
+        Mailbox& getMailbox(ID);
+
+        //!Construct or overwrite a keyed message on the board from the hub's thread.
+        template<typename T, typename ... Args>
+        void postLocalCoalescedMessage(ID, Args&& ...);
+
+        //!Move a keyed message from a producer queue onto the board.
+        template<typename T>
+        static void commitCoalescedMessage(MessageHub&, void*, ID);
+
+        //!Construct a message under a topic on the board from the hub's thread.
+        template<typename T, typename ... Args>
+        void postLocalTopicMessage(ID, Args&& ...);
+
+        //!Move a message with a topic from a producer queue onto the board.
+        template<typename T>
+        static void commitTopicMessage(MessageHub&, void*, ID);
+
+        //!Store a message until the given tick, or post it now if the tick has passed.
+        template<typename T, typename ... Args>
+        void scheduleLocalMessage(uint64_t, Args&& ...);
+
+        //!Move a scheduled message from a producer queue into the timing wheel.
+        template<typename T>
+        static void commitScheduledMessage(MessageHub&, void*, ID);
+
+        //!Schedule a message queued by postMessageAfter, measuring its delay from the hub's clock at the sync.
+        template<typename T>
+        static void commitDelayedMessage(MessageHub&, void*, ID);
+
+        //!Convert a time in seconds to the first timer tick at or after it.
+        static uint64_t getTimerTick(double);
+
+        //!Move a message from a producer queue into a mailbox.
+        template<typename T>
+        static void commitPrivateMessage(MessageHub&, void*, ID);
+
+        //!Construct a message on the board from the hub's thread and call its immediate handlers.
+        template<typename T, typename ... Args>
+        void postLocalMessage(Args&& ...);
+
+        friend class MessageReplayer;
+        friend class SharedMessageReader;
+
+        //!Stamp a newly posted message with the frame and sequence number, and pass it to the taps.
+        void stampMessage(BaseMessage&, Family, PostKind, ID = 0);
+
+        //!Hand a message to every tap.
+        void tapMessage(const BaseMessage&, Family, PostKind, ID);
+
+        //!Post a message that was rebuilt from bytes, the same way it was originally posted.
+        template<typename T>
+        void postDecodedMessage(T&&, PostKind, ID);
+
+        //!Get the slot for a message type from a board, creating it if needed.
+        template<typename T>
+        static MessageSlot<T>& getSlot(MessageBoard&);
+
+        //!Get a view of a message type on a board without creating a slot.
+        template<typename T>
+        static MessageSpan<T> getSpan(MessageBoard&);
+
+        //!Clear only the listed slots of a board, then empty the list.
+        static void clearUsedSlots(MessageBoard&, std::vector<Family>&);
+
+        //!Note the size of every slot with messages on the board that is being written.
+        void recordSlotSizes();
 
         //!Log a message to a given messageboard.
         void logMessages(const MessageBoard&, std::ostream&);
@@ -108,57 +390,547 @@ class MessageHub : NonCopyable
         //!Where all messages are posted.
         MessageBoard messageBoard;
 
-        //!A list of private message boards.
-        std::unordered_map<ID, MessageBoard> privateMessages;
+        //!Last frame's messages when double-buffered.
+        MessageBoard readBoard;
+
+        //!Families with messages on each board, so clearing skips the empty slots.
+        std::vector<Family> usedFamilies;
+        std::vector<Family> readUsedFamilies;
+
+        bool doubleBuffered;
+
+        template<typename T>
+        friend class ScheduledMessageSlot;
+
+        //!Length of one timer tick in seconds.
+        static const double timerResolution;
+
+        double currentTime;
+
+        //!The timer tick the clock is on. Messages due on or before it are posted right away.
+        uint64_t currentTick;
+        TimerWheel timers;
+
+        //!Messages waiting for their timers, indexed by family.
+        std::vector<std::unique_ptr<BaseScheduledMessageSlot>> scheduledMessages;
+
+        //!Reused when collecting expired timers.
+        std::vector<TimerWheel::Timer> expiredTimers;
+
+        //!Receive every message that reaches the board or a mailbox.
+        std::vector<MessageTap*> taps;
+
+        //!Traffic statistics when enabled, otherwise nullptr.
+        std::unique_ptr<MessageStatistics> statistics;
+
+        //!Every transceiver's mailbox.
+        std::unordered_map<ID, Mailbox> mailboxes;
+
+        std::size_t defaultMailboxCapacity;
+        OverflowPolicy defaultOverflowPolicy;
 
-        static ID transceiverIdCounter;
+        //!Handlers indexed by message family.
+        std::vector<SubscriberList> subscribers;
+
+        //!Families that have at least one deferred handler, so dispatching skips everything else.
+        std::vector<Family> deferredFamilies;
+
+        //!How many handler calls are on the stack. Handlers are only erased when this is zero.
+        int dispatchDepth;
+        bool hasInactiveSubscriptions;
+
+        uint64_t currentFrame;
+        uint64_t messageSequence;
+
+        //!The thread that may read and clear messages. Posts from any other thread are queued.
+        std::thread::id ownerThread;
+
+        //!Lock-free list of every producer thread's queue. Queues are only removed when the hub is destroyed.
+        std::atomic<MessageQueue*> producerQueues;
+
+        //!The queued messages found by syncMessages, kept to reuse its memory.
+        std::vector<MessageQueue::PendingMessage> pendingMessages;
+
+        //!Tells hubs apart in each thread's cached queue lookup.
+        uint64_t instanceID;
+
+        //!Set while the hub's thread is in waitForMessages, so producers only take the lock when someone is waiting.
+        std::atomic<bool> waitingForMessages;
+        std::mutex wakeMutex;
+        std::condition_variable wakeCondition;
+        bool wakeRequested;
+
+        static std::atomic<ID> transceiverIdCounter;
+        static std::atomic<uint64_t> instanceCounter;
 };
 
 template<typename T, typename ... Args>
 void MessageHub::postMessage(const Transceiver& transceiver, Args&& ... args)
 {
-    messagePtr<BaseMessage> msg(new T(transceiver, std::forward<Args>(args)...));
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        queueMessage<T>(&commitPostedMessage<T>, 0, transceiver, std::forward<Args>(args)...);
+        return;
+    }
+
+    postLocalMessage<T>(transceiver, std::forward<Args>(args)...);
+}
+
+/** \brief Queue a message posted from a thread other than the hub's own.
+ *
+ * \param commit The function that moves the message onto the hub when it is synced.
+ * \param receiverID The recipient, key, topic or due tick, depending on how the message was posted.
+ * \param args The sender and the message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageHub::queueMessage(MessageQueue::CommitFunc commit, ID receiverID, Args&& ... args)
+{
+    getProducerQueue().push<T>(commit, receiverID, std::forward<Args>(args)...);
+
+    //Pairs with the fence in waitForMessages, so either the waiting thread sees the message or this sees it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(waitingForMessages.load(std::memory_order_relaxed))
+        wake();
+}
+
+template<typename T, typename ... Args>
+void MessageHub::postLocalMessage(Args&& ... args)
+{
+    auto& msgSlot = getSlot<T>(messageBoard);
+    stampMessage(msgSlot.emplace(std::forward<Args>(args)...), T::getFamily(), PostKind::Posted);
+
+    auto family = T::getFamily();
+    if(msgSlot.size() == 1)
+        usedFamilies.push_back(family);
+
+    if(family < subscribers.size() && !subscribers[family].immediate.empty())
+        dispatchImmediate(family, msgSlot.size() - 1);
+}
+
+/** \brief Post a message and index it under a topic, so readers interested in one topic only visit its messages.
+ *         The message also appears in the unfiltered readPostedMessages<T>().
+ *
+ * \param topic The topic, e.g. a target object id or sender id.
+ * \param transceiver The sender.
+ * \param args The message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageHub::postTopicMessage(ID topic, const Transceiver& transceiver, Args&& ... args)
+{
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        queueMessage<T>(&commitTopicMessage<T>, topic, transceiver, std::forward<Args>(args)...);
+        return;
+    }
+
+    postLocalTopicMessage<T>(topic, transceiver, std::forward<Args>(args)...);
+}
+
+template<typename T, typename ... Args>
+void MessageHub::postLocalTopicMessage(ID topic, Args&& ... args)
+{
+    auto& msgSlot = getSlot<T>(messageBoard);
+
+    auto& msg = msgSlot.emplaceWithTopic(topic, std::forward<Args>(args)...);
+    static_cast<BaseMessage&>(msg).metadata.topic = topic;
+    stampMessage(msg, T::getFamily(), PostKind::Topic, topic);
+
+    auto family = T::getFamily();
+    if(msgSlot.size() == 1)
+        usedFamilies.push_back(family);
+
+    if(family < subscribers.size() && !subscribers[family].immediate.empty())
+        dispatchImmediate(family, msgSlot.size() - 1);
+}
+
+template<typename T>
+void MessageHub::commitTopicMessage(MessageHub& msgHub, void* queued, ID topic)
+{
+    T* msg = static_cast<T*>(queued);
+    msgHub.postLocalTopicMessage<T>(topic, std::move(*msg));
+    msg->~T();
+}
+
+/** \brief Get the messages of a type posted under a topic. In double-buffered mode these are from the previous frame.
+ *
+ * \param topic The topic to read.
+ * \return A view that only visits that topic's messages.
+ */
+template<typename T>
+TopicView<T> MessageHub::readPostedMessages(ID topic)
+{
+    MessageBoard& board = doubleBuffered ? readBoard : messageBoard;
+    auto family = T::getFamily();
+
+    if(family >= board.size() || !board[family])
+        return TopicView<T>();
+
+    auto view = static_cast<MessageSlot<T>&>(*board[family]).getTopicView(topic);
+
+    if(statistics && !view.empty())
+        statistics->recordRead(family, &view[0], view.size());
+
+    return view;
+}
+
+/** \brief Schedule a message to be posted at a time on the hub's clock. Times are rounded up to the next
+ *         millisecond. A time that has already passed posts the message right away.
+ *
+ * \param time The time in seconds, as returned by getTime.
+ * \param transceiver The sender.
+ * \param args The message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageHub::postMessageAt(double time, const Transceiver& transceiver, Args&& ... args)
+{
+    uint64_t dueTick = getTimerTick(time);
+
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        queueMessage<T>(&commitScheduledMessage<T>, dueTick, transceiver, std::forward<Args>(args)...);
+        return;
+    }
+
+    scheduleLocalMessage<T>(dueTick, transceiver, std::forward<Args>(args)...);
+}
+
+/** \brief Schedule a message to be posted once some time has passed on the hub's clock. The clock is only
+ *         read on the owner thread, so messages from other threads are timed from when the hub syncs them.
+ *
+ * \param delay The time to wait in seconds.
+ * \param transceiver The sender.
+ * \param args The message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageHub::postMessageAfter(double delay, const Transceiver& transceiver, Args&& ... args)
+{
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        //The delay's bits ride along in the queued message's id
+        ID delayBits = 0;
+        std::memcpy(&delayBits, &delay, sizeof(delay));
+
+        queueMessage<T>(&commitDelayedMessage<T>, delayBits, transceiver, std::forward<Args>(args)...);
+        return;
+    }
+
+    scheduleLocalMessage<T>(getTimerTick(currentTime + delay), transceiver, std::forward<Args>(args)...);
+}
+
+template<typename T, typename ... Args>
+void MessageHub::scheduleLocalMessage(uint64_t dueTick, Args&& ... args)
+{
+    if(dueTick <= currentTick)
+    {
+        postLocalMessage<T>(std::forward<Args>(args)...);
+        return;
+    }
+
+    auto family = T::getFamily();
+
+    if(family >= scheduledMessages.size())
+        scheduledMessages.resize(family + 1);
+
+    if(!scheduledMessages[family])
+        scheduledMessages[family].reset(new ScheduledMessageSlot<T>());
+
+    auto& msgSlot = static_cast<ScheduledMessageSlot<T>&>(*scheduledMessages[family]);
+    timers.schedule(dueTick, family, msgSlot.emplace(std::forward<Args>(args)...));
+}
+
+template<typename T>
+void MessageHub::commitScheduledMessage(MessageHub& msgHub, void* queued, ID dueTick)
+{
+    T* msg = static_cast<T*>(queued);
+    msgHub.scheduleLocalMessage<T>(dueTick, std::move(*msg));
+    msg->~T();
+}
+
+template<typename T>
+void MessageHub::commitDelayedMessage(MessageHub& msgHub, void* queued, ID delayBits)
+{
+    double delay = 0.0;
+    std::memcpy(&delay, &delayBits, sizeof(delay));
+
+    T* msg = static_cast<T*>(queued);
+    msgHub.scheduleLocalMessage<T>(getTimerTick(msgHub.currentTime + delay), std::move(*msg));
+    msg->~T();
+}
+
+template<typename T>
+void ScheduledMessageSlot<T>::deliver(MessageHub& msgHub, uint32_t index)
+{
+    msgHub.postLocalMessage<T>(std::move(at(index)));
+
+    at(index).~T();
+    live[index] = false;
+    freeIndices.push_back(index);
+}
+
+/** \brief Post a state update where only the newest message per key matters, e.g. keyed by object id.
+ *         If a message with the key is already on the board it is overwritten in place, so readers see
+ *         one message per key per frame, in the order each key was first posted. Immediate handlers
+ *         are called for every post. Deferred handlers that already saw the key are passed the new
+ *         value on the next dispatch.
+ *
+ * \param key The key to coalesce on.
+ * \param transceiver The sender.
+ * \param args The message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageHub::postCoalescedMessage(ID key, const Transceiver& transceiver, Args&& ... args)
+{
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        queueMessage<T>(&commitCoalescedMessage<T>, key, transceiver, std::forward<Args>(args)...);
+        return;
+    }
+
+    postLocalCoalescedMessage<T>(key, transceiver, std::forward<Args>(args)...);
+}
+
+template<typename T, typename ... Args>
+void MessageHub::postLocalCoalescedMessage(ID key, Args&& ... args)
+{
+    auto& msgSlot = getSlot<T>(messageBoard);
+    bool wasEmpty = (msgSlot.size() == 0);
+
+    std::size_t position = 0;
+    stampMessage(msgSlot.emplaceKeyed(key, position, std::forward<Args>(args)...), T::getFamily(), PostKind::Coalesced, key);
+
+    auto family = T::getFamily();
+    if(wasEmpty)
+        usedFamilies.push_back(family);
+
+    if(family >= subscribers.size())
+        return;
+
+    //The deferred handlers already saw the old value, so they get the new one on the next dispatch
+    auto& subList = subscribers[family];
+    if(position < subList.dispatched && !subList.deferred.empty() &&
+       std::find(subList.redispatch.begin(), subList.redispatch.end(), position) == subList.redispatch.end())
+        subList.redispatch.push_back(position);
+
+    if(!subList.immediate.empty())
+        dispatchImmediate(family, position);
+}
+
+template<typename T>
+void MessageHub::commitCoalescedMessage(MessageHub& msgHub, void* queued, ID key)
+{
+    T* msg = static_cast<T*>(queued);
+    msgHub.postLocalCoalescedMessage<T>(key, std::move(*msg));
+    msg->~T();
+}
+
+/** \brief Register a handler for a message type. Handlers are called in the order they subscribed.
+ *         A transceiver must unsubscribe before it is destroyed if its handler refers to it.
+ *
+ * \param transceiver The subscriber.
+ * \param handler The function to call with each message.
+ * \param mode Whether to call the handler as messages are posted or when dispatchMessages is called.
+ */
+template<typename T>
+void MessageHub::subscribe(const Transceiver& transceiver, std::function<void(const T&)> handler, DispatchMode mode)
+{
+    auto family = T::getFamily();
+
+    if(family >= subscribers.size())
+        subscribers.resize(family + 1);
+
+    auto& subList = subscribers[family];
+    Subscription subscription = {transceiver.getID(), [handler](const BaseMessage& msg) { handler(static_cast<const T&>(msg)); }, true};
 
-    messageBoard[T::getFamily()].push_back(msg);
+    if(mode == DispatchMode::Immediate)
+        subList.immediate.push_back(std::move(subscription));
+    else
+    {
+        //Only messages posted after subscribing are dispatched
+        if(subList.deferred.empty())
+        {
+            subList.dispatched = getSpan<T>(messageBoard).size();
+            subList.redispatch.clear();
+        }
+
+        if(std::find(deferredFamilies.begin(), deferredFamilies.end(), family) == deferredFamilies.end())
+            deferredFamilies.push_back(family);
+
+        subList.deferred.push_back(std::move(subscription));
+    }
 }
 
 template<typename T>
-std::vector<messagePtr<T>> MessageHub::readPostedMessages()
+void MessageHub::unsubscribe(const Transceiver& transceiver)
 {
-    std::vector<messagePtr<T>> msgSlot;
+    auto family = T::getFamily();
 
-    for(auto& baseMsg : messageBoard[T::getFamily()])
+    if(family < subscribers.size())
     {
-        auto msg = std::static_pointer_cast<T>(baseMsg);
-        msgSlot.push_back(msg);
+        removeSubscriptions(subscribers[family].immediate, transceiver.getID());
+        removeSubscriptions(subscribers[family].deferred, transceiver.getID());
     }
+}
 
-    return msgSlot;
+template<typename T>
+MessageSpan<T> MessageHub::readPostedMessages()
+{
+    auto span = getSpan<T>(doubleBuffered ? readBoard : messageBoard);
+
+    if(statistics && !span.empty())
+        statistics->recordRead(T::getFamily(), &span[0], span.size());
+
+    return span;
 }
 
+/** \brief Send a message to a single transceiver's mailbox. Messages sent from other threads are queued,
+ *         so this returns true for them and the overflow policy is applied when the hub syncs.
+ *
+ * \param receiverID The recipient's id.
+ * \param transceiver The sender.
+ * \param args The message's constructor arguments.
+ * \return False if the mailbox was full and its policy is Reject.
+ */
 template<typename T, typename ... Args>
-void MessageHub::sendPrivateMessage(ID receiverID, const Transceiver& transceiver, Args&& ... args)
+bool MessageHub::sendPrivateMessage(ID receiverID, const Transceiver& transceiver, Args&& ... args)
 {
-    messagePtr<BaseMessage> msg( new T(transceiver, std::forward<Args>(args)...) );
+    if(std::this_thread::get_id() != ownerThread)
+    {
+        queueMessage<T>(&commitPrivateMessage<T>, receiverID, transceiver, std::forward<Args>(args)...);
+        return true;
+    }
 
-    privateMessages[receiverID][T::getFamily()].push_back(msg);
+    return deliverPrivateMessage<T>(receiverID, transceiver, std::forward<Args>(args)...);
+}
+
+template<typename T, typename ... Args>
+bool MessageHub::deliverPrivateMessage(ID receiverID, Args&& ... args)
+{
+    auto& mailbox = getMailbox(receiverID);
+    auto family = T::getFamily();
+
+    if(family >= mailbox.slots.size())
+        mailbox.slots.resize(family + 1);
+
+    if(!mailbox.slots[family])
+        mailbox.slots[family].reset(new MailboxSlot<T>(mailbox.capacity));
+
+    bool dropped = false;
+    T* msg = static_cast<MailboxSlot<T>&>(*mailbox.slots[family]).emplace(mailbox.policy, dropped, std::forward<Args>(args)...);
+
+    if(dropped)
+        ++mailbox.dropped;
+
+    //Only a rejected message is reported to the sender. DropNewest discards it quietly.
+    if(!msg)
+        return mailbox.policy != OverflowPolicy::Reject;
+
+    stampMessage(*msg, family, PostKind::Private, receiverID);
+    return true;
 }
 
 template<typename T>
-std::vector<messagePtr<T>> MessageHub::readPrivateMessages(const Transceiver& transceiver)
+void MessageHub::commitPostedMessage(MessageHub& msgHub, void* queued, ID)
 {
-    std::vector<messagePtr<T>> messages;
+    T* msg = static_cast<T*>(queued);
+    msgHub.postLocalMessage<T>(std::move(*msg));
+    msg->~T();
+}
 
-    auto& privateMsgSlot = privateMessages[transceiver.getID()][T::getFamily()];
-    for(auto& msg : privateMsgSlot)
+template<typename T>
+void MessageHub::commitPrivateMessage(MessageHub& msgHub, void* queued, ID receiverID)
+{
+    T* msg = static_cast<T*>(queued);
+    msgHub.deliverPrivateMessage<T>(receiverID, std::move(*msg));
+    msg->~T();
+}
+
+template<typename T>
+MessageSpan<T> MessageHub::readPrivateMessages(const Transceiver& transceiver)
+{
+    auto mailbox = mailboxes.find(transceiver.getID());
+    if(mailbox == mailboxes.end())
+        return MessageSpan<T>();
+
+    auto family = T::getFamily();
+    auto& slots = mailbox->second.slots;
+
+    if(family >= slots.size() || !slots[family])
+        return MessageSpan<T>();
+
+    auto span = static_cast<MailboxSlot<T>&>(*slots[family]).consume();
+
+    if(statistics && !span.empty())
+        statistics->recordRead(family, &span[0], span.size());
+
+    return span;
+}
+
+inline void MessageHub::stampMessage(BaseMessage& msg, Family family, PostKind kind, ID key)
+{
+    msg.metadata.frame = currentFrame;
+    msg.metadata.sequence = messageSequence++;
+
+    if(statistics)
+        statistics->recordPost(family);
+
+    if(!taps.empty())
+        tapMessage(msg, family, kind, key);
+}
+
+template<typename T>
+void MessageHub::setMessageName(const std::string& name)
+{
+    if(statistics)
+        statistics->setName(T::getFamily(), name);
+}
+
+template<typename T>
+void MessageHub::postDecodedMessage(T&& msg, PostKind kind, ID key)
+{
+    switch(kind)
     {
-        messagePtr<T> message = std::static_pointer_cast<T>(msg);
+        case PostKind::Posted:
+            postLocalMessage<T>(std::move(msg));
+            break;
 
-        if(message)
-            messages.push_back(message);
+        case PostKind::Private:
+            deliverPrivateMessage<T>(key, std::move(msg));
+            break;
+
+        case PostKind::Coalesced:
+            postLocalCoalescedMessage<T>(key, std::move(msg));
+            break;
+
+        case PostKind::Topic:
+            postLocalTopicMessage<T>(key, std::move(msg));
+            break;
     }
+}
+
+template<typename T>
+MessageSlot<T>& MessageHub::getSlot(MessageBoard& board)
+{
+    auto family = T::getFamily();
+
+    if(family >= board.size())
+        board.resize(family + 1);
+
+    if(!board[family])
+        board[family].reset(new MessageSlot<T>());
+
+    return static_cast<MessageSlot<T>&>(*board[family]);
+}
+
+template<typename T>
+MessageSpan<T> MessageHub::getSpan(MessageBoard& board)
+{
+    auto family = T::getFamily();
+
+    if(family >= board.size() || !board[family])
+        return MessageSpan<T>();
 
-    return messages;
+    return static_cast<MessageSlot<T>&>(*board[family]).getSpan();
 }
 
 }//ocs
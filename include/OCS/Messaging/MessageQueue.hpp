@@ -0,0 +1,156 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MESSAGEQUEUE_H
+#define OCS_MESSAGEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "OCS/Misc/Config.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+
+namespace ocs
+{
+
+class MessageHub;
+
+/** \brief A lock-free single producer, single consumer queue of messages of any type. Each thread that posts to a
+ *         MessageHub it does not own gets one. Messages are constructed in place in large chunks, and the hub's
+ *         thread moves them onto its board when it drains the queue at a sync point.
+ *
+ *         The producer publishes each message by advancing its chunk's committed size, and links a new chunk when the
+ *         current one is full. The consumer frees chunks it has finished with, so neither side ever waits on the other.
+ *
+ *         Each message is stamped with the producing thread's sort key. The hub commits the messages from every queue
+ *         in order of their keys, so messages posted by systems running on different threads reach the board in the
+ *         order the systems were scheduled, not the order the threads happened to run them in.
+ */
+class MessageQueue : NonCopyable
+{
+    public:
+
+        //!Moves a queued message onto the hub and destroys the queued copy.
+        using CommitFunc = void (*)(MessageHub&, void*, ID);
+
+        //!A published message found by collect, which is committed once the messages from every queue are sorted.
+        struct PendingMessage
+        {
+            uint64_t sortKey;
+            char* record;
+        };
+
+        //!Set the sort key stamped on the messages the calling thread queues from now on.
+        static void setSortKey(uint64_t);
+        static uint64_t getSortKey();
+
+        //!Move a collected message onto the hub and destroy the queued copy.
+        static void commit(MessageHub&, const PendingMessage&);
+
+        explicit MessageQueue(std::thread::id);
+        ~MessageQueue();
+
+        //!Construct a message at the end of the queue. Must only be called from the producer thread.
+        template<typename T, typename ... Args>
+        void push(CommitFunc, ID, Args&& ...);
+
+        //!Append every published message to a list without committing it. Must only be called from the consumer thread.
+        void collect(std::vector<PendingMessage>&);
+
+        //!Free the space of the messages found by the last collect. They must all have been committed.
+        void release();
+
+        std::thread::id getProducer() const { return producer; }
+
+        //!The next queue in the hub's list of producer queues.
+        MessageQueue* nextQueue;
+
+    private:
+
+        static const std::size_t chunkSize = 64 * 1024;
+        static const std::size_t alignment = alignof(std::max_align_t);
+
+        struct Chunk
+        {
+            explicit Chunk(std::size_t);
+            ~Chunk();
+
+            std::atomic<std::size_t> committed;
+            std::atomic<Chunk*> next;
+            std::size_t capacity;
+            char* data;
+        };
+
+        struct RecordHeader
+        {
+            CommitFunc commit;
+            ID receiverID;
+            uint64_t sortKey;
+            std::size_t size;
+        };
+
+        static std::size_t alignSize(std::size_t size) { return (size + alignment - 1) & ~(alignment - 1); }
+
+        //!Get space for a record of the given size, linking a new chunk if the current one is full.
+        char* reserve(std::size_t);
+
+        std::thread::id producer;
+
+        //!Only touched by the producer.
+        Chunk* writeChunk;
+        std::size_t writeOffset;
+
+        //!Only touched by the consumer.
+        Chunk* readChunk;
+        std::size_t readOffset;
+
+        //!Where the last collect stopped. Only touched by the consumer.
+        Chunk* collectChunk;
+        std::size_t collectOffset;
+};
+
+/** \brief Construct a message in the queue and publish it to the consumer.
+ *
+ * \param commit The function that moves the message onto the hub.
+ * \param receiverID The recipient for private messages.
+ * \param args The message's constructor arguments.
+ */
+template<typename T, typename ... Args>
+void MessageQueue::push(CommitFunc commit, ID receiverID, Args&& ... args)
+{
+    std::size_t recordSize = alignSize(sizeof(RecordHeader)) + alignSize(sizeof(T));
+    char* record = reserve(recordSize);
+
+    new (record) RecordHeader{commit, receiverID, getSortKey(), recordSize};
+    new (record + alignSize(sizeof(RecordHeader))) T(std::forward<Args>(args)...);
+
+    writeOffset += recordSize;
+    writeChunk->committed.store(writeOffset, std::memory_order_release);
+}
+
+}//ocs
+
+#endif
@@ -0,0 +1,228 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MESSAGERECORDING_H
+#define OCS_MESSAGERECORDING_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "OCS/Messaging/MessageHub.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
+
+namespace ocs
+{
+
+/** \brief Records the messages posted to a MessageHub to a compact binary log, one frame at a time.
+ *
+ *         Recording is opt-in per message type. A bound type must have a writeBinary(BinaryWriter&) const
+ *         member, and a constructor taking (const Transceiver&, BinaryReader&) so a MessageReplayer can rebuild it.
+ *         Messages are encoded into memory on the hub's thread, and each finished frame is handed to a
+ *         background thread that writes it to the file.
+ *
+ *         e.g.
+ *             MessageRecorder recorder;
+ *             recorder.bindMessageType<Explosion>("Explosion");
+ *             recorder.start("session.ocsm");
+ *             msgHub.addMessageTap(&recorder);
+ *
+ *         Log format: "OCSM", u32 version, then a list of records. Each record starts with a tag byte:
+ *             Type    - varint type index, string name. Written before a type's first message.
+ *             Message - varint type index, u8 post kind, varint key (not for plain posts), varint sender,
+ *                       varint payload size, payload.
+ *             Frame   - marks the end of a frame.
+ */
+class MessageRecorder : public MessageTap, NonCopyable
+{
+    public:
+
+        MessageRecorder();
+        ~MessageRecorder();
+
+        //!Record messages of this type under the given name.
+        template<typename T>
+        void bindMessageType(const std::string&);
+
+        //!Open the log file and start the writer thread.
+        bool start(const std::string&);
+
+        //!Write everything recorded so far, then close the file and stop the writer thread.
+        void stop();
+
+        bool isRecording() const { return recording; }
+
+        //!Get the number of messages recorded since start.
+        std::size_t getTotalRecorded() const { return totalRecorded; }
+
+        static const uint32_t formatVersion = 1;
+
+    private:
+
+        friend class MessageReplayer;
+
+        enum Tag : uint8_t
+        {
+            TypeTag,
+            MessageTag,
+            FrameTag
+        };
+
+        using Encoder = void (*)(const BaseMessage&, BinaryWriter&);
+
+        struct BoundType
+        {
+            Encoder encode;
+            std::string name;
+
+            //!Set once the type's record has been written to the current log
+            bool written;
+            uint32_t index;
+        };
+
+        template<typename T>
+        static void encodeMessage(const BaseMessage& msg, BinaryWriter& out) { static_cast<const T&>(msg).writeBinary(out); }
+
+        //!Encode a message if its type is bound.
+        void onMessage(const BaseMessage&, Family, PostKind, ID);
+
+        //!Mark the end of a frame and hand the frame's bytes to the writer thread.
+        void onFrameEnd();
+
+        void writerLoop();
+
+        //!Bound types indexed by message family.
+        std::vector<BoundType> boundTypes;
+        uint32_t totalTypesWritten;
+
+        //!The current frame's records, only touched by the hub's thread.
+        BinaryWriter frameBuffer;
+        BinaryWriter payload;
+
+        bool recording;
+        std::size_t totalRecorded;
+
+        //!Bytes waiting for the writer thread.
+        std::vector<char> pendingBytes;
+        bool stopping;
+        std::mutex pendingMutex;
+        std::condition_variable pendingCondition;
+
+        std::ofstream file;
+        std::thread writer;
+};
+
+/** \brief Reads a log written by a MessageRecorder and posts its messages to a MessageHub one recorded frame
+ *         at a time, the same way they were posted originally, including the original sender ids. Messages
+ *         of types that are not bound are skipped.
+ */
+class MessageReplayer : NonCopyable
+{
+    public:
+
+        MessageReplayer();
+
+        //!Rebuild messages recorded under the given name as this type.
+        template<typename T>
+        void bindMessageType(const std::string&);
+
+        //!Load a log file. Returns false if it cannot be read or is not a message log.
+        bool open(const std::string&);
+
+        //!Post the next recorded frame's messages. Returns false once every frame has been replayed.
+        bool replayFrame(MessageHub&);
+
+        bool isFinished() const { return position >= log.size(); }
+
+        //!Get the number of frames replayed so far.
+        uint64_t getFramesReplayed() const { return framesReplayed; }
+
+    private:
+
+        using Decoder = void (*)(MessageHub&, const Transceiver&, BinaryReader&, PostKind, ID);
+
+        //!A transceiver whose id can be changed, so replayed messages keep their original sender.
+        struct ReplaySender : public Transceiver
+        {
+            void setID(ID senderID) { id = senderID; }
+        };
+
+        template<typename T>
+        static void decodeMessage(MessageHub&, const Transceiver&, BinaryReader&, PostKind, ID);
+
+        std::unordered_map<std::string, Decoder> decoders;
+
+        //!Decoders indexed by the type index used in the log, nullptr for unbound types.
+        std::vector<Decoder> logDecoders;
+
+        std::vector<char> log;
+        std::size_t position;
+        uint64_t framesReplayed;
+
+        ReplaySender sender;
+};
+
+/** \brief Bind a message type for recording. Must be called before messages of the type are posted.
+ *
+ * \param name The name stored in the log. The replayer must bind the type under the same name.
+ */
+template<typename T>
+void MessageRecorder::bindMessageType(const std::string& name)
+{
+    auto family = T::getFamily();
+
+    if(family >= boundTypes.size())
+        boundTypes.resize(family + 1, BoundType{nullptr, std::string(), false, 0});
+
+    boundTypes[family].encode = &encodeMessage<T>;
+    boundTypes[family].name = name;
+}
+
+template<typename T>
+void MessageReplayer::bindMessageType(const std::string& name)
+{
+    decoders[name] = &decodeMessage<T>;
+}
+
+template<typename T>
+void MessageReplayer::decodeMessage(MessageHub& msgHub, const Transceiver& msgSender, BinaryReader& in, PostKind kind, ID key)
+{
+    T msg(msgSender, in);
+
+    if(!in.isGood())
+    {
+        std::cerr << "Error: Recorded message could not be decoded\n";
+        return;
+    }
+
+    msgHub.postDecodedMessage(std::move(msg), kind, key);
+}
+
+}//ocs
+
+#endif
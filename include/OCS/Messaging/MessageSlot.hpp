@@ -0,0 +1,354 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MESSAGESLOT_H
+#define OCS_MESSAGESLOT_H
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "OCS/Messaging/CoalescingIndex.hpp"
+#include "OCS/Messaging/Message.hpp"
+
+namespace ocs
+{
+
+/** \brief A non-owning view of messages of one type stored contiguously in the MessageHub.
+ *         It stays valid until a message of the same type is posted or the slot is cleared.
+ *
+ *         e.g.
+ *             for(const auto& msg : msgHub.readPostedMessages<TextMessage>())
+ *                 std::cout << msg.msg;
+ */
+template<typename T>
+class MessageSpan
+{
+    public:
+
+        MessageSpan() : first(nullptr), count(0) {}
+        MessageSpan(T* _first, std::size_t _count) : first(_first), count(_count) {}
+
+        T* begin() const { return first; }
+        T* end() const { return first + count; }
+
+        T& operator[](std::size_t index) const { return first[index]; }
+
+        T& front() const { return first[0]; }
+        T& back() const { return first[count - 1]; }
+
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+    private:
+
+        T* first;
+        std::size_t count;
+};
+
+/** \brief A non-owning view of the messages of one type that were posted under a topic, in the order they were posted.
+ *         Like MessageSpan, it stays valid until a message of the same type is posted or the slot is cleared.
+ */
+template<typename T>
+class TopicView
+{
+    public:
+
+        class iterator
+        {
+            public:
+
+                iterator(T* _messages, const uint32_t* _position) : messages(_messages), position(_position) {}
+
+                T& operator*() const { return messages[*position]; }
+                T* operator->() const { return &messages[*position]; }
+
+                iterator& operator++() { ++position; return *this; }
+
+                bool operator==(const iterator& other) const { return position == other.position; }
+                bool operator!=(const iterator& other) const { return position != other.position; }
+
+            private:
+
+                T* messages;
+                const uint32_t* position;
+        };
+
+        TopicView() : messages(nullptr), positions(nullptr), count(0) {}
+        TopicView(T* _messages, const uint32_t* _positions, std::size_t _count) : messages(_messages), positions(_positions), count(_count) {}
+
+        iterator begin() const { return iterator(messages, positions); }
+        iterator end() const { return iterator(messages, positions + count); }
+
+        T& operator[](std::size_t index) const { return messages[positions[index]]; }
+
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+    private:
+
+        T* messages;
+        const uint32_t* positions;
+        std::size_t count;
+};
+
+/** \brief The positions of a slot's messages grouped by topic. Each topic's list is kept when the slot is
+ *         cleared so busy topics stop allocating after the first few frames.
+ */
+struct TopicIndex
+{
+    TopicIndex() : used(0) {}
+
+    void add(ID topic, uint32_t position)
+    {
+        bool inserted = false;
+        uint32_t bucket = index.findOrInsert(topic, used, inserted);
+
+        if(inserted && ++used > buckets.size())
+            buckets.emplace_back();
+
+        buckets[bucket].push_back(position);
+    }
+
+    void clear()
+    {
+        for(std::size_t i = 0; i < used; ++i)
+            buckets[i].clear();
+
+        index.clear();
+        used = 0;
+    }
+
+    CoalescingIndex index;
+    std::vector<std::vector<uint32_t>> buckets;
+    std::size_t used;
+};
+
+/** \brief Type-erased interface to a MessageSlot so the hub can clear and log every message type.
+ */
+class BaseMessageSlot
+{
+    public:
+
+        virtual ~BaseMessageSlot() {}
+
+        virtual void clear() = 0;
+        virtual void log(std::ostream&) = 0;
+        virtual std::size_t size() const = 0;
+        virtual BaseMessage& get(std::size_t) = 0;
+
+        //!Copy a message out of the slot for its handlers, since a handler may post the same type and move the slot's storage.
+        virtual const BaseMessage& beginDispatch(std::size_t) = 0;
+
+        //!Release the copy made by the matching beginDispatch.
+        virtual void endDispatch() = 0;
+
+        //!Get the memory held for the slot's messages.
+        virtual std::size_t getAllocatedBytes() const = 0;
+};
+
+/** \brief Stores all messages of one type by value. Clearing keeps the memory, so once a slot has
+ *         grown to a frame's worth of messages posting no longer allocates.
+ */
+template<typename T>
+class MessageSlot : public BaseMessageSlot
+{
+    public:
+
+        template<typename ... Args>
+        T& emplace(Args&& ... args)
+        {
+            messages.emplace_back(std::forward<Args>(args)...);
+            return messages.back();
+        }
+
+        /** \brief Construct a keyed message. If a message with the same key is already in the slot it is overwritten in place.
+         *
+         * \param key The message key.
+         * \param position Set to the message's position in the slot.
+         * \return The stored message.
+         */
+        template<typename ... Args>
+        T& emplaceKeyed(ID key, std::size_t& position, Args&& ... args)
+        {
+            if(!keyIndex)
+                keyIndex.reset(new CoalescingIndex());
+
+            bool inserted = false;
+            position = keyIndex->findOrInsert(key, messages.size(), inserted);
+
+            if(inserted)
+                return emplace(std::forward<Args>(args)...);
+
+            messages[position] = T(std::forward<Args>(args)...);
+            return messages[position];
+        }
+
+        //!Construct a message and add it to a topic's list.
+        template<typename ... Args>
+        T& emplaceWithTopic(ID topic, Args&& ... args)
+        {
+            if(!topics)
+                topics.reset(new TopicIndex());
+
+            T& msg = emplace(std::forward<Args>(args)...);
+            topics->add(topic, messages.size() - 1);
+
+            return msg;
+        }
+
+        MessageSpan<T> getSpan() { return MessageSpan<T>(messages.data(), messages.size()); }
+
+        TopicView<T> getTopicView(ID topic)
+        {
+            uint32_t bucket = 0;
+            if(!topics || !topics->index.find(topic, bucket))
+                return TopicView<T>();
+
+            const auto& positions = topics->buckets[bucket];
+            return TopicView<T>(messages.data(), positions.data(), positions.size());
+        }
+
+        void clear()
+        {
+            messages.clear();
+
+            if(keyIndex)
+                keyIndex->clear();
+
+            if(topics)
+                topics->clear();
+        }
+
+        void log(std::ostream& out)
+        {
+            for(auto& msg : messages)
+            {
+                out << msg.getTimeStamp() << " (frame " << msg.getMetadata().frame << ", #" << msg.getMetadata().sequence << ")" << std::endl;
+                msg.log(out);
+                out << std::endl;
+            }
+        }
+
+        std::size_t size() const { return messages.size(); }
+
+        T& get(std::size_t index) { return messages[index]; }
+
+        const T& beginDispatch(std::size_t index)
+        {
+            dispatching.push_back(messages[index]);
+            return dispatching.back();
+        }
+
+        void endDispatch() { dispatching.pop_back(); }
+
+        std::size_t getAllocatedBytes() const { return messages.capacity() * sizeof(T); }
+
+    private:
+
+        std::vector<T> messages;
+
+        //!Copies of the messages being dispatched, one per nested dispatch. A deque so a nested copy doesn't move the outer ones.
+        std::deque<T> dispatching;
+
+        //!Created the first time a keyed message is posted.
+        std::unique_ptr<CoalescingIndex> keyIndex;
+
+        //!Created the first time a message is posted under a topic.
+        std::unique_ptr<TopicIndex> topics;
+};
+
+class MessageHub;
+
+/** \brief Type-erased interface to a ScheduledMessageSlot so the hub can deliver messages whose timers fired.
+ */
+class BaseScheduledMessageSlot
+{
+    public:
+
+        virtual ~BaseScheduledMessageSlot() {}
+
+        //!Post a stored message to the hub and free its place.
+        virtual void deliver(MessageHub&, uint32_t) = 0;
+};
+
+/** \brief Holds messages of one type that are waiting for their delivery time. Freed places are reused, and
+ *         the storage never moves, so scheduling does not allocate once the slot has grown.
+ */
+template<typename T>
+class ScheduledMessageSlot : public BaseScheduledMessageSlot
+{
+    public:
+
+        ~ScheduledMessageSlot()
+        {
+            for(std::size_t i = 0; i < live.size(); ++i)
+                if(live[i])
+                    at(i).~T();
+        }
+
+        //!Construct a message and return its index.
+        template<typename ... Args>
+        uint32_t emplace(Args&& ... args)
+        {
+            uint32_t index = 0;
+
+            if(!freeIndices.empty())
+            {
+                index = freeIndices.back();
+                freeIndices.pop_back();
+            }
+            else
+            {
+                index = storage.size();
+                storage.emplace_back();
+                live.push_back(false);
+            }
+
+            new (&storage[index]) T(std::forward<Args>(args)...);
+            live[index] = true;
+
+            return index;
+        }
+
+        void deliver(MessageHub&, uint32_t);
+
+    private:
+
+        using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+        T& at(std::size_t index) { return *reinterpret_cast<T*>(&storage[index]); }
+
+        std::deque<Storage> storage;
+        std::vector<bool> live;
+        std::vector<uint32_t> freeIndices;
+};
+
+//!A slot for each message family, indexed by the family.
+using MessageBoard = std::vector<std::unique_ptr<BaseMessageSlot>>;
+
+}//ocs
+
+#endif
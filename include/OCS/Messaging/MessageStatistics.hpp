@@ -0,0 +1,216 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MESSAGESTATISTICS_H
+#define OCS_MESSAGESTATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OCS/Messaging/Message.hpp"
+#include "OCS/Misc/Config.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+
+namespace ocs
+{
+
+/** \brief Counts durations in nanoseconds in power of two buckets. Bucket 0 holds zero, and bucket i holds
+ *         durations from 2^(i-1) up to 2^i, so recording is a couple of instructions and the whole range
+ *         fits in a fixed array.
+ */
+class LatencyHistogram
+{
+    public:
+
+        static const std::size_t totalBuckets = 64;
+
+        LatencyHistogram();
+
+        void record(uint64_t nanoseconds)
+        {
+            ++buckets[getBucketIndex(nanoseconds)];
+            ++totalSamples;
+            totalNanoseconds += nanoseconds;
+            if(nanoseconds > maxNanoseconds)
+                maxNanoseconds = nanoseconds;
+        }
+
+        //!Add another histogram's samples to this one.
+        void merge(const LatencyHistogram&);
+
+        void clear();
+
+        //!Get an upper bound on the duration the given fraction of samples are at or below, e.g. 0.99.
+        uint64_t getPercentile(double) const;
+
+        //!Get the largest duration in the given bucket.
+        static uint64_t getBucketLimit(std::size_t);
+
+        uint64_t getBucket(std::size_t index) const { return buckets[index]; }
+        uint64_t getTotalSamples() const { return totalSamples; }
+        uint64_t getMax() const { return maxNanoseconds; }
+        double getMean() const { return totalSamples ? static_cast<double>(totalNanoseconds) / totalSamples : 0.0; }
+
+    private:
+
+        static std::size_t getBucketIndex(uint64_t nanoseconds)
+        {
+            std::size_t index = 0;
+            while(nanoseconds != 0 && index < totalBuckets - 1)
+            {
+                nanoseconds >>= 1;
+                ++index;
+            }
+
+            return index;
+        }
+
+        uint64_t buckets[totalBuckets];
+        uint64_t totalSamples;
+        uint64_t totalNanoseconds;
+        uint64_t maxNanoseconds;
+};
+
+//!Traffic of one message family, as collected by MessageStatistics.
+struct MessageFamilyStatistics
+{
+    //!The name set with MessageHub::setMessageName, used in the JSON dump.
+    std::string name;
+
+    uint64_t totalPosts = 0;
+    uint64_t totalReads = 0;
+
+    uint64_t lastFramePosts = 0;
+    uint64_t lastFrameReads = 0;
+
+    uint64_t peakPostsPerFrame = 0;
+    uint64_t peakReadsPerFrame = 0;
+
+    //!The most messages of the family on the board at the end of a frame.
+    std::size_t peakSlotSize = 0;
+
+    //!Memory held by the family's board slots and mailboxes when the statistics were last fetched.
+    std::size_t allocatedBytes = 0;
+
+    //!Time from a message being created to being read, sampled on some reads.
+    LatencyHistogram latency;
+
+    //!Counts for the frame in progress.
+    uint64_t framePosts = 0;
+    uint64_t frameReads = 0;
+};
+
+/** \brief Optional per-family traffic statistics for a MessageHub, turned on with MessageHub::enableStatistics.
+ *
+ *         Posts are counted on the hub's thread, which is where every message is committed. Reads may happen
+ *         on any thread, so each reading thread counts into its own block, and the blocks are added up in
+ *         endFrame. Read latency is only measured on every Nth read of each thread, which keeps the cost of
+ *         reading the clock off most reads.
+ */
+class MessageStatistics : NonCopyable
+{
+    public:
+
+        explicit MessageStatistics(unsigned int);
+
+        //!Count a message reaching the board or a mailbox. Must be called on the hub's thread.
+        void recordPost(Family family)
+        {
+            if(family >= families.size())
+                families.resize(family + 1);
+
+            ++families[family].framePosts;
+        }
+
+        //!Count a read of some messages. The first message is the oldest, and is used when the latency is sampled.
+        void recordRead(Family, const BaseMessage*, std::size_t);
+
+        //!Note how many messages of a family are on the board at the end of a frame.
+        void recordSlotSize(Family, std::size_t);
+
+        //!Add to the memory a family is using. Called by the hub when the statistics are fetched.
+        void addAllocatedBytes(Family, std::size_t);
+        void clearAllocatedBytes();
+
+        //!Add up each thread's counts and start a new frame. No other thread may be reading messages.
+        void endFrame();
+
+        void setName(Family, const std::string&);
+
+        //!Get a family's statistics, or nullptr if nothing has been recorded for it.
+        const MessageFamilyStatistics* getFamily(Family) const;
+
+        template<typename T>
+        const MessageFamilyStatistics* getFamily() const { return getFamily(T::getFamily()); }
+
+        std::size_t getTotalFamilies() const { return families.size(); }
+
+        //!Get the number of frames that have ended since the statistics were enabled or reset.
+        uint64_t getFramesRecorded() const { return framesRecorded; }
+
+        unsigned int getSampleInterval() const { return sampleInterval; }
+
+        //!Write every family with any traffic as a JSON object.
+        void writeJson(std::ostream&) const;
+
+        //!Zero every count, keeping the names.
+        void reset();
+
+    private:
+
+        //!The counts of one reading thread. Only that thread writes to them until they are added up.
+        struct ThreadCounters
+        {
+            std::thread::id thread;
+            std::vector<uint64_t> reads;
+            std::vector<LatencyHistogram> latency;
+
+            //!Families with latency samples, so adding up skips the empty histograms.
+            std::vector<Family> sampledFamilies;
+            unsigned int readsUntilSample;
+        };
+
+        //!Get the calling thread's counters, creating them on first use.
+        ThreadCounters& getThreadCounters();
+
+        std::vector<MessageFamilyStatistics> families;
+        uint64_t framesRecorded;
+        unsigned int sampleInterval;
+
+        std::mutex countersMutex;
+        std::vector<std::unique_ptr<ThreadCounters>> threadCounters;
+
+        //!Tells instances apart in each thread's cached counter lookup.
+        uint64_t instanceID;
+
+        static std::atomic<uint64_t> instanceCounter;
+};
+
+}//ocs
+
+#endif
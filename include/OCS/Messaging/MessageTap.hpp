@@ -0,0 +1,66 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_MESSAGETAP_H
+#define OCS_MESSAGETAP_H
+
+#include <cstdint>
+
+#include "OCS/Messaging/Message.hpp"
+#include "OCS/Misc/Config.hpp"
+
+namespace ocs
+{
+
+//!How a message was put on the hub. Passed to taps so the message can be reproduced the same way.
+enum class PostKind : uint8_t
+{
+    Posted,
+    Private,
+    Coalesced,
+    Topic
+};
+
+/** \brief Base class for anything that wants to see every message as it reaches a MessageHub's board or a
+ *         mailbox, such as the MessageRecorder. Taps are added with MessageHub::addMessageTap and are called
+ *         on the hub's thread.
+ */
+class MessageTap
+{
+    public:
+
+        virtual ~MessageTap() {}
+
+    protected:
+
+        friend class MessageHub;
+
+        //!Called for each message with its family, how it was posted, and its mailbox, coalescing key or topic.
+        virtual void onMessage(const BaseMessage&, Family, PostKind, ID) = 0;
+
+        //!Called when the hub moves to the next frame.
+        virtual void onFrameEnd() {}
+};
+
+}//ocs
+
+#endif
@@ -0,0 +1,242 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_SHAREDMESSAGETRANSPORT_H
+#define OCS_SHAREDMESSAGETRANSPORT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OCS/Messaging/MessageHub.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
+
+namespace ocs
+{
+
+/** \brief The start of a shared memory message ring. The ring's bytes follow the header.
+ *
+ *         The writer only moves writeIndex and the reader only moves readIndex. Both only ever grow, and
+ *         are kept on their own cache lines so the two processes do not fight over them.
+ */
+struct SharedRingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;
+
+    alignas(64) std::atomic<uint64_t> writeIndex;
+    std::atomic<uint64_t> droppedMessages;
+
+    alignas(64) std::atomic<uint64_t> readIndex;
+};
+
+//!The fixed part of each message in a shared ring. The payload follows it, padded to 8 bytes.
+struct SharedRecordHeader
+{
+    uint32_t payloadSize;
+    PostKind kind;
+    uint64_t typeHash;
+    uint64_t sender;
+    uint64_t key;
+};
+
+/** \brief Mirrors chosen message types from a MessageHub into a shared memory ring, so another process can
+ *         read them with a SharedMessageReader.
+ *
+ *         Like the MessageRecorder, a bound type must have a writeBinary(BinaryWriter&) const member and a
+ *         constructor taking (const Transceiver&, BinaryReader&). The writer never waits for the reader. If the
+ *         ring is full the message is dropped and counted instead.
+ *
+ *         e.g.
+ *             SharedMessageWriter writer;
+ *             writer.bindMessageType<Explosion>("Explosion");
+ *             writer.create("/game-events");
+ *             msgHub.addMessageTap(&writer);
+ */
+class SharedMessageWriter : public MessageTap, NonCopyable
+{
+    public:
+
+        SharedMessageWriter();
+        ~SharedMessageWriter();
+
+        //!Send messages of this type under the given name.
+        template<typename T>
+        void bindMessageType(const std::string&);
+
+        //!Create the shared memory object and its ring. The capacity is rounded up to a power of two.
+        bool create(const std::string&, std::size_t = 1 << 20);
+
+        //!Unmap and remove the shared memory object. Readers that already opened it keep their mapping.
+        void close();
+
+        bool isOpen() const { return ring != nullptr; }
+
+        //!Get the number of messages written to the ring.
+        std::size_t getTotalSent() const { return totalSent; }
+
+        //!Get the number of messages dropped because the ring was full.
+        uint64_t getDroppedMessages() const;
+
+    private:
+
+        using Encoder = void (*)(const BaseMessage&, BinaryWriter&);
+
+        struct BoundType
+        {
+            Encoder encode;
+            uint64_t typeHash;
+        };
+
+        template<typename T>
+        static void encodeMessage(const BaseMessage& msg, BinaryWriter& out) { static_cast<const T&>(msg).writeBinary(out); }
+
+        //!Copy a message into the ring if its type is bound.
+        void onMessage(const BaseMessage&, Family, PostKind, ID);
+
+        //!Bound types indexed by message family.
+        std::vector<BoundType> boundTypes;
+
+        BinaryWriter payload;
+
+        std::string name;
+        std::size_t mappedSize;
+        SharedRingHeader* ring;
+        char* data;
+        uint64_t mask;
+
+        //!The writer's copy of the indices, so the shared ones are only read when the ring looks full.
+        uint64_t writeIndex;
+        uint64_t cachedReadIndex;
+
+        std::size_t totalSent;
+};
+
+/** \brief Reads messages from a ring created by a SharedMessageWriter in another process and posts them to a
+ *         local MessageHub the same way they were posted originally, as the same message types. Messages of
+ *         types that are not bound are skipped.
+ *
+ *         e.g.
+ *             SharedMessageReader reader;
+ *             reader.bindMessageType<Explosion>("Explosion");
+ *             reader.open("/game-events");
+ *             ...each frame...
+ *             reader.poll(msgHub);
+ */
+class SharedMessageReader : NonCopyable
+{
+    public:
+
+        SharedMessageReader();
+        ~SharedMessageReader();
+
+        //!Rebuild messages sent under the given name as this type.
+        template<typename T>
+        void bindMessageType(const std::string&);
+
+        //!Map a ring created by a writer. Returns false if it does not exist or is not a message ring.
+        bool open(const std::string&);
+
+        void close();
+
+        bool isOpen() const { return ring != nullptr; }
+
+        //!Post the messages waiting in the ring. Returns the number of messages read.
+        std::size_t poll(MessageHub&, std::size_t = 0);
+
+        //!Get the number of messages the writer dropped because the ring was full.
+        uint64_t getDroppedMessages() const;
+
+    private:
+
+        using Decoder = void (*)(MessageHub&, const Transceiver&, BinaryReader&, PostKind, ID);
+
+        //!A transceiver whose id can be changed, so messages keep the sender id from the writer's process.
+        struct RemoteSender : public Transceiver
+        {
+            void setID(ID senderID) { id = senderID; }
+        };
+
+        template<typename T>
+        static void decodeMessage(MessageHub&, const Transceiver&, BinaryReader&, PostKind, ID);
+
+        //!Decoders by the hash of their bound name.
+        std::unordered_map<uint64_t, Decoder> decoders;
+
+        std::size_t mappedSize;
+        SharedRingHeader* ring;
+        const char* data;
+        uint64_t mask;
+
+        //!The reader's copy of the indices, so the shared write index is only read when the ring looks empty.
+        uint64_t readIndex;
+        uint64_t cachedWriteIndex;
+
+        RemoteSender sender;
+};
+
+//!Hash a bound message name. Both processes use it to agree on message types without sharing family ids.
+uint64_t hashMessageName(const std::string&);
+
+/** \brief Bind a message type to be sent. Must be called before messages of the type are posted.
+ *
+ * \param name The name used on the ring. The reader must bind the type under the same name.
+ */
+template<typename T>
+void SharedMessageWriter::bindMessageType(const std::string& name)
+{
+    auto family = T::getFamily();
+
+    if(family >= boundTypes.size())
+        boundTypes.resize(family + 1, BoundType{nullptr, 0});
+
+    boundTypes[family].encode = &encodeMessage<T>;
+    boundTypes[family].typeHash = hashMessageName(name);
+}
+
+template<typename T>
+void SharedMessageReader::bindMessageType(const std::string& name)
+{
+    decoders[hashMessageName(name)] = &decodeMessage<T>;
+}
+
+template<typename T>
+void SharedMessageReader::decodeMessage(MessageHub& msgHub, const Transceiver& msgSender, BinaryReader& in, PostKind kind, ID key)
+{
+    T msg(msgSender, in);
+
+    if(!in.isGood())
+    {
+        std::cerr << "Error: Shared message could not be decoded\n";
+        return;
+    }
+
+    msgHub.postDecodedMessage(std::move(msg), kind, key);
+}
+
+}//ocs
+
+#endif
@@ -0,0 +1,115 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_TIMERWHEEL_H
+#define OCS_TIMERWHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ocs
+{
+
+/** \brief A hierarchical timing wheel of four levels with 256 buckets each. Timers are counted in whole ticks.
+ *         Scheduling appends to a bucket and each tick fires one bucket, with timers in higher levels moved
+ *         down a level each time the level below wraps around. Both are O(1) amortized no matter how many
+ *         timers are pending.
+ *
+ *         Each timer carries two numbers that the owner uses to find what the timer is for.
+ */
+class TimerWheel
+{
+    public:
+
+        struct Timer
+        {
+            uint32_t family;
+            uint32_t index;
+        };
+
+        TimerWheel();
+
+        //!Schedule a timer to fire on the given tick. Ticks that have already been processed fire on the next one.
+        void schedule(uint64_t, uint32_t, uint32_t);
+
+        //!Process every tick up to and including the given one, appending expired timers in firing order.
+        void advance(uint64_t, std::vector<Timer>&);
+
+        //!Get the next tick that will be processed.
+        uint64_t getNextTick() const { return nextTick; }
+
+        //!Get the number of timers that have not fired.
+        std::size_t size() const { return pending; }
+
+        //!Get the tick the earliest timer is due on. Returns false if there are no timers.
+        bool getEarliestDueTick(uint64_t&) const;
+
+    private:
+
+        static const unsigned int levels = 4;
+        static const unsigned int levelBits = 8;
+        static const uint32_t levelSize = 1 << levelBits;
+        static const uint32_t nullNode = 0xffffffff;
+
+        struct Node
+        {
+            uint64_t dueTick;
+            Timer timer;
+            uint32_t next;
+        };
+
+        //!A list of nodes, appended at the tail so timers due on the same tick fire in the order they were scheduled.
+        struct Bucket
+        {
+            uint32_t head;
+            uint32_t tail;
+            uint32_t size;
+        };
+
+        //!Put a node in the bucket for its due tick relative to the next tick.
+        void place(uint32_t);
+
+        //!Move every node in a bucket of a higher level down to where it now belongs.
+        void cascade(unsigned int, uint32_t);
+
+        //!Detach and return a bucket's list of nodes.
+        uint32_t takeBucket(unsigned int, uint32_t);
+
+        std::vector<Node> nodes;
+        uint32_t freeNodes;
+
+        std::vector<Bucket> buckets;
+
+        //!Timers in each level, so runs of ticks where nothing can happen are skipped.
+        std::size_t levelCounts[levels];
+
+        uint64_t nextTick;
+        std::size_t pending;
+
+        //!The earliest due tick, which is only searched for again once a timer has fired.
+        mutable uint64_t earliestDue;
+        mutable bool earliestKnown;
+};
+
+}//ocs
+
+#endif
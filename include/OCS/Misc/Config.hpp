@@ -23,6 +23,7 @@ freely, subject to the following restrictions:
 #ifndef OCS_CONFIG_H
 #define OCS_CONFIG_H
 
+#include <bitset>
 #include <cstdint>
 #include <memory>
 
@@ -32,6 +33,12 @@ namespace ocs
 using ID = uint64_t;
 using Family = uint64_t;
 
+//!The number of component families that can be tracked in an object's component mask.
+const std::size_t maxComponentFamilies = 128;
+
+//!One bit for each component family an object has.
+using ComponentMask = std::bitset<maxComponentFamilies>;
+
 template<typename T>
 using systemPtr = std::shared_ptr<T>;
 
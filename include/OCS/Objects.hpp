@@ -26,5 +26,10 @@ freely, subject to the following restrictions:
  #include <OCS/Objects/Object.hpp>
  #include <OCS/Objects/ObjectManager.hpp>
  #include <OCS/Objects/ObjectPrototypeLoader.hpp>
+ #include <OCS/Objects/ObjectQuery.hpp>
+ #include <OCS/Objects/TrackedQuery.hpp>
+ #include <OCS/Objects/WorldDelta.hpp>
+ #include <OCS/Objects/WorldSerializer.hpp>
+ #include <OCS/Objects/WorldStreamLoader.hpp>
 
  #endif
@@ -45,17 +45,32 @@ struct Object
     Object () : objectID(-1) {}
     ID getObjectID() const { return objectID; }
 
+    //!Get a mask with the bit of every component family the object has set.
+    const ComponentMask& getComponentMask() const { return componentMask; }
+
     std::vector<std::string> serializeComponents() const;
     void deSerializeComponents(std::vector<std::pair<ID, std::string>> compArgs);
 
     protected:
 
         friend class ObjectManager;
+        friend class WorldDeltaEncoder;
+        friend class WorldDeltaDecoder;
         ID objectID;
 
         //Used for copying and destroying an object
         std::unordered_map<Family, BaseComponentArray*> componentArrays;
         std::unordered_map<Family, ID> componentIndices;
+
+        //Used for fast queries
+        ComponentMask componentMask;
+
+        //!Set or clear a family's bit in the component mask
+        void setMaskBit(Family compFamily, bool value)
+        {
+            if(compFamily < maxComponentFamilies)
+                componentMask.set(compFamily, value);
+        }
 };
 
 }//ocs
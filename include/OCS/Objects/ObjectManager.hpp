@@ -24,18 +24,25 @@ freely, subject to the following restrictions:
 #define OCS_OBJECTMANAGER_H
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <utility>
 
 #include <OCS/Components/Component.hpp>
 #include <OCS/Misc/NonCopyable.hpp>
 #include <OCS/Objects/Object.hpp>
+#include <OCS/Objects/ObjectQuery.hpp>
+#include <OCS/Objects/TrackedQuery.hpp>
 #include <OCS/Components/ComponentArray.hpp>
 #include <OCS/Misc/Config.hpp>
 #include <OCS/Components/SentinalType.hpp>
 namespace ocs
 {
 
+class CommandBuffer;
+class DeferredCommands;
+
 /**\brief Manages the lifetime of game objects. A blank object can be created
 *         and components may be added manually, or alternatively, the user
 *         may specify a custom prototype to copy the new object from.
@@ -67,6 +74,9 @@ class ObjectManager : NonCopyable
         template<typename C, typename ... Args>
         void addComponentsToPrototype(const std::string&, const C&, Args&& ...);
 
+        //!Compile a query string such as "Position & Motion & !Dead" using the names bound to components
+        bool compileQuery(const std::string&, ObjectQuery&) const;
+
         //!Add components to a prototype using strings. Used mainly for prototype file loading.
         void addComponentToPrototypeFromString(const std::string&, const std::string&, const std::string&);
 
@@ -74,6 +84,9 @@ class ObjectManager : NonCopyable
         template<typename C>
         void bindStringToComponent(const std::string&);
         
+        //!Apply the commands recorded in every thread's command buffer
+        void applyDeferredCommands();
+
         //!Copy a game object
         void copyObject(ID, const Object&);
 
@@ -105,6 +118,9 @@ class ObjectManager : NonCopyable
         //!Check if a prototype of the specified name exists
         bool doesPrototypeExist(const std::string&) const;
 
+        //!Get the calling thread's buffer for recording deferred changes
+        CommandBuffer& getCommandBuffer();
+
         //!Get a single component from the object's ID
         template<typename C>
         C* const getComponent(ID);
@@ -117,6 +133,12 @@ class ObjectManager : NonCopyable
         template<typename ... Args>
         std::vector<ID> getObjects();
 
+        //!Returns a list of object ids that match a query string. Compiled queries are cached. Safe to call from parallel systems.
+        std::vector<ID> getObjects(const std::string&);
+
+        //!Returns a list of object ids that match a compiled query
+        std::vector<ID> getObjects(const ObjectQuery&) const;
+
         //!Get a count of the specified component
         template<typename C>
         ID getTotalComponents() const;
@@ -135,6 +157,9 @@ class ObjectManager : NonCopyable
         //!Check if an object id is a prototype's id
         bool isPrototype(ID);
 
+        //!Release a query returned by trackQuery. It stops being updated once every user has released it.
+        void releaseQuery(TrackedQuery&);
+
         //!Remove a component from the object's ID
         template<typename C = SentinalType, typename ... Args>
         ID removeComponents(ID);
@@ -151,14 +176,23 @@ class ObjectManager : NonCopyable
 
         //!Set a component from an existing component
         template<typename C>
-        void setComponent(ID, const C&);
+        bool setComponent(ID, const C&);
 
         //!Set a component through the component's constructor arguments
         template<typename C, typename ... Args>
         void setComponent(ID, Args&& ...);
 
+        //!Get the set of objects matching a query, kept up to date as components change. Identical queries share a set.
+        TrackedQuery& trackQuery(const ObjectQuery&);
+
     private:
 
+        friend class WorldSerializer;
+        friend class WorldStreamLoader;
+        friend class WorldDeltaEncoder;
+        friend class WorldDeltaDecoder;
+        friend class DeferredCommands;
+
         //!All game objects reside in here
         PackedArray<Object> objects;
 
@@ -174,6 +208,18 @@ class ObjectManager : NonCopyable
         //!Stores a component id with an associated string
         std::unordered_map<std::string, ID> stringToCompFamily;
 
+        //!Stores query strings that have already been compiled
+        std::unordered_map<std::string, ObjectQuery> compiledQueries;
+
+        //!Guards compiledQueries, since parallel systems may look up queries at the same time
+        std::mutex compiledQueriesMutex;
+
+        //!Changes recorded by threads that may not touch the object and component arrays directly
+        std::unique_ptr<DeferredCommands> deferredCommands;
+
+        //!Queries whose matching objects are updated whenever an object's components change
+        std::vector<std::unique_ptr<TrackedQuery>> trackedQueries;
+
         //!Stores components for object prototypes
         template<typename C>
         ComponentArray<C>& getPrototypeComponentArray() const;
@@ -188,6 +234,19 @@ class ObjectManager : NonCopyable
         template<typename C>
         void registerComponent();
 
+        //!Give an object a component that is already stored in the component's array
+        void attachComponent(ID, Family, BaseComponentArray*, Index);
+
+        //!Remove an object's component of the given family
+        bool detachComponent(ID, Family);
+
+        //!Add or remove an object from the tracked queries after its components changed
+        void updateTrackedQueries(ID objectID)
+        {
+            for(auto& trackedQuery : trackedQueries)
+                trackedQuery->update(objectID, objects[objectID].componentMask);
+        }
+
         static ID prototypeIDCounter;
 
         //Used internally, so different instances of the ObjectManager can have different component arrays
@@ -215,6 +274,12 @@ ComponentArray<C>& ObjectManager::getComponentArray() const
 template<typename ... Args>
 std::vector<ID> ObjectManager::getObjects()
 {
+    ObjectQuery query;
+
+    //Compare component masks unless one of the families does not fit in a mask
+    if(query.require({Args::getFamily()...}))
+        return getObjects(query);
+
     std::vector<ID> ids;
     for (auto& obj : objects)
     {
@@ -268,7 +333,7 @@ ID ObjectManager::addComponents(ID objectID, const C& component, Args&& ... othe
     //A counter for the total components added to the object
     ID added = 0;
 
-    if(objectID < getTotalObjects())
+    if(objects.isValid(objectID))
     {
         //Only add the component if the object does not have an instance of it already.
         if(objects[objectID].componentIndices.find(C::getFamily()) == objects[objectID].componentIndices.end())
@@ -282,6 +347,8 @@ ID ObjectManager::addComponents(ID objectID, const C& component, Args&& ... othe
 
             //Store the component's index in the object
             objects[objectID].componentIndices[C::getFamily()] = componentIndex;
+            objects[objectID].setMaskBit(C::getFamily(), true);
+            updateTrackedQueries(objectID);
 
             added = 1;
         }
@@ -298,10 +365,11 @@ ID ObjectManager::addComponents(ID objectID, const C& component, Args&& ... othe
  *
  * \param objectID The owner object's id.
  * \param value The new value for the component.
+ * \return True if the object has the component and it was set. False if not.
  *
  */
 template<typename C>
-void ObjectManager::setComponent(ID objectID, const C& value)
+bool ObjectManager::setComponent(ID objectID, const C& value)
 {
     if(objectID < getTotalObjects())
     {
@@ -343,7 +411,7 @@ ID ObjectManager::removeComponents(ID objectID)
     ID totalRemoved = 0;
     if(!SentinalType::endRecursion(C()))
     {
-        if(objectID < getTotalObjects())
+        if(objects.isValid(objectID))
         {
             //Only remove the component if the object has an instance of it.
             if(objects[objectID].componentIndices.find(C::getFamily()) != objects[objectID].componentIndices.end())
@@ -356,6 +424,8 @@ ID ObjectManager::removeComponents(ID objectID)
                 //Remove the pointer to the component maps from the object
                 objects[objectID].componentArrays.erase(C::getFamily());
                 objects[objectID].componentIndices.erase(C::getFamily());
+                objects[objectID].setMaskBit(C::getFamily(), false);
+                updateTrackedQueries(objectID);
 
                 totalRemoved = 1;
             }
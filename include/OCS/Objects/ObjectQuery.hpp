@@ -0,0 +1,71 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_OBJECTQUERY_H
+#define OCS_OBJECTQUERY_H
+
+#include <initializer_list>
+
+#include "OCS/Misc/Config.hpp"
+
+namespace ocs
+{
+
+/** \brief A compiled object query. An object matches if it has every component in the include mask
+ *         and none of the components in the exclude mask.
+ *
+ *         Queries can be built from component families, or compiled from a string such as
+ *         "Position & Motion & !Dead" with ObjectManager::compileQuery.
+ */
+struct ObjectQuery
+{
+    //!Require objects to have the given component families. Returns false if a family can not be masked.
+    bool require(std::initializer_list<Family> families) { return setBits(include, families); }
+
+    //!Require objects to not have the given component families. Returns false if a family can not be masked.
+    bool forbid(std::initializer_list<Family> families) { return setBits(exclude, families); }
+
+    //!Check if an object's component mask matches the query.
+    bool matches(const ComponentMask& mask) const { return (mask & include) == include && (mask & exclude).none(); }
+
+    ComponentMask include;
+    ComponentMask exclude;
+
+    private:
+
+        static bool setBits(ComponentMask& mask, std::initializer_list<Family> families)
+        {
+            bool allSet = true;
+            for(auto compFamily : families)
+            {
+                if(compFamily < maxComponentFamilies)
+                    mask.set(compFamily);
+                else
+                    allSet = false;
+            }
+            return allSet;
+        }
+};
+
+}//ocs
+
+#endif
@@ -0,0 +1,86 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_TRACKEDQUERY_H
+#define OCS_TRACKEDQUERY_H
+
+#include <vector>
+
+#include "OCS/Misc/Config.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+#include "OCS/Objects/ObjectQuery.hpp"
+
+namespace ocs
+{
+
+/** \brief The set of objects matching an ObjectQuery, kept up to date by the ObjectManager as objects gain and
+ *         lose components, so users never scan objects that do not match.
+ *
+ *         Tracked queries are created with ObjectManager::trackQuery. The ids are stored contiguously in no
+ *         particular order, so the set can be split into index ranges with JobSystem::parallelFor.
+ */
+class TrackedQuery : NonCopyable
+{
+    public:
+
+        const ObjectQuery& getQuery() const { return query; }
+
+        //!Get the ids of every matching object.
+        const std::vector<ID>& getObjects() const { return matching; }
+
+        std::size_t size() const { return matching.size(); }
+        bool empty() const { return matching.empty(); }
+
+        std::vector<ID>::const_iterator begin() const { return matching.begin(); }
+        std::vector<ID>::const_iterator end() const { return matching.end(); }
+
+        //!Check if an object is in the set.
+        bool contains(ID) const;
+
+    private:
+
+        friend class ObjectManager;
+
+        static const std::size_t notTracked = static_cast<std::size_t>(-1);
+
+        TrackedQuery(const ObjectQuery& _query) : query(_query), users(1) {}
+
+        //!Add or remove an object after its components changed.
+        void update(ID, const ComponentMask&);
+
+        //!Remove an object that is being destroyed.
+        void remove(ID);
+
+        ObjectQuery query;
+
+        std::vector<ID> matching;
+
+        //!Each object's index in matching, or notTracked.
+        std::vector<std::size_t> positions;
+
+        //!The number of times the query was tracked and not yet released.
+        unsigned int users;
+};
+
+}//ocs
+
+#endif
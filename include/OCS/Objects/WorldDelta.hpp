@@ -0,0 +1,166 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_WORLDDELTA_H
+#define OCS_WORLDDELTA_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OCS/Objects/ObjectManager.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
+
+namespace ocs
+{
+
+/** \brief Encodes the changes made to an ObjectManager since the last encode as a compact byte stream.
+ *
+ *         Each delta holds the objects that were created and destroyed, the components that were added and
+ *         removed, and the bytes of components that changed. Changed components are stored as the XOR of their
+ *         old and new bytes, with runs of unchanged bytes written as varint lengths. The first delta (and the
+ *         first after reset) holds the whole world.
+ *
+ *         Only components that are bound to a name with bindStringToComponent are encoded. Their binary form
+ *         comes from writeBinary. The deltas are applied to another ObjectManager with a WorldDeltaDecoder.
+ *
+ *         e.g.
+ *             encoder.encode(out);    //Every frame on the server
+ *             decoder.apply(in);      //Every frame on the client
+ */
+class WorldDeltaEncoder
+{
+    public:
+
+        WorldDeltaEncoder(ObjectManager&);
+
+        //!Write the changes since the last encode and remember the current state as the new baseline.
+        void encode(BinaryWriter&);
+
+        //!Forget the baseline so the next delta holds the whole world.
+        void reset();
+
+    private:
+
+        struct ComponentState
+        {
+            uint32_t nameIndex;
+            std::string bytes;
+        };
+
+        struct ObjectState
+        {
+            ObjectState() : exists(false) {}
+
+            bool exists;
+            std::vector<ComponentState> components;
+        };
+
+        //!Where a component's current bytes are in the componentBytes buffer.
+        struct ComponentSlice
+        {
+            uint32_t nameIndex;
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        //!Write the operations for one object into the operations buffer and bring its baseline up to date.
+        uint64_t diffObject(const Object&, ObjectState&);
+
+        //!Get the name index of a family, adding the name to the table if it is new. Returns false if the family has no name.
+        bool getNameIndex(Family, uint32_t&);
+
+        ObjectManager& objManager;
+
+        //!The names that have been given an index. New names are sent with the next delta.
+        std::vector<std::string> names;
+        std::unordered_map<Family, uint32_t> familyToName;
+        std::size_t namesSent;
+
+        //!The state of every object when the last delta was encoded, indexed by object id.
+        std::vector<ObjectState> baseline;
+
+        //!Scratch space kept between encodes so a frame with few changes does not allocate.
+        BinaryWriter componentBytes;
+        std::vector<ComponentSlice> currentComponents;
+        BinaryWriter operations;
+        BinaryWriter changes;
+        std::vector<ID> destroyed;
+        std::vector<ID> created;
+        std::vector<ID> changed;
+};
+
+/** \brief Applies deltas written by a WorldDeltaEncoder to an ObjectManager. Objects created by the deltas
+ *         are given new ids, which can be looked up from the encoder's ids with getLocalID.
+ *
+ *         The receiving ObjectManager must bind the same component names as the sender. Components with
+ *         names that are not bound are skipped.
+ */
+class WorldDeltaDecoder
+{
+    public:
+
+        WorldDeltaDecoder(ObjectManager&);
+
+        //!Apply one delta. Returns false if the delta could not be read.
+        bool apply(BinaryReader&);
+
+        //!Get the id of the local object that mirrors the encoder's object. Returns -1 if there is none.
+        ID getLocalID(ID) const;
+
+        //!Forget all mirrored objects. Should be followed by a delta from a reset encoder.
+        void reset();
+
+    private:
+
+        struct ComponentState
+        {
+            uint32_t nameIndex;
+            std::string bytes;
+        };
+
+        struct ObjectState
+        {
+            ObjectState() : localID(-1) {}
+
+            ID localID;
+            std::vector<ComponentState> components;
+        };
+
+        //!Read the new bytes of a component back into the local object.
+        void updateComponent(ID, uint32_t, const std::string&, bool);
+
+        ObjectManager& objManager;
+
+        std::vector<std::string> names;
+
+        //!The family of each name, or -1 if the name is not bound locally.
+        std::vector<Family> nameFamilies;
+
+        //!Mirrors the encoder's baseline, keyed by the encoder's object ids. The ids come from the deltas, so they
+        //!are not trusted to be small enough to index a vector.
+        std::unordered_map<ID, ObjectState> baseline;
+};
+
+}//ocs
+
+#endif
@@ -0,0 +1,73 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_WORLDSERIALIZER_H
+#define OCS_WORLDSERIALIZER_H
+
+#include <map>
+#include <string>
+
+#include "OCS/Objects/ObjectManager.hpp"
+#include "OCS/Utilities/BinaryStream.hpp"
+
+namespace ocs
+{
+
+/** \brief Saves and loads every object in an ObjectManager using a versioned binary world format.
+ *
+ *         The world is stored as a header, a table of the component names that were registered with
+ *         bindStringToComponent, a list of object ids and one section per component family. Only components
+ *         that are bound to a name are saved, since family ids may differ between runs. Each section is
+ *         encoded on its own thread and loaded by appending straight into the matching ComponentArray.
+ *
+ *         Components are written with their writeBinary function and read with readBinary.
+ */
+class WorldSerializer
+{
+    public:
+
+        static const uint32_t formatVersion = 1;
+
+        //!Save all objects to a binary world file.
+        static bool saveWorld(ObjectManager&, const std::string&);
+
+        //!Create all objects stored in a binary world file.
+        static bool loadWorld(ObjectManager&, const std::string&);
+
+        //!Write all objects to a buffer in the binary world format.
+        static void encodeWorld(ObjectManager&, BinaryWriter&);
+
+        //!Create all objects stored in a buffer in the binary world format.
+        static bool decodeWorld(ObjectManager&, BinaryReader&);
+
+        //!Read the world header and check that the format is supported.
+        static bool readHeader(BinaryReader&);
+
+    private:
+
+        //!Get the first name (alphabetically) that each component family is bound to.
+        static std::map<Family, std::string> getFamilyNames(const ObjectManager&);
+};
+
+}//ocs
+
+#endif
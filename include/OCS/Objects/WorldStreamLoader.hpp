@@ -0,0 +1,153 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_WORLDSTREAMLOADER_H
+#define OCS_WORLDSTREAMLOADER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OCS/Messaging/Message.hpp"
+#include "OCS/Messaging/Transceiver.hpp"
+#include "OCS/Misc/NonCopyable.hpp"
+#include "OCS/Objects/ObjectManager.hpp"
+
+namespace ocs
+{
+
+class MessageHub;
+
+//!Posted by a WorldStreamLoader every frame that it makes progress.
+struct WorldLoadProgress : public Message<WorldLoadProgress>
+{
+    WorldLoadProgress(const Transceiver& transceiver, ID _objectsLoaded, ID _totalObjects, bool _finished, bool _failed) :
+        Message(transceiver), objectsLoaded(_objectsLoaded), totalObjects(_totalObjects), finished(_finished), failed(_failed) {}
+
+    void log(std::ostream& out)
+    {
+        out << "Message Type: WorldLoadProgress\n";
+        out << "Sender: " << getSender() << std::endl;
+        out << "Loaded: " << objectsLoaded << " / " << totalObjects << std::endl;
+    }
+
+    ID objectsLoaded;
+    ID totalObjects;
+    bool finished;
+    bool failed;
+};
+
+/** \brief Loads a binary world file written by WorldSerializer without blocking the calling thread.
+ *
+ *         The file is read in chunks and decoded on a background thread. Every frame the owner calls update,
+ *         which creates as many whole objects as fit in the given time budget. Objects only appear once all
+ *         of their components have been added. Progress is posted to the MessageHub as a WorldLoadProgress message.
+ *
+ *         e.g.
+ *             loader.start("level.world");
+ *             ...every frame...
+ *             loader.update(msgHub, 0.002);
+ *
+ *         Component names must be bound with bindStringToComponent before calling start.
+ */
+class WorldStreamLoader : NonCopyable, public Transceiver
+{
+    public:
+
+        //!Size of each chunk read from the file.
+        static const std::size_t chunkSize = 1 << 20;
+
+        WorldStreamLoader(ObjectManager&);
+        ~WorldStreamLoader();
+
+        //!Start reading a world file on a background thread.
+        bool start(const std::string&);
+
+        //!Create objects until the time budget (in seconds) is used up. Returns true once loading has ended.
+        bool update(MessageHub&, double = 0.002);
+
+        //!Stop loading. Objects that have already been created are kept.
+        void cancel();
+
+        //!Check if a world is being loaded.
+        bool isLoading() const { return loading; }
+
+        //!Check if the last load failed.
+        bool hasFailed() const { return failed; }
+
+        ID getObjectsLoaded() const { return nextObject; }
+        ID getTotalObjects() const { return totalObjects; }
+
+    private:
+
+        //!The decoded components of one family waiting to be added to their objects.
+        struct Section
+        {
+            Family family;
+            BaseComponentArray* compArray;
+            std::unique_ptr<BaseComponentArray> staged;
+        };
+
+        //!Where a staged component is stored.
+        struct StagedComponent
+        {
+            uint32_t section;
+            Index index;
+        };
+
+        //!Runs on the background thread.
+        void readWorld(const std::string&);
+
+        //!Finish the current load.
+        void finish(MessageHub&, bool);
+
+        ObjectManager& objManager;
+
+        std::thread reader;
+        std::atomic<bool> decoded;
+        std::atomic<bool> decodeFailed;
+        std::atomic<bool> cancelled;
+
+        //!Written by the reader before it sets decoded.
+        ID decodedObjects;
+
+        //!Component bindings copied when the load starts, so the reader never touches the ObjectManager.
+        std::unordered_map<std::string, std::pair<Family, BaseComponentArray*>> bindings;
+
+        std::vector<Section> sections;
+
+        //!Staged components grouped by object. Object i owns the components in [firstComponent[i], firstComponent[i + 1]).
+        std::vector<std::size_t> firstComponent;
+        std::vector<StagedComponent> components;
+
+        bool loading;
+        bool failed;
+        ID nextObject;
+        ID totalObjects;
+};
+
+}//ocs
+
+#endif
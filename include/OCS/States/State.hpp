@@ -23,8 +23,12 @@ freely, subject to the following restrictions:
 #ifndef OCS_STATE_H
 #define OCS_STATE_H
 
+#include <atomic>
+#include <chrono>
+
 #include "OCS/Objects/ObjectManager.hpp"
 #include "OCS/Messaging/MessageHub.hpp"
+#include "OCS/Systems/JobSystem.hpp"
 #include "OCS/Systems/SystemManager.hpp"
 
 #include "OCS/Utilities/Timer.hpp"
@@ -32,16 +36,66 @@ freely, subject to the following restrictions:
 namespace ocs
 {
 
+//!The result of State::runHeadless.
+struct HeadlessRunStats
+{
+    uint64_t ticks;
+    double seconds;
+    double ticksPerSecond;
+};
+
+/** \brief Owns the objects, systems and messages of one part of a program, and runs its main loop.
+ *
+ *         By default run updates as often as it can. With a target tick rate it sleeps between frames, waking a
+ *         little early and spinning for the last moment so frames start on time. While idle, it instead blocks
+ *         between frames until a message is posted from another thread, a scheduled message is due, or stop is
+ *         called.
+ *
+ *         runHeadless instead runs a number of fixed steps as fast as possible with no reference to the wall clock,
+ *         e.g. for balancing or training runs that must be reproducible.
+ *
+ *         Systems run on JobSystem::getShared unless the state is given its own pool, so several states do not
+ *         each start a thread per core.
+ */
 class State : public Transceiver
 {
     public:
 
-        State();
+        //!Run the systems on the given pool, by default the one shared by every state.
+        explicit State(JobSystem& = JobSystem::getShared());
         virtual ~State();
 
         void run();
+
+        //!Make run return after the current frame. May be called from any thread.
         void stop();
 
+        //!Run the given number of fixed steps as fast as possible and deterministically, and report the tick rate.
+        //!A step of 0 uses the fixed timestep, or 1/60 of a second if there is none.
+        HeadlessRunStats runHeadless(uint64_t, double = 0.0);
+
+        //!Limit run to the given number of frames per second. 0 removes the limit.
+        void setTargetTickRate(double);
+
+        double getTargetTickRate() const { return targetTickRate; }
+
+        //!Block between frames until a message arrives from another thread or a scheduled message is due.
+        void setIdle(bool);
+
+        bool isIdle() const { return idle; }
+
+        //!Advance by the real time that has passed, as one variable step or as many fixed steps as fit in it.
+        void advance(double);
+
+        //!Update in fixed steps of the given length in seconds, running at most the given number per advance.
+        //!A step of 0 goes back to one variable step per frame.
+        void setFixedTimestep(double, unsigned int = 5);
+
+        double getFixedTimestep() const { return fixedTimestep; }
+
+        //!Get how far the time left over after the last fixed step is into the next one, from 0 to 1.
+        double getInterpolationAlpha() const;
+
         virtual void configure() = 0;
         virtual void initialize() = 0;
         virtual void update(double) = 0;
@@ -52,9 +106,35 @@ class State : public Transceiver
         SystemManager sysManager;
         MessageHub msgHub;
 
+        //!Runs the systems in parallel and is passed to them for their own jobs. Usually shared with other states.
+        JobSystem& jobSystem;
+
         Timer timer;
 
-        bool running;
+        std::atomic<bool> running;
+
+    private:
+
+        //!How long before a frame is due run stops sleeping and spins, as sleeping may overshoot.
+        static const double spinTime;
+
+        //!Move the hub's clock, update the state and start the next frame.
+        void step(double);
+
+        //!Wait until the next frame is due at the target tick rate.
+        void paceFrame(std::chrono::steady_clock::time_point&);
+
+        //!Wait for a message or the next scheduled message, moving the hub's clock by the time spent waiting.
+        void waitWhileIdle();
+
+        double targetTickRate;
+        std::atomic<bool> idle;
+
+        double fixedTimestep;
+        unsigned int maxCatchUpSteps;
+
+        //!Real time that has not been simulated yet in fixed step mode.
+        double accumulatedTime;
 
 };
 
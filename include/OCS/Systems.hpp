@@ -23,7 +23,9 @@ freely, subject to the following restrictions:
  #ifndef OCS_SYSTEMS_HPP
  #define OCS_SYSTEMS_HPP
 
+ #include <OCS/Systems/JobSystem.hpp>
  #include <OCS/Systems/System.hpp>
  #include <OCS/Systems/SystemManager.hpp>
+ #include <OCS/Systems/SystemTimings.hpp>
 
  #endif
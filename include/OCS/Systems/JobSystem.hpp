@@ -0,0 +1,231 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_JOBSYSTEM_H
+#define OCS_JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "OCS/Misc/NonCopyable.hpp"
+
+namespace ocs
+{
+
+/** \brief Counts the jobs started with it that have not finished, so a thread can wait for a group of jobs.
+ */
+class JobCounter : NonCopyable
+{
+    public:
+
+        JobCounter() : pending(0) {}
+
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+        std::size_t getPending() const { return pending.load(std::memory_order_acquire); }
+
+    private:
+
+        friend class JobSystem;
+
+        std::atomic<std::size_t> pending;
+};
+
+/** \brief A pool of worker threads that share work by stealing. Each worker has its own deque of jobs. A
+ *         worker pushes and pops jobs at the back of its own deque, and when it runs out it takes the oldest
+ *         job from the front of another worker's deque. Jobs submitted from threads outside the pool go into
+ *         a shared queue that every worker takes from.
+ *
+ *         Threads outside the pool can help with the work by calling runPendingJob, so a pool with no workers
+ *         still makes progress on the thread that waits for it. Waiting on a JobCounter also runs queued jobs
+ *         instead of blocking, so jobs may start and wait for more jobs without ever using more threads than
+ *         the pool has.
+ *
+ *         Jobs record commands and queue messages with the sort key of the thread that submitted them, so they are
+ *         applied in the order of the system that started them. Each piece of a parallelFor gets its own key after
+ *         the caller's, in range order, so the pieces' commands are applied in the same order every run.
+ *
+ *         States share one pool from getShared unless they are given their own, so running several states does
+ *         not start more threads than there are cores.
+ *
+ *         e.g.
+ *             JobCounter counter;
+ *             for(int region = 0; region < 4; ++region)
+ *                 jobs.submit(counter, [&, region]() { updateRegion(region); });
+ *             jobs.wait(counter);
+ *
+ *             jobs.parallelFor(0, positions.size(), 256, [&](std::size_t begin, std::size_t end) { ... });
+ */
+class JobSystem : NonCopyable
+{
+    public:
+
+        using Job = std::function<void()>;
+
+        //!The SystemManager spaces systems' sort keys this many bits apart, leaving room for a key per parallelFor piece.
+        static const unsigned int subKeyBits = 32;
+
+        //!Start the given number of workers, by default one fewer than the number of cores as the caller usually helps.
+        //!Workers can be pinned to their own cores, leaving the first core for the calling thread.
+        explicit JobSystem(unsigned int = getDefaultWorkerCount(), bool = false);
+        ~JobSystem();
+
+        //!Queue a job to be run by any worker.
+        void submit(Job);
+
+        //!Queue a job and count it in a counter until it finishes.
+        void submit(JobCounter&, Job);
+
+        //!Run queued jobs on the calling thread until every job counted in the counter has finished.
+        void wait(JobCounter&);
+
+        //!Call a function on pieces of a range in parallel and wait for all of them.
+        template<typename Func>
+        void parallelFor(std::size_t, std::size_t, std::size_t, const Func&);
+
+        //!Run one queued job on the calling thread. Returns false if there were no jobs to take.
+        bool runPendingJob();
+
+        unsigned int getTotalWorkers() const { return workers.size(); }
+
+        //!Get the index of the calling thread in its pool, or -1 if it is not a worker.
+        static int getWorkerIndex();
+
+        static unsigned int getDefaultWorkerCount();
+
+        //!Get the pool with the default number of workers that states use unless they are given their own.
+        static JobSystem& getShared();
+
+        //!Set the sort key for the calling thread's commands and queued messages, which jobs it submits inherit.
+        static void setSortKey(uint64_t);
+        static uint64_t getSortKey();
+
+    private:
+
+        struct QueuedJob
+        {
+            Job job;
+
+            //!Counts the job until it finishes, or nullptr.
+            JobCounter* counter;
+
+            //!The submitting thread's sort key, used for the job's commands and queued messages.
+            uint64_t sortKey;
+        };
+
+        struct Worker
+        {
+            std::mutex jobsMutex;
+            std::deque<QueuedJob> jobs;
+            std::thread thread;
+        };
+
+        void push(QueuedJob);
+
+        //!Queue a job that records with the given sort key.
+        void submit(JobCounter&, Job, uint64_t);
+
+        void runJob(QueuedJob&);
+
+        void workerLoop(unsigned int);
+
+        //!Pin a worker's thread to one core.
+        void pinWorker(unsigned int);
+
+        //!Take a job, first from the given worker's own deque, then the shared queue, then other workers.
+        bool takeJob(int, QueuedJob&);
+
+        bool stealJob(std::deque<QueuedJob>&, std::mutex&, QueuedJob&);
+
+        //!Split a range in half until the pieces are small enough, queueing the second halves.
+        template<typename Func>
+        void splitRange(JobCounter&, std::size_t, std::size_t, std::size_t, const Func&, uint64_t);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        //!Jobs submitted from threads outside the pool.
+        std::mutex sharedMutex;
+        std::deque<QueuedJob> sharedJobs;
+
+        //!Jobs that have been queued but not taken, so idle workers know when to wake.
+        std::atomic<std::size_t> pendingJobs;
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        bool stopping;
+};
+
+/** \brief Call a function on pieces of the range [begin, end). The range is split in half recursively, and the
+ *         halves are queued so idle workers steal large pieces first. The calling thread works on pieces too,
+ *         and with no workers the function is called once with the whole range.
+ *
+ *         Each piece records with the caller's sort key plus one plus the piece's offset into the range, and the
+ *         caller continues after the last of them, so commands are applied as if the pieces ran one after another.
+ *
+ * \param begin The start of the range.
+ * \param end One past the end of the range.
+ * \param grainSize The largest piece that is not split further.
+ * \param func Called as func(pieceBegin, pieceEnd) from any of the pool's threads.
+ */
+template<typename Func>
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, const Func& func)
+{
+    if(begin >= end)
+        return;
+
+    //Adding the start of a piece to the offset gives the piece's key
+    uint64_t sortKey = getSortKey();
+    uint64_t keyOffset = sortKey + 1 - begin;
+
+    JobCounter counter;
+    splitRange(counter, begin, end, std::max<std::size_t>(1, grainSize), func, keyOffset);
+    wait(counter);
+
+    setSortKey(sortKey + 1 + (end - begin));
+}
+
+template<typename Func>
+void JobSystem::splitRange(JobCounter& counter, std::size_t begin, std::size_t end, std::size_t grainSize, const Func& func, uint64_t keyOffset)
+{
+    while(end - begin > grainSize && !workers.empty())
+    {
+        std::size_t middle = begin + (end - begin) / 2;
+        submit(counter, [this, &counter, middle, end, grainSize, &func, keyOffset]() { splitRange(counter, middle, end, grainSize, func, keyOffset); },
+               keyOffset + middle);
+        end = middle;
+    }
+
+    uint64_t sortKey = getSortKey();
+    setSortKey(keyOffset + begin);
+    func(begin, end);
+    setSortKey(sortKey);
+}
+
+}//ocs
+
+#endif
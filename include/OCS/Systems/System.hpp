@@ -23,24 +23,213 @@ freely, subject to the following restrictions:
 #ifndef OCS_SYSTEM_H
 #define OCS_SYSTEM_H
 
+#include <vector>
+
+#include "OCS/Misc/Config.hpp"
 #include "OCS/Misc/NonCopyable.hpp"
 #include "OCS/Messaging/Transceiver.hpp"
+#include "OCS/Objects/ObjectManager.hpp"
+#include "OCS/Systems/SystemTimings.hpp"
 
 namespace ocs
 {
 
-class ObjectManager;
 class MessageHub;
+class JobSystem;
+
+/** \brief The phases systems are grouped into. Phases run in this order every update, with a sync point after
+ *         each one.
+ */
+enum class SystemPhase : uint8_t
+{
+    PreUpdate,
+    Update,
+    PostUpdate,
+    Commit
+};
+
+/** \brief The component types and message types a system declares it uses. The SystemManager uses them to decide
+ *         which systems may run at the same time.
+ */
+struct SystemAccess
+{
+    std::vector<Family> readComponents;
+    std::vector<Family> writeComponents;
+    std::vector<Family> producedMessages;
+    std::vector<Family> consumedMessages;
+
+    //!Create the declared component arrays, so systems running in parallel never create them at the same time.
+    std::vector<void (*)(ObjectManager&)> prepareArrays;
+
+    //!False until the system declares anything. Undeclared systems never run alongside other systems, and always
+    //!run on the thread that updates the SystemManager.
+    bool declared = false;
+
+    //!Check if two systems must not run at the same time.
+    bool conflictsWith(const SystemAccess&) const;
+
+    //!Check if this system consumes messages the other produces, or the other way around.
+    bool sharesMessagesWith(const SystemAccess&) const;
+};
 
 /** \brief Base class for user defined logic systems. All systems will have access to an ObjectManager and a MessageHub.
  *         Systems should operate on a set of components, and can look for posted messages of a desired type from the MessageHub.
+ *
+ *         A system may declare what it uses in its constructor, which lets the SystemManager run it alongside
+ *         systems it does not conflict with.
+ *         e.g.
+ *             MovementSystem()
+ *             {
+ *                 readsComponents<Motion>();
+ *                 writesComponents<Position>();
+ *             }
+ *
+ *         A system may also declare the components of the objects it works on. The SystemManager keeps the set of
+ *         matching objects up to date, and skips the system while the set is empty.
+ *         e.g.
+ *             MovementSystem()
+ *             {
+ *                 requiresComponents<Position, Motion>();
+ *                 excludesComponents<Frozen>();
+ *             }
+ *             ...in update...
+ *             for(auto objectID : getMatchingObjects())
+ *
+ *         Systems running in parallel must make structural changes through ObjectManager::getCommandBuffer, and
+ *         their posted messages are only seen by other systems once the SystemManager syncs the MessageHub.
+ *
+ *         Systems that split their own work into jobs override the update that takes the State's JobSystem.
+ *         It calls the plain update by default.
  */
 struct System : NonCopyable, public Transceiver
 {
     virtual ~System() {}
-    virtual void update(ObjectManager&, MessageHub&, double) = 0;
+    virtual void update(ObjectManager&, MessageHub&, double) {}
+    virtual void update(ObjectManager& objManager, MessageHub& msgHub, JobSystem&, double dt) { update(objManager, msgHub, dt); }
+
+    const SystemAccess& getAccess() const { return access; }
+
+    //!Get the phase the system runs in.
+    SystemPhase getPhase() const { return phase; }
+
+    //!Check if the system declared the components of the objects it works on.
+    bool hasObjectQuery() const { return queryDeclared; }
+
+    //!Get how many ticks pass between updates of the system.
+    unsigned int getRateDivisor() const { return rateDivisor; }
+
+    //!Get which tick, counting from 0 to the divisor, the system updates on.
+    unsigned int getRatePhase() const { return ratePhase; }
+
+    //!Get the system's recent update times and time budget.
+    const SystemTimings& getTimings() const { return timings; }
+
+    protected:
+
+        template<typename ... C>
+        void readsComponents();
+
+        template<typename ... C>
+        void writesComponents();
+
+        template<typename ... M>
+        void producesMessages();
+
+        template<typename ... M>
+        void consumesMessages();
+
+        template<typename ... C>
+        void requiresComponents();
+
+        template<typename ... C>
+        void excludesComponents();
+
+        //!Get the objects matching the declared query. Empty before the system is added to a SystemManager.
+        const std::vector<ID>& getMatchingObjects() const;
+
+    private:
+
+        friend class SystemManager;
+
+        template<typename C>
+        static void prepareArray(ObjectManager& objManager) { objManager.getComponentArray<C>(); }
+
+        SystemAccess access;
+
+        SystemPhase phase = SystemPhase::Update;
+
+        ObjectQuery objectQuery;
+        bool queryDeclared = false;
+
+        //!The set kept up to date by the ObjectManager while the system is added to a SystemManager.
+        TrackedQuery* trackedQuery = nullptr;
+
+        unsigned int rateDivisor = 1;
+        unsigned int ratePhase = 0;
+
+        //!Time passed since the system last updated, given to it as dt when it next runs.
+        double pendingTime = 0.0;
+
+        SystemTimings timings;
 };
 
+//!Declare component types the system only reads.
+template<typename ... C>
+void System::readsComponents()
+{
+    access.readComponents.insert(access.readComponents.end(), {C::getFamily()...});
+    access.prepareArrays.insert(access.prepareArrays.end(), {&prepareArray<C>...});
+    access.declared = true;
+}
+
+//!Declare component types the system changes.
+template<typename ... C>
+void System::writesComponents()
+{
+    access.writeComponents.insert(access.writeComponents.end(), {C::getFamily()...});
+    access.prepareArrays.insert(access.prepareArrays.end(), {&prepareArray<C>...});
+    access.declared = true;
+}
+
+//!Declare message types the system posts or sends.
+template<typename ... M>
+void System::producesMessages()
+{
+    access.producedMessages.insert(access.producedMessages.end(), {M::getFamily()...});
+    access.declared = true;
+}
+
+//!Declare message types the system reads.
+template<typename ... M>
+void System::consumesMessages()
+{
+    access.consumedMessages.insert(access.consumedMessages.end(), {M::getFamily()...});
+    access.declared = true;
+}
+
+//!Declare component types every object the system works on has.
+template<typename ... C>
+void System::requiresComponents()
+{
+    objectQuery.require({C::getFamily()...});
+    queryDeclared = true;
+}
+
+//!Declare component types no object the system works on has.
+template<typename ... C>
+void System::excludesComponents()
+{
+    objectQuery.forbid({C::getFamily()...});
+    queryDeclared = true;
+}
+
+inline const std::vector<ID>& System::getMatchingObjects() const
+{
+    static const std::vector<ID> noObjects;
+
+    return trackedQuery ? trackedQuery->getObjects() : noObjects;
+}
+
 }//ocs
 
 #endif
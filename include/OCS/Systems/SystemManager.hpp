@@ -23,10 +23,15 @@ freely, subject to the following restrictions:
 #ifndef OCS_SYSTEMMANAGER_H
 #define OCS_SYSTEMMANAGER_H
 
+#include <algorithm>
+#include <condition_variable>
 #include <list>
 #include <queue>
 #include <map>
+#include <mutex>
+#include <vector>
 
+#include "OCS/Systems/JobSystem.hpp"
 #include "OCS/Systems/System.hpp"
 #include "OCS/Misc/Config.hpp"
 #include "OCS/Misc/NonCopyable.hpp"
@@ -41,6 +46,29 @@ class MessageHub;
  *         To create a system, users should inherit from the "System" object and implement an update function. Systems
  *         will have access to an ObjectManager and a MessageHub.
  *
+ *         Systems are grouped into phases, which run in the order PreUpdate, Update, PostUpdate, Commit. Within a
+ *         phase, systems run in the order they were added. After each phase that has systems is a sync point: the
+ *         commands recorded with ObjectManager::getCommandBuffer are applied, and the MessageHub's queued messages
+ *         are moved onto the board and its deferred handlers run. Systems in later phases see both.
+ *         e.g.
+ *             systems.addSystem<InputSystem>(SystemPhase::PreUpdate);
+ *             systems.addSystem<MovementSystem>();
+ *             systems.addSystem<CleanupSystem>(SystemPhase::Commit);
+ *
+ *         Given a JobSystem, systems that declare what they use are run in parallel within their phase. Systems
+ *         that conflict still run in the order they were added, and the MessageHub is synced before a system that
+ *         consumes messages produced by a system that ran before it.
+ *
+ *         Systems can update less often than every tick with setRateDivisor. Such systems are spread over the
+ *         ticks so expensive ones do not all update on the same tick, and are given the time since they last
+ *         updated as their dt.
+ *
+ *         Systems that declare an object query have its matching objects tracked from when they are added, and do not
+ *         update while no object matches. Their time does not build up while they are skipped this way.
+ *
+ *         Every update is timed on a steady clock. A system can be given a time budget, and a SystemOverBudget
+ *         message is posted whenever one of its updates takes longer.
+ *
  * \author Kevin Miller
  * \version 2-22-2014
  *
@@ -52,10 +80,10 @@ class SystemManager : NonCopyable
         SystemManager(ObjectManager&, MessageHub&);
         ~SystemManager();
 
-        /*!Add a system to the list of systems. Systems will be updated in the order they are added in.
+        /*!Add a system to the end of a phase. Systems will be updated in the order they are added in.
            There can be one instance of each type of system*/
         template<typename T>
-        void addSystem();
+        void addSystem(SystemPhase = SystemPhase::Update);
 
         //!Remove a system from the list.
         template<typename T>
@@ -69,22 +97,118 @@ class SystemManager : NonCopyable
         template<typename T>
         void updateSystem(double);
 
+        //!Update a system once every given number of ticks, e.g. 6 for 10 Hz when ticking at 60 Hz.
+        template<typename T>
+        void setRateDivisor(unsigned int);
+
+        //!Get a summary of a system's recent update times.
+        template<typename T>
+        SystemTimingStats getTimingStats() const;
+
+        //!Set the longest a system's update should take in seconds. 0 removes the budget.
+        template<typename T>
+        void setTimeBudget(double);
+
+        //!Turn timing and time budgets on or off. Without them, what systems see never depends on the wall clock.
+        void setTimingEnabled(bool enabled) { timingEnabled = enabled; }
+
+        bool isTimingEnabled() const { return timingEnabled; }
+
+        //!Get the number of times updateAllSystems has been called.
+        uint64_t getTick() const { return tick; }
+
         //!Get the total number of systems.
         ID getTotalSystems() const;
 
         //!Get the SystemManager's version number
         ID getVersion() const;
 
-        //!Update all systems in the list in order.
+        //!Update all systems phase by phase, with a sync point after each phase.
         void updateAllSystems(double);
 
+        //!Run systems on a job system's threads, and pass it to them for their own jobs.
+        //!Pass nullptr to run them one after another on the calling thread.
+        void setJobSystem(JobSystem*);
+
+        //!Get the job system passed to systems. Without one set, this has no workers and runs jobs on the waiting thread.
+        JobSystem& getJobSystem() { return jobSystem ? *jobSystem : inlineJobs; }
+
     private:
 
+        //!One system in the dependency graph.
+        struct SystemNode
+        {
+            System* system;
+
+            //!Systems that must wait for this one.
+            std::vector<std::size_t> successors;
+
+            //!Whether each successor consumes or produces messages this system also uses.
+            std::vector<bool> successorNeedsSync;
+
+            std::size_t totalPredecessors;
+        };
+
+        //!Pick the phase for a divisor that overlaps the least with the other systems' updates.
+        unsigned int pickRatePhase(const System&, unsigned int) const;
+
+        //!Add the tick's time to a system and check if it updates on this tick.
+        bool isSystemDue(System&, double);
+
+        //!Start tracking a newly added system's object query.
+        void trackSystemQuery(System&);
+
+        //!Stop tracking a removed system's object query.
+        void releaseSystemQuery(System&);
+
+        //!Update a system with the time since it last updated, timing it against its budget.
+        void runSystem(System&, JobSystem&);
+
+        //!Apply deferred commands, then sync the MessageHub and run its deferred handlers.
+        void syncPhase();
+
+        //!Build the dependency graph from the systems' declarations.
+        void buildSchedule();
+
+        //!Run the systems in parallel following the dependency graph, one phase at a time.
+        void updateSystemsInParallel(double);
+
+        //!Run the systems in a range of the schedule in parallel. Undeclared systems run on the calling thread.
+        void updatePhaseInParallel(std::size_t, std::size_t, const std::vector<bool>&, std::thread::id);
+
+        //!Run a system on a worker and report it as finished.
+        void runScheduledSystem(std::size_t);
+
         ObjectManager& objManager;
         MessageHub& msgHub;
 
         std::list<systemPtr<System>> systemList;
 
+        //!Removes each type of system ever added, so a later manager with the same version starts without them.
+        std::vector<void (SystemManager::*)()> systemRemovers;
+
+        JobSystem* jobSystem;
+
+        uint64_t tick;
+
+        bool timingEnabled;
+
+        //!Given to systems when no job system is set.
+        JobSystem inlineJobs;
+
+        std::vector<SystemNode> schedule;
+
+        //!Where each phase's systems start in the schedule, with the end of the schedule last.
+        std::vector<std::size_t> phaseStarts;
+
+        //!Set when systems are added or removed so the graph is rebuilt before the next update.
+        bool scheduleChanged;
+
+        //!Systems that have finished but have not been handled by the updating thread yet.
+        std::mutex finishedMutex;
+        std::condition_variable finishedCondition;
+        std::vector<std::size_t> finishedSystems;
+
         //!Used to get a system by type.
         template<typename T>
         systemPtr<T>& system(systemPtr<T> systemPointer = systemPtr<T>()) const;
@@ -97,20 +221,30 @@ class SystemManager : NonCopyable
 
 /** \brief Add a new system to the manager.
  *
+ * \param phase The phase to run the system in. It runs after the systems already in that phase.
  */
 template<typename T>
-void SystemManager::addSystem()
+void SystemManager::addSystem(SystemPhase phase)
 {
     if(!system<T>())
     {
         //Create the system
         systemPtr<T> _system(new T());
+        _system->phase = phase;
 
         //Store a pointer to the system.
         system(_system);
 
-        //Add the system to the list
-        systemList.push_back(std::static_pointer_cast<System>(_system));
+        //Add the system after the last one in the same or an earlier phase
+        auto position = std::find_if(systemList.begin(), systemList.end(),
+                                     [phase](const systemPtr<System>& sys) { return sys->phase > phase; });
+        systemList.insert(position, std::static_pointer_cast<System>(_system));
+        scheduleChanged = true;
+
+        trackSystemQuery(*_system);
+
+        if(std::find(systemRemovers.begin(), systemRemovers.end(), &SystemManager::removeSystem<T>) == systemRemovers.end())
+            systemRemovers.push_back(&SystemManager::removeSystem<T>);
     }
 }
 
@@ -121,8 +255,10 @@ void SystemManager::removeSystem()
 {
     if(system<T>())
     {
+        releaseSystemQuery(*system<T>());
         systemList.remove(std::static_pointer_cast<System>(system<T>()));
         system<T>().reset();
+        scheduleChanged = true;
     }
 }
 
@@ -144,7 +280,41 @@ template<typename T>
 void SystemManager::updateSystem(double dt)
 {
     if(system<T>())
-        system<T>()->update(objManager, msgHub, dt);
+        system<T>()->update(objManager, msgHub, getJobSystem(), dt);
+}
+
+/** \brief Set how often a system updates. The system is given the phase that shares the fewest ticks with
+ *         systems that already have a divisor, so that slow systems take turns.
+ *
+ * \param divisor The system updates on one tick out of this many. 1 updates it every tick.
+ */
+template<typename T>
+void SystemManager::setRateDivisor(unsigned int divisor)
+{
+    if(!system<T>())
+        return;
+
+    System& sys = *system<T>();
+    divisor = std::max(1u, divisor);
+
+    sys.rateDivisor = divisor;
+    sys.ratePhase = pickRatePhase(sys, divisor);
+}
+
+template<typename T>
+SystemTimingStats SystemManager::getTimingStats() const
+{
+    if(!system<T>())
+        return SystemTimingStats{0, 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+
+    return system<T>()->getTimings().getStats();
+}
+
+template<typename T>
+void SystemManager::setTimeBudget(double seconds)
+{
+    if(system<T>())
+        system<T>()->timings.setBudget(seconds);
 }
 
 /** \brief Stores a pointer to a system in memory. If a value is given to the function,
@@ -158,7 +328,8 @@ void SystemManager::updateSystem(double dt)
 template<typename T>
 systemPtr<T>& SystemManager::system(systemPtr<T> systemPointer) const
 {
-    static std::map<ID, systemPtr<T> > _system;
+    //Never destroyed, so managers destroyed during static destruction can still remove their systems
+    static std::map<ID, systemPtr<T> >& _system = *new std::map<ID, systemPtr<T> >();
 
     if(systemPointer != systemPtr<T>())
         _system[version] = systemPointer;
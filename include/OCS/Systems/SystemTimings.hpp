@@ -0,0 +1,105 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_SYSTEMTIMINGS_H
+#define OCS_SYSTEMTIMINGS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "OCS/Messaging/Message.hpp"
+
+namespace ocs
+{
+
+//!A summary of a system's recent update times, in seconds.
+struct SystemTimingStats
+{
+    std::size_t samples;
+    double last;
+    double mean;
+    double p50;
+    double p99;
+    double max;
+    uint64_t timesOverBudget;
+};
+
+/** \brief Keeps a system's most recent update times in a fixed window, and its time budget. Each system's
+ *         timings are only written by the thread running it, so they should be read between updates.
+ */
+class SystemTimings
+{
+    public:
+
+        static const std::size_t windowSize = 128;
+
+        SystemTimings();
+
+        void record(double);
+
+        //!Get the mean, median, 99th percentile and largest time in the window, and the total updates over budget.
+        SystemTimingStats getStats() const;
+
+        void clear();
+
+        //!Set the longest an update should take. 0 means no budget.
+        void setBudget(double seconds) { budget = seconds; }
+        double getBudget() const { return budget; }
+
+        //!Check if a time is over the budget, and count it if so.
+        bool checkBudget(double);
+
+        //!Get the number of updates that went over the budget.
+        uint64_t getTimesOverBudget() const { return timesOverBudget; }
+
+    private:
+
+        std::vector<double> samples;
+        std::size_t nextSample;
+        double lastSample;
+
+        double budget;
+        uint64_t timesOverBudget;
+};
+
+/** \brief Posted by the SystemManager, with the system as the sender, when a system's update takes longer than
+ *         its budget.
+ */
+struct SystemOverBudget : public Message<SystemOverBudget>
+{
+    SystemOverBudget(const Transceiver& system, double _elapsed, double _budget) : Message(system),
+        elapsed(_elapsed), budget(_budget) {}
+
+    void log(std::ostream& out)
+    {
+        out << "Message Type: SystemOverBudget\n";
+        out << "Sender: " << getSender() << std::endl;
+        out << "Elapsed: " << elapsed << "s, budget: " << budget << "s\n";
+    }
+
+    double elapsed;
+    double budget;
+};
+
+}//ocs
+
+#endif
@@ -0,0 +1,128 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef OCS_BINARYSTREAM_H
+#define OCS_BINARYSTREAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**\brief BinaryWriter -
+*           Appends values to a growable byte buffer in a compact binary form. Arithmetic values are
+*           written in the host's byte order, integers may also be written as variable length integers
+*           (7 bits per byte) and strings are written as a varint length followed by their characters.
+*
+*           e.g. writer.write(5.0f); writer.writeVarint(300); writer.writeString("Hello");
+*
+*           A BinaryReader reads the values back in the same order they were written.
+*/
+class BinaryWriter
+{
+    public:
+
+        //!Write an arithmetic value as raw bytes.
+        template<typename T>
+        void write(const T&);
+
+        //!Write an unsigned integer using as few bytes as possible.
+        void writeVarint(uint64_t);
+
+        //!Write a string prefixed with its length.
+        void writeString(const std::string&);
+
+        //!Write a block of raw bytes.
+        void writeBytes(const void*, std::size_t);
+
+        //!Get the bytes that have been written so far.
+        const std::vector<char>& getBuffer() const { return buffer; }
+        std::vector<char>& getBuffer() { return buffer; }
+
+        std::size_t size() const { return buffer.size(); }
+        void reserve(std::size_t bytes) { buffer.reserve(bytes); }
+        void clear() { buffer.clear(); }
+
+    private:
+
+        std::vector<char> buffer;
+};
+
+/**\brief BinaryReader -
+*           Reads values from a block of bytes that was produced by a BinaryWriter. The reader does not
+*           own the bytes, so they must outlive it. Every read returns false if there are not enough bytes
+*           left, after which the reader is no longer good.
+*/
+class BinaryReader
+{
+    public:
+
+        BinaryReader(const char* _data, std::size_t _size) : data(_data), length(_size), position(0), good(true) {}
+        BinaryReader(const std::vector<char>& bytes) : BinaryReader(bytes.data(), bytes.size()) {}
+
+        //!Read an arithmetic value that was written as raw bytes.
+        template<typename T>
+        bool read(T&);
+
+        //!Read an unsigned variable length integer.
+        bool readVarint(uint64_t&);
+
+        //!Read a length prefixed string.
+        bool readString(std::string&);
+
+        //!Read a block of raw bytes.
+        bool readBytes(void*, std::size_t);
+
+        //!Skip over the given number of bytes.
+        bool skip(std::size_t);
+
+        //!Get a pointer to the next unread byte.
+        const char* getCurrent() const { return data + position; }
+
+        std::size_t getPosition() const { return position; }
+        std::size_t getRemaining() const { return length - position; }
+        bool isGood() const { return good; }
+
+    private:
+
+        const char* data;
+        std::size_t length;
+        std::size_t position;
+        bool good;
+};
+
+template<typename T>
+void BinaryWriter::write(const T& value)
+{
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "BinaryWriter::write only accepts arithmetic or enum values");
+    writeBytes(&value, sizeof(T));
+}
+
+template<typename T>
+bool BinaryReader::read(T& value)
+{
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "BinaryReader::read only accepts arithmetic or enum values");
+    return readBytes(&value, sizeof(T));
+}
+
+#endif
@@ -115,25 +115,21 @@ class PackedArray : public BasePackedArray
 
         Index add_item(const T& item)
         {
-            Index newIdx;
             elements.push_back(item);
+            return linkNewElement();
+        }
 
-            if(availableIndeces.size() > 0)
-            {
-               // std::cout << "Free indexes\n";
-                newIdx = availableIndeces.top();
-                elementIndeces[newIdx] = size() - 1;
-                reverseLookupList[size() - 1] = newIdx;
-                availableIndeces.pop();
-            }
-            else
-            {
-               // std::cout << "No free indexes\n";
-                newIdx = elements.size() - 1;
-                elementIndeces.push_back(newIdx);
-                reverseLookupList.push_back(newIdx);
-            }
-            return newIdx;
+        void reserve(std::size_t numberToReserve)
+        {
+            elements.reserve(numberToReserve);
+            elementIndeces.reserve(numberToReserve);
+            reverseLookupList.reserve(numberToReserve);
+        }
+
+        Index add_item(T&& item)
+        {
+            elements.push_back(std::move(item));
+            return linkNewElement();
         }
 
         template<typename ... Args>
@@ -170,7 +166,7 @@ class PackedArray : public BasePackedArray
                 elements[indexToRemove] = elements[size() - 1];
                 elements.pop_back();
 
-                // elementIndeces[idx] = INVALID_INDEX;
+                elementIndeces[idx] = INVALID_INDEX;
 
                 availableIndeces.push(idx);
             }
@@ -190,6 +186,29 @@ class PackedArray : public BasePackedArray
 
     private:
 
+        //!Assign an index to the element that was just pushed to the back of the array.
+        Index linkNewElement()
+        {
+            Index newIdx;
+
+            if(availableIndeces.size() > 0)
+            {
+               // std::cout << "Free indexes\n";
+                newIdx = availableIndeces.top();
+                elementIndeces[newIdx] = size() - 1;
+                reverseLookupList[size() - 1] = newIdx;
+                availableIndeces.pop();
+            }
+            else
+            {
+               // std::cout << "No free indexes\n";
+                newIdx = elements.size() - 1;
+                elementIndeces.push_back(newIdx);
+                reverseLookupList.push_back(newIdx);
+            }
+            return newIdx;
+        }
+
         std::vector<T> elements;
         std::vector<Index> elementIndeces;
         std::vector<Index> reverseLookupList;
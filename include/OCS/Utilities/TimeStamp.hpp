@@ -23,10 +23,12 @@ freely, subject to the following restrictions:
 #ifndef _TIMESTAMP_H
 #define _TIMESTAMP_H
 
+#include <ctime>
 #include <string>
 struct TimeStamp
 {
     static std::string getTimeStamp(const std::string&);
+    static std::string getTimeStamp(const std::string&, time_t);
 };
 
 #endif
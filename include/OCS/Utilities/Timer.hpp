@@ -33,7 +33,7 @@ class Timer
         double getElapsedTime();
 
     private:
-        std::chrono::time_point<std::chrono::system_clock> start;
+        std::chrono::time_point<std::chrono::steady_clock> start;
 };
 
 #endif
@@ -0,0 +1,324 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Commands/CommandBuffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
+
+namespace ocs
+{
+
+namespace
+{
+
+thread_local uint64_t currentSortKey = 0;
+
+//!The last DeferredCommands each thread asked for a buffer from, so the lookup usually needs no lock.
+struct CachedBuffer
+{
+    uint64_t instanceID;
+    CommandBuffer* buffer;
+};
+
+thread_local CachedBuffer cachedBuffer = {0, nullptr};
+
+std::atomic<uint64_t> instanceCounter(1);
+
+struct PairHash
+{
+    std::size_t operator()(const std::pair<ID, Family>& key) const
+    {
+        return std::hash<ID>()(key.first) ^ (std::hash<Family>()(key.second) * 0x9E3779B97F4A7C15ull);
+    }
+};
+
+}//namespace
+
+const ID CommandBuffer::deferredFlag;
+const unsigned int CommandBuffer::bufferShift;
+
+/** \brief Set the sort key for every command the calling thread records from now on.
+ *         The SystemManager sets this to the running system's position so the order is the same every run.
+ */
+void CommandBuffer::setSortKey(uint64_t sortKey)
+{
+    currentSortKey = sortKey;
+}
+
+uint64_t CommandBuffer::getSortKey()
+{
+    return currentSortKey;
+}
+
+/** \brief Record creating a blank object.
+ *
+ * \return A deferred id that can be used with other recorded commands.
+ */
+ID CommandBuffer::createObject()
+{
+    ID deferredID = deferredFlag | (bufferIndex << bufferShift) | totalCreated++;
+    record(Create, deferredID);
+    return deferredID;
+}
+
+/** \brief Record creating an object from a prototype. If the prototype does not exist when the
+ *         commands are applied, no object is created and commands for the deferred id are ignored.
+ *
+ * \param prototypeName The name of the prototype.
+ * \return A deferred id that can be used with other recorded commands.
+ */
+ID CommandBuffer::createObject(const std::string& prototypeName)
+{
+    ID deferredID = deferredFlag | (bufferIndex << bufferShift) | totalCreated++;
+    record(CreateFromPrototype, deferredID, 0, prototypeNames.size());
+    prototypeNames.push_back(prototypeName);
+    return deferredID;
+}
+
+void CommandBuffer::destroyObject(ID objectID)
+{
+    record(Destroy, objectID);
+}
+
+void CommandBuffer::record(OperationType type, ID objectID, Family compFamily, uint32_t payload)
+{
+    Operation operation;
+    operation.sortKey = currentSortKey;
+    operation.objectID = objectID;
+    operation.family = compFamily;
+    operation.payload = payload;
+    operation.type = type;
+
+    operations.push_back(operation);
+}
+
+//!Empty the buffer but keep its memory for the next frame
+void CommandBuffer::clear()
+{
+    operations.clear();
+    prototypeNames.clear();
+    createdIDs.clear();
+    totalCreated = 0;
+
+    for(auto& store : stores)
+        store.second->clear();
+}
+
+DeferredCommands::DeferredCommands() :
+    instanceID(instanceCounter++)
+{
+
+}
+
+/** \brief Get the command buffer that belongs to the calling thread. One is created the first time a thread asks.
+ *
+ * \return The calling thread's buffer.
+ */
+CommandBuffer& DeferredCommands::getBuffer()
+{
+    if(cachedBuffer.instanceID == instanceID)
+        return *cachedBuffer.buffer;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    auto& buffer = threadBuffers[std::this_thread::get_id()];
+    if(!buffer)
+    {
+        buffers.emplace_back(new CommandBuffer(buffers.size()));
+        buffer = buffers.back().get();
+    }
+
+    cachedBuffer.instanceID = instanceID;
+    cachedBuffer.buffer = buffer;
+
+    return *buffer;
+}
+
+std::size_t DeferredCommands::getTotalCommands()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    std::size_t total = 0;
+    for(const auto& buffer : buffers)
+        total += buffer->getTotalCommands();
+
+    return total;
+}
+
+/** \brief Apply every recorded command and empty the buffers. Must not be called while other threads are recording.
+ *
+ * \param objManager The ObjectManager to apply the commands to.
+ */
+void DeferredCommands::apply(ObjectManager& objManager)
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    struct OperationRef
+    {
+        const CommandBuffer::Operation* operation;
+        CommandBuffer* buffer;
+    };
+
+    //Gather every command in buffer order, then order by sort key
+    std::vector<OperationRef> ordered;
+    for(auto& buffer : buffers)
+        for(const auto& operation : buffer->operations)
+            ordered.push_back({&operation, buffer.get()});
+
+    if(ordered.empty())
+        return;
+
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const OperationRef& lhs, const OperationRef& rhs) { return lhs.operation->sortKey < rhs.operation->sortKey; });
+
+    const ID localMask = (ID(1) << CommandBuffer::bufferShift) - 1;
+
+    auto resolve = [&](ID objectID)
+    {
+        if(!CommandBuffer::isDeferredID(objectID))
+            return objectID;
+
+        ID bufferIndex = (objectID & ~CommandBuffer::deferredFlag) >> CommandBuffer::bufferShift;
+        ID localIndex = objectID & localMask;
+
+        if(bufferIndex < buffers.size() && localIndex < buffers[bufferIndex]->createdIDs.size())
+            return buffers[bufferIndex]->createdIDs[localIndex];
+        return ID(-1);
+    };
+
+    for(auto& buffer : buffers)
+        buffer->createdIDs.assign(buffer->totalCreated, ID(-1));
+
+    std::vector<OperationRef> changes;
+
+    //Create objects first so every deferred id can be resolved
+    for(const auto& ref : ordered)
+    {
+        const auto& operation = *ref.operation;
+
+        switch(operation.type)
+        {
+            case CommandBuffer::Create:
+                ref.buffer->createdIDs[operation.objectID & localMask] = objManager.createObject();
+                break;
+
+            case CommandBuffer::CreateFromPrototype:
+                ref.buffer->createdIDs[operation.objectID & localMask] = objManager.createObject(ref.buffer->prototypeNames[operation.payload]);
+                break;
+
+            default:
+                changes.push_back(ref);
+                break;
+        }
+    }
+
+    std::vector<OperationRef> removals;
+    std::vector<OperationRef> additions;
+    std::vector<ID> destructions;
+
+    //The (object, component type) pairs and destroyed objects in the current run
+    std::unordered_set<std::pair<ID, Family>, PairHash> touched;
+    std::unordered_set<ID> destroyed;
+
+    auto byFamily = [](const OperationRef& lhs, const OperationRef& rhs) { return lhs.operation->family < rhs.operation->family; };
+
+    auto applyRun = [&]()
+    {
+        //Remove components one component type at a time
+        std::stable_sort(removals.begin(), removals.end(), byFamily);
+        for(const auto& ref : removals)
+            objManager.detachComponent(resolve(ref.operation->objectID), ref.operation->family);
+
+        //Add components one component type at a time, growing each array once
+        std::stable_sort(additions.begin(), additions.end(), byFamily);
+        for(std::size_t first = 0; first < additions.size();)
+        {
+            Family compFamily = additions[first].operation->family;
+
+            std::size_t last = first;
+            while(last < additions.size() && additions[last].operation->family == compFamily)
+                ++last;
+
+            additions[first].buffer->stores[compFamily]->reserve(objManager, last - first);
+
+            for(; first < last; ++first)
+            {
+                const auto& ref = additions[first];
+                ref.buffer->stores[compFamily]->add(objManager, resolve(ref.operation->objectID), ref.operation->payload);
+            }
+        }
+
+        for(auto objectID : destructions)
+        {
+            if(objManager.objects.isValid(objectID))
+                objManager.destroyObject(objectID);
+        }
+
+        removals.clear();
+        additions.clear();
+        destructions.clear();
+        touched.clear();
+        destroyed.clear();
+    };
+
+    //Batch the changes in runs where no two commands touch the same component of the same object, so
+    //reordering within a run can not change the result. Each object's commands keep their recorded order.
+    for(const auto& ref : changes)
+    {
+        const auto& operation = *ref.operation;
+        ID objectID = resolve(operation.objectID);
+
+        if(destroyed.count(objectID) ||
+           (operation.type != CommandBuffer::Destroy && touched.count(std::make_pair(objectID, operation.family))))
+            applyRun();
+
+        switch(operation.type)
+        {
+            case CommandBuffer::Add:
+                additions.push_back(ref);
+                touched.insert(std::make_pair(objectID, operation.family));
+                break;
+
+            case CommandBuffer::Remove:
+                removals.push_back(ref);
+                touched.insert(std::make_pair(objectID, operation.family));
+                break;
+
+            case CommandBuffer::Destroy:
+                destructions.push_back(objectID);
+                destroyed.insert(objectID);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    applyRun();
+
+    for(auto& buffer : buffers)
+        buffer->clear();
+}
+
+}//ocs
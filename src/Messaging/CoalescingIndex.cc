@@ -0,0 +1,139 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/CoalescingIndex.hpp"
+
+namespace ocs
+{
+
+CoalescingIndex::CoalescingIndex() :
+    entries(16, Entry{0, 0, 0}),
+    generation(1),
+    count(0)
+{
+
+}
+
+uint64_t CoalescingIndex::hash(ID key)
+{
+    //Mix the bits so sequential keys spread over the table
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return key;
+}
+
+/** \brief Find a key with linear probing, adding it if it is missing.
+ *
+ * \param key The message key.
+ * \param position The position to store if the key is new.
+ * \param inserted Set to true if the key was added.
+ * \return The position stored for the key.
+ */
+uint32_t CoalescingIndex::findOrInsert(ID key, uint32_t position, bool& inserted)
+{
+    //Keep the table at most half full so probes stay short
+    if((count + 1) * 2 > entries.size())
+        grow();
+
+    std::size_t mask = entries.size() - 1;
+
+    for(std::size_t slot = hash(key) & mask;; slot = (slot + 1) & mask)
+    {
+        Entry& entry = entries[slot];
+
+        if(entry.generation != generation)
+        {
+            entry.key = key;
+            entry.position = position;
+            entry.generation = generation;
+            ++count;
+
+            inserted = true;
+            return position;
+        }
+
+        if(entry.key == key)
+        {
+            inserted = false;
+            return entry.position;
+        }
+    }
+}
+
+/** \brief Find a key with linear probing.
+ *
+ * \param key The key to look for.
+ * \param position Set to the key's position if it is found.
+ * \return True if the key was found.
+ */
+bool CoalescingIndex::find(ID key, uint32_t& position) const
+{
+    std::size_t mask = entries.size() - 1;
+
+    for(std::size_t slot = hash(key) & mask;; slot = (slot + 1) & mask)
+    {
+        const Entry& entry = entries[slot];
+
+        if(entry.generation != generation)
+            return false;
+
+        if(entry.key == key)
+        {
+            position = entry.position;
+            return true;
+        }
+    }
+}
+
+void CoalescingIndex::clear()
+{
+    count = 0;
+
+    //Entries from an old generation could look live again once the counter wraps
+    if(++generation == 0)
+    {
+        for(auto& entry : entries)
+            entry.generation = 0;
+        generation = 1;
+    }
+}
+
+void CoalescingIndex::grow()
+{
+    std::vector<Entry> oldEntries(entries.size() * 2, Entry{0, 0, 0});
+    oldEntries.swap(entries);
+
+    uint32_t oldGeneration = generation;
+    generation = 1;
+    count = 0;
+
+    bool inserted = false;
+    for(const auto& entry : oldEntries)
+        if(entry.generation == oldGeneration)
+            findOrInsert(entry.key, entry.position, inserted);
+}
+
+}//ocs
@@ -24,15 +24,60 @@ freely, subject to the following restrictions:
 #include <OCS/Messaging/Transceiver.hpp>
 #include <OCS/Utilities/TimeStamp.hpp>
 
+#include <chrono>
+
 namespace ocs
 {
 
-BaseMessage::Family BaseMessage::familyCounter = 0;
+namespace
+{
+
+//!Pairs a wall clock time with a steady clock time so steady stamps can be shown as local time
+struct ClockEpoch
+{
+    std::chrono::system_clock::time_point wallTime;
+    std::chrono::steady_clock::time_point steadyTime;
+};
+
+const ClockEpoch& getClockEpoch()
+{
+    static ClockEpoch epoch = {std::chrono::system_clock::now(), std::chrono::steady_clock::now()};
+    return epoch;
+}
+
+}//namespace
+
+const ID MessageMetadata::noTopic;
+
+std::atomic<BaseMessage::Family> BaseMessage::familyCounter(0);
 
 BaseMessage::BaseMessage(const Transceiver& _transceiver) :
-    senderID(_transceiver.getID()), timeStamp(TimeStamp::getTimeStamp("%Y-%m-%d %I:%M:%S %p %Z"))
+    senderID(_transceiver.getID())
+{
+    metadata.timeNanoseconds = getMonotonicTime();
+    metadata.frame = 0;
+    metadata.sequence = 0;
+    metadata.topic = MessageMetadata::noTopic;
+}
+
+uint64_t BaseMessage::getMonotonicTime()
 {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** \brief Convert the message's steady clock stamp to wall clock time and format it.
+ *
+ * \return The time the message was created, e.g. "2014-02-22 09:15:02 PM EST".
+ */
+std::string BaseMessage::getTimeStamp() const
+{
+    using namespace std::chrono;
+
+    const auto& epoch = getClockEpoch();
+    auto sinceEpoch = nanoseconds(metadata.timeNanoseconds) - duration_cast<nanoseconds>(epoch.steadyTime.time_since_epoch());
+    auto wallTime = epoch.wallTime + duration_cast<system_clock::duration>(sinceEpoch);
 
+    return TimeStamp::getTimeStamp("%Y-%m-%d %I:%M:%S %p %Z", system_clock::to_time_t(wallTime));
 }
 
 }//ocs
@@ -22,10 +22,184 @@ freely, subject to the following restrictions:
 
 #include "OCS/Messaging/MessageHub.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 namespace ocs
 {
 
-ID MessageHub::transceiverIdCounter = 0;
+namespace
+{
+
+//!The last hub each thread posted to from outside the hub's thread, so the lookup usually skips the queue list.
+struct CachedQueue
+{
+    uint64_t instanceID;
+    MessageQueue* queue;
+};
+
+thread_local CachedQueue cachedQueue = {0, nullptr};
+
+}//namespace
+
+const double MessageHub::timerResolution = 0.001;
+
+std::atomic<ID> MessageHub::transceiverIdCounter(0);
+std::atomic<uint64_t> MessageHub::instanceCounter(1);
+
+MessageHub::MessageHub() :
+    doubleBuffered(false),
+    currentTime(0.0),
+    currentTick(0),
+    defaultMailboxCapacity(1024),
+    defaultOverflowPolicy(OverflowPolicy::DropOldest),
+    dispatchDepth(0),
+    hasInactiveSubscriptions(false),
+    currentFrame(0),
+    messageSequence(0),
+    ownerThread(std::this_thread::get_id()),
+    producerQueues(nullptr),
+    instanceID(instanceCounter++),
+    waitingForMessages(false),
+    wakeRequested(false)
+{
+
+}
+
+MessageHub::~MessageHub()
+{
+    //Commit anything still queued so the messages are destroyed with the board
+    syncMessages();
+
+    MessageQueue* queue = producerQueues.load(std::memory_order_acquire);
+    while(queue)
+    {
+        MessageQueue* next = queue->nextQueue;
+        delete queue;
+        queue = next;
+    }
+}
+
+/** \brief Get the calling thread's producer queue. Queues are pushed onto a lock-free list the first time a
+ *         thread posts, and are found again through a thread local cache or by walking the list.
+ *
+ * \return The calling thread's queue.
+ */
+MessageQueue& MessageHub::getProducerQueue()
+{
+    if(cachedQueue.instanceID == instanceID)
+        return *cachedQueue.queue;
+
+    auto threadID = std::this_thread::get_id();
+    MessageQueue* queue = producerQueues.load(std::memory_order_acquire);
+
+    while(queue && queue->getProducer() != threadID)
+        queue = queue->nextQueue;
+
+    if(!queue)
+    {
+        queue = new MessageQueue(threadID);
+        queue->nextQueue = producerQueues.load(std::memory_order_relaxed);
+
+        while(!producerQueues.compare_exchange_weak(queue->nextQueue, queue, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    cachedQueue.instanceID = instanceID;
+    cachedQueue.queue = queue;
+
+    return *queue;
+}
+
+/** \brief Move every message other threads have posted so far onto the board. Immediate handlers are
+ *         called for them here, on the hub's thread. Must be called from the hub's thread.
+ *
+ *         Messages are moved in order of their sort keys, then by the order they were posted on each thread,
+ *         so the board's order does not depend on which threads ran which systems.
+ *
+ * \return The number of messages moved.
+ */
+std::size_t MessageHub::syncMessages()
+{
+    pendingMessages.clear();
+
+    MessageQueue* queues = producerQueues.load(std::memory_order_acquire);
+    for(MessageQueue* queue = queues; queue; queue = queue->nextQueue)
+        queue->collect(pendingMessages);
+
+    if(pendingMessages.empty())
+        return 0;
+
+    std::stable_sort(pendingMessages.begin(), pendingMessages.end(),
+                     [](const MessageQueue::PendingMessage& lhs, const MessageQueue::PendingMessage& rhs) { return lhs.sortKey < rhs.sortKey; });
+
+    for(const auto& pending : pendingMessages)
+        MessageQueue::commit(*this, pending);
+
+    for(MessageQueue* queue = queues; queue; queue = queue->nextQueue)
+        queue->release();
+
+    return pendingMessages.size();
+}
+
+void MessageHub::waitForMessages()
+{
+    waitForMessages(-1.0);
+}
+
+/** \brief Sleep until another thread queues a message or calls wake. Messages that were already queued are synced
+ *         and returned for right away.
+ *
+ * \param timeout The longest to wait in seconds. Negative to wait with no limit.
+ * \return True if messages were synced or wake was called. False if the timeout passed first.
+ */
+bool MessageHub::waitForMessages(double timeout)
+{
+    waitingForMessages.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool woken = syncMessages() > 0;
+
+    if(!woken && timeout != 0.0)
+    {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        auto isWoken = [this]() { return wakeRequested; };
+
+        if(timeout < 0.0)
+            wakeCondition.wait(lock, isWoken);
+        else
+            wakeCondition.wait_for(lock, std::chrono::duration<double>(timeout), isWoken);
+
+        woken = wakeRequested;
+    }
+
+    waitingForMessages.store(false, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeRequested = false;
+    }
+
+    return syncMessages() > 0 || woken;
+}
+
+void MessageHub::wake()
+{
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeRequested = true;
+    wakeCondition.notify_one();
+}
+
+bool MessageHub::getNextScheduledTime(double& time) const
+{
+    uint64_t dueTick = 0;
+
+    if(!timers.getEarliestDueTick(dueTick))
+        return false;
+
+    time = dueTick * timerResolution;
+    return true;
+}
 
 ID MessageHub::getNewTransceiverID()
 {
@@ -34,43 +208,333 @@ ID MessageHub::getNewTransceiverID()
 
 void MessageHub::clearPostedMessages()
 {
-    for(auto& messageSlot : messageBoard)
-        clearMessageSlot(messageSlot.second);
+    if(statistics)
+        recordSlotSizes();
+
+    clearUsedSlots(messageBoard, usedFamilies);
+    clearUsedSlots(readBoard, readUsedFamilies);
+
+    for(auto& subList : subscribers)
+    {
+        subList.dispatched = 0;
+        subList.redispatch.clear();
+    }
+}
+
+/** \brief Start a new frame. When double-buffered, the board that was being written becomes the one that is
+ *         read, and last frame's read board is emptied and reused for writing. Only the slots that had
+ *         messages are touched. Messages that were not dispatched before the swap are not dispatched.
+ */
+void MessageHub::advanceFrame()
+{
+    for(auto tap : taps)
+        tap->onFrameEnd();
+
+    if(statistics)
+    {
+        recordSlotSizes();
+        statistics->endFrame();
+    }
+
+    ++currentFrame;
+
+    if(!doubleBuffered)
+        return;
+
+    std::swap(messageBoard, readBoard);
+    std::swap(usedFamilies, readUsedFamilies);
+    clearUsedSlots(messageBoard, usedFamilies);
+
+    for(auto& subList : subscribers)
+    {
+        subList.dispatched = 0;
+        subList.redispatch.clear();
+    }
+}
+
+/** \brief Move the hub's clock forward and post the scheduled messages that have become due, in the order
+ *         they were due. Messages due on the same millisecond are posted in the order they were scheduled.
+ *
+ * \param dt The time that has passed in seconds.
+ */
+void MessageHub::advanceTime(double dt)
+{
+    currentTime += dt;
+
+    currentTick = static_cast<uint64_t>(std::floor(currentTime / timerResolution + 1e-6));
+
+    expiredTimers.clear();
+    timers.advance(currentTick, expiredTimers);
+
+    for(const auto& timer : expiredTimers)
+        scheduledMessages[timer.family]->deliver(*this, timer.index);
+}
+
+void MessageHub::addMessageTap(MessageTap* tap)
+{
+    if(std::find(taps.begin(), taps.end(), tap) == taps.end())
+        taps.push_back(tap);
+}
+
+void MessageHub::removeMessageTap(MessageTap* tap)
+{
+    taps.erase(std::remove(taps.begin(), taps.end(), tap), taps.end());
+}
+
+void MessageHub::tapMessage(const BaseMessage& msg, Family family, PostKind kind, ID key)
+{
+    for(auto tap : taps)
+        tap->onMessage(msg, family, kind, key);
+}
+
+uint64_t MessageHub::getTimerTick(double time)
+{
+    if(time <= 0.0)
+        return 0;
+
+    //Allow a little rounding error so whole milliseconds are not pushed to the next tick
+    return static_cast<uint64_t>(std::ceil(time / timerResolution - 1e-6));
+}
+
+void MessageHub::setDoubleBuffered(bool enabled)
+{
+    clearPostedMessages();
+    doubleBuffered = enabled;
+}
+
+void MessageHub::clearUsedSlots(MessageBoard& msgBoard, std::vector<Family>& used)
+{
+    for(auto family : used)
+        msgBoard[family]->clear();
+
+    used.clear();
 }
 
 void MessageHub::clearPrivateMessages(const Transceiver& transceiver)
 {
-    for(auto& messageSlot : privateMessages[transceiver.getID()])
-        clearMessageSlot(messageSlot.second);
+    auto mailbox = mailboxes.find(transceiver.getID());
+    if(mailbox == mailboxes.end())
+        return;
+
+    for(auto& slot : mailbox->second.slots)
+        if(slot)
+            slot->clear();
 }
 
-void MessageHub::logMessages(const MessageBoard& msgBoard, std::ostream& out)
+void MessageHub::configureMailbox(const Transceiver& transceiver, std::size_t capacity, OverflowPolicy policy)
+{
+    auto& mailbox = getMailbox(transceiver.getID());
+
+    mailbox.capacity = capacity;
+    mailbox.policy = policy;
+    mailbox.slots.clear();
+}
+
+void MessageHub::setDefaultMailbox(std::size_t capacity, OverflowPolicy policy)
+{
+    defaultMailboxCapacity = capacity;
+    defaultOverflowPolicy = policy;
+}
+
+std::size_t MessageHub::getDroppedMessages(const Transceiver& transceiver) const
+{
+    auto mailbox = mailboxes.find(transceiver.getID());
+    return (mailbox != mailboxes.end()) ? mailbox->second.dropped : 0;
+}
+
+Mailbox& MessageHub::getMailbox(ID receiverID)
+{
+    auto mailbox = mailboxes.find(receiverID);
+
+    if(mailbox == mailboxes.end())
+        mailbox = mailboxes.emplace(receiverID, Mailbox(defaultMailboxCapacity, defaultOverflowPolicy)).first;
+
+    return mailbox->second;
+}
+
+void MessageHub::unsubscribeAll(const Transceiver& transceiver)
 {
-    for(const auto& msgTypeArrays : msgBoard)
+    for(auto& subList : subscribers)
     {
-        for(const auto& msgs : msgTypeArrays.second)
+        removeSubscriptions(subList.immediate, transceiver.getID());
+        removeSubscriptions(subList.deferred, transceiver.getID());
+    }
+}
+
+void MessageHub::removeSubscriptions(SubscriptionList& subscriptions, ID transceiverID)
+{
+    if(dispatchDepth > 0)
+    {
+        for(auto& sub : subscriptions)
         {
-            out << msgs->getTimeStamp() << std::endl;
-            msgs->log(out);
-            out << std::endl;
+            if(sub.transceiverID == transceiverID && sub.active)
+            {
+                sub.active = false;
+                hasInactiveSubscriptions = true;
+            }
         }
     }
+    else
+    {
+        subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                           [transceiverID](const Subscription& sub) { return sub.transceiverID == transceiverID; }),
+                            subscriptions.end());
+    }
 }
 
+void MessageHub::compactSubscriptions()
+{
+    auto isInactive = [](const Subscription& sub) { return !sub.active; };
 
-void MessageHub::logPostedMessages(std::ostream& out)
+    for(auto& subList : subscribers)
+    {
+        subList.immediate.erase(std::remove_if(subList.immediate.begin(), subList.immediate.end(), isInactive), subList.immediate.end());
+        subList.deferred.erase(std::remove_if(subList.deferred.begin(), subList.deferred.end(), isInactive), subList.deferred.end());
+    }
+
+    hasInactiveSubscriptions = false;
+}
+
+/** \brief Call every active handler in a list. The handlers are given a copy of the message because
+ *         a handler may post more messages of the same type and move the slot.
+ *
+ * \param subscriptions The handlers to call.
+ * \param family The message's family.
+ * \param index The message's position in its slot.
+ */
+void MessageHub::callHandlers(SubscriptionList& subscriptions, Family family, std::size_t index)
+{
+    auto& slot = *messageBoard[family];
+    const BaseMessage& msg = slot.beginDispatch(index);
+
+    ++dispatchDepth;
+
+    for(std::size_t i = 0; i < subscriptions.size(); ++i)
+        if(subscriptions[i].active)
+            subscriptions[i].handler(msg);
+
+    slot.endDispatch();
+
+    if(--dispatchDepth == 0 && hasInactiveSubscriptions)
+        compactSubscriptions();
+}
+
+void MessageHub::dispatchImmediate(Family family, std::size_t index)
 {
-    logMessages(messageBoard, out);
+    callHandlers(subscribers[family].immediate, family, index);
 }
 
-void MessageHub::logPrivateMessages(const Transceiver& transceiver, std::ostream& out)
+/** \brief Pass every message posted since the last dispatch to the deferred handlers of its type.
+ *         Messages posted by handlers during the dispatch are also delivered before this returns.
+ */
+void MessageHub::dispatchMessages()
+{
+    bool delivered = true;
+
+    while(delivered)
+    {
+        delivered = false;
+
+        for(std::size_t f = 0; f < deferredFamilies.size(); ++f)
+        {
+            Family family = deferredFamilies[f];
+
+            if(family >= messageBoard.size() || !messageBoard[family])
+                continue;
+
+            while(subscribers[family].dispatched < messageBoard[family]->size())
+            {
+                delivered = true;
+                callHandlers(subscribers[family].deferred, family, subscribers[family].dispatched++);
+            }
+
+            //Coalesced messages overwritten after they were dispatched
+            std::vector<std::size_t> positions;
+            while(!subscribers[family].redispatch.empty())
+            {
+                delivered = true;
+                positions.swap(subscribers[family].redispatch);
+
+                for(std::size_t i = 0; i < positions.size(); ++i)
+                    callHandlers(subscribers[family].deferred, family, positions[i]);
+
+                //Hand the memory back so later overwrites don't allocate
+                positions.clear();
+                if(subscribers[family].redispatch.empty())
+                    positions.swap(subscribers[family].redispatch);
+            }
+        }
+    }
+}
+
+/** \brief Turn on traffic statistics. Any statistics collected before are discarded.
+ *
+ * \param sampleInterval Measure post to read latency on every this many reads of each thread.
+ */
+void MessageHub::enableStatistics(unsigned int sampleInterval)
+{
+    statistics.reset(new MessageStatistics(sampleInterval));
+}
+
+void MessageHub::disableStatistics()
+{
+    statistics.reset();
+}
+
+const MessageStatistics* MessageHub::getStatistics()
+{
+    if(!statistics)
+        return nullptr;
+
+    statistics->clearAllocatedBytes();
+
+    for(auto board : {&messageBoard, &readBoard})
+        for(std::size_t family = 0; family < board->size(); ++family)
+            if((*board)[family])
+                statistics->addAllocatedBytes(family, (*board)[family]->getAllocatedBytes());
+
+    for(const auto& mailbox : mailboxes)
+        for(std::size_t family = 0; family < mailbox.second.slots.size(); ++family)
+            if(mailbox.second.slots[family])
+                statistics->addAllocatedBytes(family, mailbox.second.slots[family]->getAllocatedBytes());
+
+    return statistics.get();
+}
+
+void MessageHub::writeStatistics(std::ostream& out)
 {
-    logMessages(privateMessages[transceiver.id], out);
+    if(getStatistics())
+        statistics->writeJson(out);
 }
 
-void MessageHub::clearMessageSlot(MessageSlot& msgSlot)
+void MessageHub::recordSlotSizes()
 {
-    msgSlot.clear();
+    for(auto family : usedFamilies)
+        statistics->recordSlotSize(family, messageBoard[family]->size());
+}
+
+void MessageHub::logMessages(const MessageBoard& msgBoard, std::ostream& out)
+{
+    for(const auto& msgSlot : msgBoard)
+        if(msgSlot)
+            msgSlot->log(out);
+}
+
+
+void MessageHub::logPostedMessages(std::ostream& out)
+{
+    logMessages(doubleBuffered ? readBoard : messageBoard, out);
+}
+
+void MessageHub::logPrivateMessages(const Transceiver& transceiver, std::ostream& out)
+{
+    auto mailbox = mailboxes.find(transceiver.getID());
+    if(mailbox == mailboxes.end())
+        return;
+
+    for(auto& slot : mailbox->second.slots)
+        if(slot)
+            slot->log(out);
 }
 
 }//ocs
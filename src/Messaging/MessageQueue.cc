@@ -0,0 +1,163 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/MessageQueue.hpp"
+
+#include <algorithm>
+
+namespace ocs
+{
+
+namespace
+{
+
+thread_local uint64_t currentSortKey = 0;
+
+}//namespace
+
+const std::size_t MessageQueue::chunkSize;
+const std::size_t MessageQueue::alignment;
+
+MessageQueue::Chunk::Chunk(std::size_t _capacity) :
+    committed(0),
+    next(nullptr),
+    capacity(_capacity),
+    data(new char[_capacity])
+{
+
+}
+
+MessageQueue::Chunk::~Chunk()
+{
+    delete [] data;
+}
+
+MessageQueue::MessageQueue(std::thread::id _producer) :
+    nextQueue(nullptr),
+    producer(_producer),
+    writeChunk(new Chunk(chunkSize)),
+    writeOffset(0),
+    readChunk(writeChunk),
+    readOffset(0),
+    collectChunk(writeChunk),
+    collectOffset(0)
+{
+
+}
+
+/** \brief Set the sort key for every message the calling thread queues from now on.
+ *         The SystemManager sets this to the running system's position, along with the CommandBuffer's key.
+ */
+void MessageQueue::setSortKey(uint64_t sortKey)
+{
+    currentSortKey = sortKey;
+}
+
+uint64_t MessageQueue::getSortKey()
+{
+    return currentSortKey;
+}
+
+void MessageQueue::commit(MessageHub& msgHub, const PendingMessage& pending)
+{
+    auto header = reinterpret_cast<RecordHeader*>(pending.record);
+    header->commit(msgHub, pending.record + alignSize(sizeof(RecordHeader)), header->receiverID);
+}
+
+/** \brief Free the remaining chunks. The hub drains the queue first, so there are no messages left to destroy.
+ */
+MessageQueue::~MessageQueue()
+{
+    while(readChunk)
+    {
+        Chunk* next = readChunk->next.load(std::memory_order_acquire);
+        delete readChunk;
+        readChunk = next;
+    }
+}
+
+char* MessageQueue::reserve(std::size_t recordSize)
+{
+    if(writeOffset + recordSize > writeChunk->capacity)
+    {
+        Chunk* chunk = new Chunk(std::max(chunkSize, recordSize));
+
+        //The consumer moves to the new chunk once it sees it, so everything in the old one must already be committed
+        writeChunk->next.store(chunk, std::memory_order_release);
+        writeChunk = chunk;
+        writeOffset = 0;
+    }
+
+    return writeChunk->data + writeOffset;
+}
+
+/** \brief Find every message the producer has published so far, in the order they were pushed. The messages
+ *         stay in the queue until they are committed and release is called.
+ *
+ * \param pending The list to append the messages to.
+ */
+void MessageQueue::collect(std::vector<PendingMessage>& pending)
+{
+    collectChunk = readChunk;
+    collectOffset = readOffset;
+
+    while(true)
+    {
+        std::size_t committed = collectChunk->committed.load(std::memory_order_acquire);
+
+        while(collectOffset < committed)
+        {
+            char* record = collectChunk->data + collectOffset;
+            auto header = reinterpret_cast<RecordHeader*>(record);
+
+            pending.push_back(PendingMessage{header->sortKey, record});
+            collectOffset += header->size;
+        }
+
+        Chunk* next = collectChunk->next.load(std::memory_order_acquire);
+        if(!next)
+            break;
+
+        //The last messages in this chunk may have been committed just before the next chunk was linked
+        if(collectOffset < collectChunk->committed.load(std::memory_order_acquire))
+            continue;
+
+        collectChunk = next;
+        collectOffset = 0;
+    }
+}
+
+/** \brief Free the chunks the last collect finished with and move past its messages.
+ */
+void MessageQueue::release()
+{
+    while(readChunk != collectChunk)
+    {
+        Chunk* next = readChunk->next.load(std::memory_order_acquire);
+        delete readChunk;
+        readChunk = next;
+    }
+
+    readOffset = collectOffset;
+}
+
+}//ocs
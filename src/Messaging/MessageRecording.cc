@@ -0,0 +1,319 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/MessageRecording.hpp"
+
+#include <cstring>
+
+namespace ocs
+{
+
+namespace
+{
+
+const char logMagic[4] = {'O', 'C', 'S', 'M'};
+
+}//namespace
+
+const uint32_t MessageRecorder::formatVersion;
+
+MessageRecorder::MessageRecorder() :
+    totalTypesWritten(0),
+    recording(false),
+    totalRecorded(0),
+    stopping(false)
+{
+
+}
+
+MessageRecorder::~MessageRecorder()
+{
+    stop();
+}
+
+/** \brief Create the log file and start the background writer. Anything already in the file is replaced.
+ *
+ * \param path The log file's path.
+ * \return True if the file was opened.
+ */
+bool MessageRecorder::start(const std::string& path)
+{
+    stop();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        std::cerr << "Error: Could not open " << path << " for recording messages\n";
+        return false;
+    }
+
+    for(auto& boundType : boundTypes)
+        boundType.written = false;
+
+    totalTypesWritten = 0;
+    totalRecorded = 0;
+    stopping = false;
+
+    frameBuffer.clear();
+    frameBuffer.writeBytes(logMagic, sizeof(logMagic));
+    frameBuffer.write(formatVersion);
+
+    recording = true;
+    writer = std::thread(&MessageRecorder::writerLoop, this);
+
+    return true;
+}
+
+void MessageRecorder::stop()
+{
+    if(!recording)
+        return;
+
+    //Hand over whatever was recorded in the unfinished frame
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pendingBytes.insert(pendingBytes.end(), frameBuffer.getBuffer().begin(), frameBuffer.getBuffer().end());
+        stopping = true;
+    }
+
+    frameBuffer.clear();
+    pendingCondition.notify_one();
+    writer.join();
+
+    file.close();
+    recording = false;
+}
+
+/** \brief Append a message to the current frame.
+ *
+ * \param msg The message.
+ * \param family The message's family.
+ * \param kind How the message was posted.
+ * \param key The mailbox, coalescing key or topic, depending on the kind.
+ */
+void MessageRecorder::onMessage(const BaseMessage& msg, Family family, PostKind kind, ID key)
+{
+    if(!recording || family >= boundTypes.size() || !boundTypes[family].encode)
+        return;
+
+    BoundType& boundType = boundTypes[family];
+
+    if(!boundType.written)
+    {
+        boundType.index = totalTypesWritten++;
+        boundType.written = true;
+
+        frameBuffer.write(static_cast<uint8_t>(TypeTag));
+        frameBuffer.writeVarint(boundType.index);
+        frameBuffer.writeString(boundType.name);
+    }
+
+    payload.clear();
+    boundType.encode(msg, payload);
+
+    frameBuffer.write(static_cast<uint8_t>(MessageTag));
+    frameBuffer.writeVarint(boundType.index);
+    frameBuffer.write(static_cast<uint8_t>(kind));
+    if(kind != PostKind::Posted)
+        frameBuffer.writeVarint(key);
+    frameBuffer.writeVarint(msg.getSender());
+    frameBuffer.writeVarint(payload.size());
+    frameBuffer.writeBytes(payload.getBuffer().data(), payload.size());
+
+    ++totalRecorded;
+}
+
+void MessageRecorder::onFrameEnd()
+{
+    if(!recording)
+        return;
+
+    frameBuffer.write(static_cast<uint8_t>(FrameTag));
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+
+        if(pendingBytes.empty())
+            pendingBytes.swap(frameBuffer.getBuffer());
+        else
+            pendingBytes.insert(pendingBytes.end(), frameBuffer.getBuffer().begin(), frameBuffer.getBuffer().end());
+    }
+
+    frameBuffer.clear();
+    pendingCondition.notify_one();
+}
+
+//!Runs on the writer thread. Takes whatever bytes are waiting and writes them while the hub keeps recording.
+void MessageRecorder::writerLoop()
+{
+    std::vector<char> bytes;
+
+    while(true)
+    {
+        bool finished = false;
+
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex);
+            pendingCondition.wait(lock, [this]() { return stopping || !pendingBytes.empty(); });
+
+            bytes.swap(pendingBytes);
+            finished = stopping;
+        }
+
+        file.write(bytes.data(), bytes.size());
+        bytes.clear();
+
+        if(finished)
+            break;
+    }
+
+    file.flush();
+}
+
+MessageReplayer::MessageReplayer() :
+    position(0),
+    framesReplayed(0)
+{
+
+}
+
+/** \brief Load a message log into memory.
+ *
+ * \param path The log file's path.
+ * \return True if the file was read and has a valid header.
+ */
+bool MessageReplayer::open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        std::cerr << "Error: Could not open message log " << path << std::endl;
+        return false;
+    }
+
+    log.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    logDecoders.clear();
+    position = 0;
+    framesReplayed = 0;
+
+    BinaryReader in(log);
+    char magic[4];
+    uint32_t version = 0;
+
+    if(!in.readBytes(magic, sizeof(magic)) || std::memcmp(magic, logMagic, sizeof(magic)) != 0 ||
+       !in.read(version) || version != MessageRecorder::formatVersion)
+    {
+        std::cerr << "Error: " << path << " is not a message log\n";
+        log.clear();
+        return false;
+    }
+
+    position = in.getPosition();
+    return true;
+}
+
+/** \brief Post every message recorded in the next frame, in the order they were recorded.
+ *
+ * \param msgHub The hub to post to. Must be called from the hub's thread.
+ * \return True if a frame was replayed.
+ */
+bool MessageReplayer::replayFrame(MessageHub& msgHub)
+{
+    if(isFinished())
+        return false;
+
+    BinaryReader in(log.data() + position, log.size() - position);
+
+    while(in.getRemaining() > 0)
+    {
+        uint8_t tag = 0;
+        in.read(tag);
+
+        if(tag == MessageRecorder::FrameTag)
+            break;
+
+        if(tag == MessageRecorder::TypeTag)
+        {
+            uint64_t index = 0;
+            std::string name;
+            if(!in.readVarint(index) || !in.readString(name))
+                break;
+
+            //Types are numbered in the order they are first written
+            if(index > logDecoders.size())
+            {
+                std::cerr << "Error: Corrupt record in message log\n";
+                position = log.size();
+                return false;
+            }
+
+            if(index == logDecoders.size())
+                logDecoders.resize(index + 1, nullptr);
+
+            auto decoder = decoders.find(name);
+            logDecoders[index] = (decoder != decoders.end()) ? decoder->second : nullptr;
+        }
+        else if(tag == MessageRecorder::MessageTag)
+        {
+            uint64_t index = 0, key = 0, senderID = 0, size = 0;
+            uint8_t kind = 0;
+
+            if(!in.readVarint(index) || !in.read(kind))
+                break;
+            if(static_cast<PostKind>(kind) != PostKind::Posted && !in.readVarint(key))
+                break;
+            if(!in.readVarint(senderID) || !in.readVarint(size))
+                break;
+
+            if(size <= in.getRemaining() && index < logDecoders.size() && logDecoders[index])
+            {
+                BinaryReader msgIn(in.getCurrent(), size);
+                sender.setID(senderID);
+                logDecoders[index](msgHub, sender, msgIn, static_cast<PostKind>(kind), key);
+            }
+
+            //Fails the reader if the message runs past the end of the log
+            if(!in.skip(size))
+                break;
+        }
+        else
+        {
+            std::cerr << "Error: Corrupt record in message log\n";
+            position = log.size();
+            return false;
+        }
+    }
+
+    if(!in.isGood())
+    {
+        std::cerr << "Error: Message log ended in the middle of a record\n";
+        position = log.size();
+        return false;
+    }
+
+    position += in.getPosition();
+    ++framesReplayed;
+
+    return true;
+}
+
+}//ocs
@@ -0,0 +1,355 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/MessageStatistics.hpp"
+
+#include <algorithm>
+
+namespace ocs
+{
+
+namespace
+{
+
+//!The counters each thread last read with, so the lookup usually skips the lock.
+struct CachedCounters
+{
+    uint64_t instanceID;
+    void* counters;
+};
+
+thread_local CachedCounters cachedCounters = {0, nullptr};
+
+void writeJsonString(std::ostream& out, const std::string& text)
+{
+    out << '"';
+
+    for(char c : text)
+    {
+        if(c == '"' || c == '\\')
+            out << '\\' << c;
+        else if(static_cast<unsigned char>(c) < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+
+    out << '"';
+}
+
+}//namespace
+
+const std::size_t LatencyHistogram::totalBuckets;
+
+std::atomic<uint64_t> MessageStatistics::instanceCounter(1);
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for(std::size_t i = 0; i < totalBuckets; ++i)
+        buckets[i] += other.buckets[i];
+
+    totalSamples += other.totalSamples;
+    totalNanoseconds += other.totalNanoseconds;
+    maxNanoseconds = std::max(maxNanoseconds, other.maxNanoseconds);
+}
+
+void LatencyHistogram::clear()
+{
+    std::fill(buckets, buckets + totalBuckets, 0);
+    totalSamples = 0;
+    totalNanoseconds = 0;
+    maxNanoseconds = 0;
+}
+
+/** \brief Find the bucket that contains a percentile and return its upper limit, or the largest sample if that is lower.
+ *
+ * \param fraction The fraction of samples, from 0 to 1.
+ * \return The duration in nanoseconds, or 0 if there are no samples.
+ */
+uint64_t LatencyHistogram::getPercentile(double fraction) const
+{
+    if(totalSamples == 0)
+        return 0;
+
+    uint64_t target = static_cast<uint64_t>(fraction * totalSamples + 0.5);
+    target = std::max<uint64_t>(1, std::min(target, totalSamples));
+
+    uint64_t counted = 0;
+    for(std::size_t i = 0; i < totalBuckets; ++i)
+    {
+        counted += buckets[i];
+        if(counted >= target)
+            return std::min(getBucketLimit(i), maxNanoseconds);
+    }
+
+    return maxNanoseconds;
+}
+
+uint64_t LatencyHistogram::getBucketLimit(std::size_t index)
+{
+    if(index == 0)
+        return 0;
+
+    return (index >= totalBuckets - 1) ? UINT64_MAX : (uint64_t(1) << index) - 1;
+}
+
+/** \brief Create empty statistics.
+ *
+ * \param _sampleInterval Measure read latency on every this many reads of each thread. 1 measures every read.
+ */
+MessageStatistics::MessageStatistics(unsigned int _sampleInterval) :
+    framesRecorded(0),
+    sampleInterval(std::max(1u, _sampleInterval)),
+    instanceID(instanceCounter++)
+{
+
+}
+
+MessageStatistics::ThreadCounters& MessageStatistics::getThreadCounters()
+{
+    if(cachedCounters.instanceID == instanceID)
+        return *static_cast<ThreadCounters*>(cachedCounters.counters);
+
+    std::lock_guard<std::mutex> lock(countersMutex);
+
+    auto threadID = std::this_thread::get_id();
+    auto found = std::find_if(threadCounters.begin(), threadCounters.end(),
+                              [threadID](const std::unique_ptr<ThreadCounters>& counters) { return counters->thread == threadID; });
+
+    if(found == threadCounters.end())
+    {
+        threadCounters.emplace_back(new ThreadCounters());
+        threadCounters.back()->thread = threadID;
+        threadCounters.back()->readsUntilSample = 1;
+        found = threadCounters.end() - 1;
+    }
+
+    cachedCounters.instanceID = instanceID;
+    cachedCounters.counters = found->get();
+
+    return **found;
+}
+
+/** \brief Count messages that were read. Empty reads are not counted.
+ *
+ * \param family The messages' family.
+ * \param first The first message read.
+ * \param count The number of messages read.
+ */
+void MessageStatistics::recordRead(Family family, const BaseMessage* first, std::size_t count)
+{
+    if(count == 0)
+        return;
+
+    ThreadCounters& counters = getThreadCounters();
+
+    if(family >= counters.reads.size())
+    {
+        counters.reads.resize(family + 1, 0);
+        counters.latency.resize(family + 1);
+    }
+
+    counters.reads[family] += count;
+
+    if(--counters.readsUntilSample == 0)
+    {
+        counters.readsUntilSample = sampleInterval;
+
+        uint64_t now = BaseMessage::getMonotonicTime();
+        uint64_t created = first->getMetadata().timeNanoseconds;
+
+        auto& histogram = counters.latency[family];
+        if(histogram.getTotalSamples() == 0)
+            counters.sampledFamilies.push_back(family);
+
+        histogram.record(now > created ? now - created : 0);
+    }
+}
+
+void MessageStatistics::recordSlotSize(Family family, std::size_t size)
+{
+    if(family >= families.size())
+        families.resize(family + 1);
+
+    families[family].peakSlotSize = std::max(families[family].peakSlotSize, size);
+}
+
+void MessageStatistics::addAllocatedBytes(Family family, std::size_t bytes)
+{
+    if(family >= families.size())
+        families.resize(family + 1);
+
+    families[family].allocatedBytes += bytes;
+}
+
+void MessageStatistics::clearAllocatedBytes()
+{
+    for(auto& family : families)
+        family.allocatedBytes = 0;
+}
+
+void MessageStatistics::endFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(countersMutex);
+
+        for(auto& counters : threadCounters)
+        {
+            if(counters->reads.size() > families.size())
+                families.resize(counters->reads.size());
+
+            for(std::size_t f = 0; f < counters->reads.size(); ++f)
+            {
+                families[f].frameReads += counters->reads[f];
+                counters->reads[f] = 0;
+            }
+
+            for(auto family : counters->sampledFamilies)
+            {
+                families[family].latency.merge(counters->latency[family]);
+                counters->latency[family].clear();
+            }
+
+            counters->sampledFamilies.clear();
+        }
+    }
+
+    for(auto& family : families)
+    {
+        family.lastFramePosts = family.framePosts;
+        family.lastFrameReads = family.frameReads;
+        family.totalPosts += family.framePosts;
+        family.totalReads += family.frameReads;
+        family.peakPostsPerFrame = std::max(family.peakPostsPerFrame, family.framePosts);
+        family.peakReadsPerFrame = std::max(family.peakReadsPerFrame, family.frameReads);
+        family.framePosts = 0;
+        family.frameReads = 0;
+    }
+
+    ++framesRecorded;
+}
+
+void MessageStatistics::setName(Family family, const std::string& name)
+{
+    if(family >= families.size())
+        families.resize(family + 1);
+
+    families[family].name = name;
+}
+
+const MessageFamilyStatistics* MessageStatistics::getFamily(Family family) const
+{
+    return (family < families.size()) ? &families[family] : nullptr;
+}
+
+/** \brief Write the statistics of every family that has had traffic. Per frame averages cover the frames
+ *         that have ended. Latencies are in nanoseconds, and only buckets with samples are listed, as
+ *         [upper limit, count] pairs.
+ *
+ * \param out The stream to write to.
+ */
+void MessageStatistics::writeJson(std::ostream& out) const
+{
+    double frames = static_cast<double>(std::max<uint64_t>(1, framesRecorded));
+
+    out << "{\n  \"frames\": " << framesRecorded << ",\n  \"sampleInterval\": " << sampleInterval << ",\n  \"families\": [";
+
+    bool firstFamily = true;
+
+    for(std::size_t f = 0; f < families.size(); ++f)
+    {
+        const auto& family = families[f];
+
+        if(family.totalPosts == 0 && family.totalReads == 0 && family.framePosts == 0 && family.allocatedBytes == 0)
+            continue;
+
+        out << (firstFamily ? "\n" : ",\n") << "    {\"family\": " << f << ", \"name\": ";
+        writeJsonString(out, family.name);
+        firstFamily = false;
+
+        out << ", \"totalPosts\": " << family.totalPosts
+            << ", \"postsPerFrame\": " << family.totalPosts / frames
+            << ", \"lastFramePosts\": " << family.lastFramePosts
+            << ", \"peakPostsPerFrame\": " << family.peakPostsPerFrame
+            << ", \"totalReads\": " << family.totalReads
+            << ", \"readsPerFrame\": " << family.totalReads / frames
+            << ", \"lastFrameReads\": " << family.lastFrameReads
+            << ", \"peakReadsPerFrame\": " << family.peakReadsPerFrame
+            << ", \"peakSlotSize\": " << family.peakSlotSize
+            << ", \"allocatedBytes\": " << family.allocatedBytes;
+
+        const auto& latency = family.latency;
+
+        out << ",\n     \"latency\": {\"samples\": " << latency.getTotalSamples()
+            << ", \"mean\": " << latency.getMean()
+            << ", \"p50\": " << latency.getPercentile(0.5)
+            << ", \"p90\": " << latency.getPercentile(0.9)
+            << ", \"p99\": " << latency.getPercentile(0.99)
+            << ", \"max\": " << latency.getMax()
+            << ", \"buckets\": [";
+
+        bool firstBucket = true;
+        for(std::size_t i = 0; i < LatencyHistogram::totalBuckets; ++i)
+        {
+            if(latency.getBucket(i) == 0)
+                continue;
+
+            out << (firstBucket ? "" : ", ") << "[" << LatencyHistogram::getBucketLimit(i) << ", " << latency.getBucket(i) << "]";
+            firstBucket = false;
+        }
+
+        out << "]}}";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+void MessageStatistics::reset()
+{
+    std::lock_guard<std::mutex> lock(countersMutex);
+
+    for(auto& family : families)
+    {
+        std::string name = std::move(family.name);
+        family = MessageFamilyStatistics();
+        family.name = std::move(name);
+    }
+
+    for(auto& counters : threadCounters)
+    {
+        std::fill(counters->reads.begin(), counters->reads.end(), 0);
+
+        for(auto family : counters->sampledFamilies)
+            counters->latency[family].clear();
+
+        counters->sampledFamilies.clear();
+    }
+
+    framesRecorded = 0;
+}
+
+}//ocs
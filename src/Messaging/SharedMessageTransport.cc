@@ -0,0 +1,399 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/SharedMessageTransport.hpp"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ocs
+{
+
+namespace
+{
+
+const char ringMagic[4] = {'O', 'C', 'S', 'R'};
+const uint32_t ringVersion = 1;
+
+//!Written instead of a payload size when the rest of the ring is padding and the next record starts at the beginning.
+const uint32_t wrapMarker = 0xFFFFFFFF;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared message rings need lock free 64 bit atomics");
+
+uint64_t getRecordSize(std::size_t payloadSize)
+{
+    return (sizeof(SharedRecordHeader) + payloadSize + 7) & ~uint64_t(7);
+}
+
+/** \brief Map a named shared memory object.
+ *
+ * \param name The object's name, which should start with '/'.
+ * \param size The size to create the object with, or set to the existing object's size when opening.
+ * \param create True to replace any existing object with a new one.
+ * \return The mapped memory, or nullptr if it could not be mapped.
+ */
+void* mapSharedMemory(const std::string& name, std::size_t& size, bool create)
+{
+#ifndef _WIN32
+    if(create)
+        shm_unlink(name.c_str());
+
+    int fd = create ? shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) : shm_open(name.c_str(), O_RDWR, 0);
+    if(fd < 0)
+        return nullptr;
+
+    struct stat info;
+    bool sized = create ? (ftruncate(fd, size) == 0) : (fstat(fd, &info) == 0);
+    if(sized && !create)
+        size = info.st_size;
+
+    void* memory = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+
+    if(memory == MAP_FAILED)
+    {
+        if(create)
+            shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    return memory;
+#else
+    (void)name; (void)size; (void)create;
+    return nullptr;
+#endif
+}
+
+void unmapSharedMemory(void* memory, std::size_t size)
+{
+#ifndef _WIN32
+    munmap(memory, size);
+#else
+    (void)memory; (void)size;
+#endif
+}
+
+void removeSharedMemory(const std::string& name)
+{
+#ifndef _WIN32
+    shm_unlink(name.c_str());
+#else
+    (void)name;
+#endif
+}
+
+}//namespace
+
+/** \brief Hash a message name with 64 bit FNV-1a.
+ *
+ * \param name The name a message type was bound under.
+ * \return The name's hash.
+ */
+uint64_t hashMessageName(const std::string& name)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(unsigned char c : name)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+SharedMessageWriter::SharedMessageWriter() :
+    mappedSize(0),
+    ring(nullptr),
+    data(nullptr),
+    mask(0),
+    writeIndex(0),
+    cachedReadIndex(0),
+    totalSent(0)
+{
+
+}
+
+SharedMessageWriter::~SharedMessageWriter()
+{
+    close();
+}
+
+/** \brief Create a shared memory object holding an empty ring. An existing object with the same name is replaced.
+ *
+ * \param _name The shared memory object's name, e.g. "/game-events".
+ * \param capacity The number of bytes in the ring. Each message takes 32 bytes plus its payload.
+ * \return True if the ring was created.
+ */
+bool SharedMessageWriter::create(const std::string& _name, std::size_t capacity)
+{
+    close();
+
+    uint64_t ringCapacity = 64;
+    while(ringCapacity < capacity)
+        ringCapacity <<= 1;
+
+    mappedSize = sizeof(SharedRingHeader) + ringCapacity;
+
+    void* memory = mapSharedMemory(_name, mappedSize, true);
+    if(!memory)
+    {
+        std::cerr << "Error: Could not create shared memory " << _name << " for messages\n";
+        return false;
+    }
+
+    name = _name;
+    ring = static_cast<SharedRingHeader*>(memory);
+    data = static_cast<char*>(memory) + sizeof(SharedRingHeader);
+    mask = ringCapacity - 1;
+    writeIndex = 0;
+    cachedReadIndex = 0;
+    totalSent = 0;
+
+    ring->version = ringVersion;
+    ring->capacity = ringCapacity;
+    ring->writeIndex.store(0, std::memory_order_relaxed);
+    ring->droppedMessages.store(0, std::memory_order_relaxed);
+    ring->readIndex.store(0, std::memory_order_relaxed);
+
+    //Readers check the magic first, so write it last
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(ring->magic, ringMagic, sizeof(ringMagic));
+
+    return true;
+}
+
+void SharedMessageWriter::close()
+{
+    if(!ring)
+        return;
+
+    unmapSharedMemory(ring, mappedSize);
+    removeSharedMemory(name);
+
+    ring = nullptr;
+    data = nullptr;
+}
+
+uint64_t SharedMessageWriter::getDroppedMessages() const
+{
+    return ring ? ring->droppedMessages.load(std::memory_order_relaxed) : 0;
+}
+
+/** \brief Copy a message into the ring and publish it to the reader.
+ *
+ * \param msg The message.
+ * \param family The message's family.
+ * \param kind How the message was posted.
+ * \param key The mailbox, coalescing key or topic, depending on the kind.
+ */
+void SharedMessageWriter::onMessage(const BaseMessage& msg, Family family, PostKind kind, ID key)
+{
+    if(!ring || family >= boundTypes.size() || !boundTypes[family].encode)
+        return;
+
+    payload.clear();
+    boundTypes[family].encode(msg, payload);
+
+    uint64_t capacity = mask + 1;
+    uint64_t recordSize = getRecordSize(payload.size());
+    uint64_t offset = writeIndex & mask;
+    uint64_t toEnd = capacity - offset;
+
+    //A record never wraps, so skip to the start of the ring if it does not fit before the end
+    uint64_t padding = (toEnd < recordSize) ? toEnd : 0;
+
+    if(writeIndex + padding + recordSize - cachedReadIndex > capacity)
+    {
+        cachedReadIndex = ring->readIndex.load(std::memory_order_acquire);
+
+        if(writeIndex + padding + recordSize - cachedReadIndex > capacity)
+        {
+            ring->droppedMessages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if(padding > 0)
+    {
+        std::memcpy(data + offset, &wrapMarker, sizeof(wrapMarker));
+        writeIndex += padding;
+        offset = 0;
+    }
+
+    SharedRecordHeader header;
+    header.payloadSize = payload.size();
+    header.kind = kind;
+    header.typeHash = boundTypes[family].typeHash;
+    header.sender = msg.getSender();
+    header.key = key;
+
+    std::memcpy(data + offset, &header, sizeof(header));
+    std::memcpy(data + offset + sizeof(header), payload.getBuffer().data(), payload.size());
+
+    writeIndex += recordSize;
+    ring->writeIndex.store(writeIndex, std::memory_order_release);
+
+    ++totalSent;
+}
+
+SharedMessageReader::SharedMessageReader() :
+    mappedSize(0),
+    ring(nullptr),
+    data(nullptr),
+    mask(0),
+    readIndex(0),
+    cachedWriteIndex(0)
+{
+
+}
+
+SharedMessageReader::~SharedMessageReader()
+{
+    close();
+}
+
+/** \brief Map a ring created by a SharedMessageWriter. Reading starts at the oldest message still in the ring.
+ *
+ * \param name The shared memory object's name.
+ * \return True if the ring was mapped.
+ */
+bool SharedMessageReader::open(const std::string& name)
+{
+    close();
+
+    void* memory = mapSharedMemory(name, mappedSize, false);
+    if(!memory)
+    {
+        std::cerr << "Error: Could not open shared memory " << name << " for messages\n";
+        return false;
+    }
+
+    ring = static_cast<SharedRingHeader*>(memory);
+
+    bool valid = mappedSize >= sizeof(SharedRingHeader) && std::memcmp(ring->magic, ringMagic, sizeof(ringMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    uint64_t capacity = valid ? ring->capacity : 0;
+
+    if(!valid || ring->version != ringVersion || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+       sizeof(SharedRingHeader) + capacity > mappedSize)
+    {
+        std::cerr << "Error: " << name << " is not a message ring\n";
+        close();
+        return false;
+    }
+
+    data = static_cast<const char*>(memory) + sizeof(SharedRingHeader);
+    mask = capacity - 1;
+    readIndex = ring->readIndex.load(std::memory_order_acquire);
+    cachedWriteIndex = readIndex;
+
+    return true;
+}
+
+void SharedMessageReader::close()
+{
+    if(!ring)
+        return;
+
+    unmapSharedMemory(ring, mappedSize);
+
+    ring = nullptr;
+    data = nullptr;
+}
+
+uint64_t SharedMessageReader::getDroppedMessages() const
+{
+    return ring ? ring->droppedMessages.load(std::memory_order_relaxed) : 0;
+}
+
+/** \brief Post the messages waiting in the ring, in the order they were sent. The space they used is handed
+ *         back to the writer when polling finishes.
+ *
+ * \param msgHub The hub to post to. Must be called from the hub's thread.
+ * \param maxMessages The most messages to read, or 0 to read everything waiting.
+ * \return The number of messages read, including ones of unbound types.
+ */
+std::size_t SharedMessageReader::poll(MessageHub& msgHub, std::size_t maxMessages)
+{
+    if(!ring)
+        return 0;
+
+    uint64_t capacity = mask + 1;
+    std::size_t totalRead = 0;
+
+    while(maxMessages == 0 || totalRead < maxMessages)
+    {
+        if(readIndex == cachedWriteIndex)
+        {
+            cachedWriteIndex = ring->writeIndex.load(std::memory_order_acquire);
+            if(readIndex == cachedWriteIndex)
+                break;
+        }
+
+        uint64_t offset = readIndex & mask;
+
+        uint32_t payloadSize = 0;
+        std::memcpy(&payloadSize, data + offset, sizeof(payloadSize));
+
+        if(payloadSize == wrapMarker)
+        {
+            readIndex += capacity - offset;
+            continue;
+        }
+
+        SharedRecordHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+
+        uint64_t recordSize = getRecordSize(header.payloadSize);
+        if(recordSize > capacity - offset)
+        {
+            std::cerr << "Error: Corrupt record in shared message ring\n";
+            readIndex = cachedWriteIndex;
+            break;
+        }
+
+        auto decoder = decoders.find(header.typeHash);
+        if(decoder != decoders.end())
+        {
+            BinaryReader in(data + offset + sizeof(header), header.payloadSize);
+            sender.setID(header.sender);
+            decoder->second(msgHub, sender, in, header.kind, header.key);
+        }
+
+        readIndex += recordSize;
+        ++totalRead;
+    }
+
+    ring->readIndex.store(readIndex, std::memory_order_release);
+
+    return totalRead;
+}
+
+}//ocs
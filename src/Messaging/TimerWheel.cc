@@ -0,0 +1,243 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Messaging/TimerWheel.hpp"
+
+#include <algorithm>
+
+namespace ocs
+{
+
+const unsigned int TimerWheel::levels;
+const unsigned int TimerWheel::levelBits;
+const uint32_t TimerWheel::levelSize;
+const uint32_t TimerWheel::nullNode;
+
+TimerWheel::TimerWheel() :
+    freeNodes(nullNode),
+    buckets(levels * levelSize, Bucket{nullNode, nullNode, 0}),
+    nextTick(0),
+    pending(0),
+    earliestDue(static_cast<uint64_t>(-1)),
+    earliestKnown(true)
+{
+    for(auto& count : levelCounts)
+        count = 0;
+}
+
+/** \brief Schedule a timer.
+ *
+ * \param dueTick The tick to fire on.
+ * \param family The first number carried by the timer.
+ * \param index The second number carried by the timer.
+ */
+void TimerWheel::schedule(uint64_t dueTick, uint32_t family, uint32_t index)
+{
+    uint32_t node = freeNodes;
+
+    if(node != nullNode)
+        freeNodes = nodes[node].next;
+    else
+    {
+        node = nodes.size();
+        nodes.push_back(Node());
+    }
+
+    nodes[node].dueTick = (dueTick < nextTick) ? nextTick : dueTick;
+    nodes[node].timer = Timer{family, index};
+
+    if(earliestKnown)
+        earliestDue = std::min(earliestDue, nodes[node].dueTick);
+
+    place(node);
+    ++pending;
+}
+
+void TimerWheel::place(uint32_t node)
+{
+    uint64_t dueTick = nodes[node].dueTick;
+    uint64_t delta = dueTick - nextTick;
+
+    //Timers further out than the wheel covers wait in the top level and are placed again when it cascades
+    const uint64_t maxDelta = (uint64_t(1) << (levels * levelBits)) - 1;
+    if(delta > maxDelta)
+        dueTick = nextTick + maxDelta;
+
+    unsigned int level = 0;
+    while(level < levels - 1 && delta >= (uint64_t(1) << ((level + 1) * levelBits)))
+        ++level;
+
+    Bucket& bucket = buckets[level * levelSize + ((dueTick >> (level * levelBits)) & (levelSize - 1))];
+
+    nodes[node].next = nullNode;
+    if(bucket.tail == nullNode)
+        bucket.head = node;
+    else
+        nodes[bucket.tail].next = node;
+    bucket.tail = node;
+
+    ++bucket.size;
+    ++levelCounts[level];
+}
+
+uint32_t TimerWheel::takeBucket(unsigned int level, uint32_t slot)
+{
+    Bucket& bucket = buckets[level * levelSize + slot];
+    uint32_t head = bucket.head;
+
+    levelCounts[level] -= bucket.size;
+    bucket.head = nullNode;
+    bucket.tail = nullNode;
+    bucket.size = 0;
+
+    return head;
+}
+
+void TimerWheel::cascade(unsigned int level, uint32_t slot)
+{
+    for(uint32_t node = takeBucket(level, slot); node != nullNode;)
+    {
+        uint32_t next = nodes[node].next;
+        place(node);
+        node = next;
+    }
+}
+
+/** \brief Process ticks until the wheel has caught up with the given tick.
+ *
+ * \param toTick The last tick to process.
+ * \param expired Where to append the timers that fire.
+ */
+void TimerWheel::advance(uint64_t toTick, std::vector<Timer>& expired)
+{
+    while(nextTick <= toTick)
+    {
+        //Nothing can fire, so skip straight to the end
+        if(pending == 0)
+        {
+            nextTick = toTick + 1;
+            return;
+        }
+
+        uint32_t slot = nextTick & (levelSize - 1);
+
+        //If the lowest levels are empty, nothing happens until the next time the first non-empty one cascades
+        if(levelCounts[0] == 0 && slot != 0)
+        {
+            unsigned int level = 1;
+            while(level < levels - 1 && levelCounts[level] == 0)
+                ++level;
+
+            uint64_t boundary = ((nextTick >> (level * levelBits)) + 1) << (level * levelBits);
+            nextTick = (boundary <= toTick) ? boundary : toTick + 1;
+            continue;
+        }
+
+        //When a level wraps around, bring down the timers for the next stretch of the level above
+        for(unsigned int level = 1; slot == 0 && level < levels; ++level)
+        {
+            slot = (nextTick >> (level * levelBits)) & (levelSize - 1);
+            cascade(level, slot);
+        }
+
+        for(uint32_t node = takeBucket(0, nextTick & (levelSize - 1)); node != nullNode;)
+        {
+            uint32_t next = nodes[node].next;
+
+            //Only timers beyond the wheel's range can show up here early
+            if(nodes[node].dueTick > nextTick)
+                place(node);
+            else
+            {
+                expired.push_back(nodes[node].timer);
+
+                nodes[node].next = freeNodes;
+                freeNodes = node;
+                --pending;
+
+                //The earliest timer just fired, so the next one is found when it is asked for
+                earliestKnown = false;
+            }
+
+            node = next;
+        }
+
+        ++nextTick;
+    }
+}
+
+/** \brief Find the earliest timer. The answer is kept up to date as timers are scheduled, and only
+ *         searched for again after a timer fires. The search stops at the first occupied bucket left in the
+ *         lowest level's current turn. Otherwise every occupied bucket is checked, since a timer scheduled long
+ *         ago can sit in a higher level than one scheduled recently for a later tick.
+ *
+ * \param dueTick Receives the earliest due tick.
+ * \return False if no timers are pending.
+ */
+bool TimerWheel::getEarliestDueTick(uint64_t& dueTick) const
+{
+    if(pending == 0)
+        return false;
+
+    if(!earliestKnown)
+    {
+        earliestDue = static_cast<uint64_t>(-1);
+
+        //Timers in the rest of the lowest level's current turn are due before anything in the other buckets
+        uint32_t currentSlot = nextTick & (levelSize - 1);
+        for(uint32_t slot = currentSlot; slot < levelSize && levelCounts[0] > 0; ++slot)
+        {
+            uint32_t head = buckets[slot].head;
+            if(head == nullNode)
+                continue;
+
+            for(uint32_t node = head; node != nullNode; node = nodes[node].next)
+                earliestDue = std::min(earliestDue, nodes[node].dueTick);
+
+            //A timer beyond the wheel's range can be waiting in the bucket with a later tick than its slot's
+            earliestKnown = (earliestDue == nextTick + (slot - currentSlot));
+            break;
+        }
+    }
+
+    if(!earliestKnown)
+    {
+        earliestDue = static_cast<uint64_t>(-1);
+
+        for(unsigned int level = 0; level < levels; ++level)
+        {
+            if(levelCounts[level] == 0)
+                continue;
+
+            for(uint32_t slot = 0; slot < levelSize; ++slot)
+                for(uint32_t node = buckets[level * levelSize + slot].head; node != nullNode; node = nodes[node].next)
+                    earliestDue = std::min(earliestDue, nodes[node].dueTick);
+        }
+
+        earliestKnown = true;
+    }
+
+    dueTick = earliestDue;
+    return true;
+}
+
+}//ocs
@@ -21,6 +21,9 @@ freely, subject to the following restrictions:
 */
 
 #include "OCS/Objects/ObjectManager.hpp"
+#include "OCS/Commands/CommandBuffer.hpp"
+#include <algorithm>
+#include <cctype>
 #include <set>
 
 namespace ocs
@@ -30,7 +33,8 @@ ID ObjectManager::prototypeIDCounter = 0;
 ID ObjectManager::versionCounter = 0;
 std::queue<ID> ObjectManager::availableVersions;
 
-ObjectManager::ObjectManager()
+ObjectManager::ObjectManager() :
+    deferredCommands(new DeferredCommands())
 {
     if(availableVersions.empty())
     {
@@ -49,6 +53,23 @@ ObjectManager::~ObjectManager()
     availableVersions.push(version);
 }
 
+/** \brief Get the calling thread's command buffer. Systems running on worker threads record
+ *         object and component changes here instead of making them directly.
+ *
+ * \return The calling thread's command buffer.
+ */
+CommandBuffer& ObjectManager::getCommandBuffer()
+{
+    return deferredCommands->getBuffer();
+}
+
+/** \brief Apply every command recorded with getCommandBuffer. Must only be called while no other thread is recording.
+ */
+void ObjectManager::applyDeferredCommands()
+{
+    deferredCommands->apply(*this);
+}
+
 /** \brief Create an object modeled after an existing object
  *         
  *
@@ -90,8 +111,11 @@ void ObjectManager::copyObject(ID destinationId, const Object& source)
 
             //Store the component's index in the map under the newly created object's ID
             componentIndices[compFamily] = newComponentIndex;
+            objects[destinationId].setMaskBit(compFamily, true);
 
         }
+
+        updateTrackedQueries(destinationId);
     }
    
 }
@@ -106,6 +130,9 @@ ID ObjectManager::createObject()
     ID indx = objects.emplace_item();
     objects[indx].objectID = indx;
 
+    //A blank object matches queries that only exclude components
+    updateTrackedQueries(indx);
+
     return indx;
 }
 
@@ -146,6 +173,10 @@ void ObjectManager::destroyObject(ID objectID)
     if(objects.isValid(objectID))
     {
         removeAllComponents(objectID);
+
+        for(auto& trackedQuery : trackedQueries)
+            trackedQuery->remove(objectID);
+
         //Remove the object from the object array
         objects.remove(objectID);
     }else
@@ -160,11 +191,170 @@ void ObjectManager::destroyObject(ID objectID)
 void ObjectManager::destroyAllObjects()
 {
     while (objects.size() > 0)
-        destroyObject(objects[0].objectID);
+        destroyObject(objects.begin()->objectID);
 
     objects.clear();
 }
 
+/** \brief Compile a query string into component masks. The string is a list of component names
+ *         joined by '&'. A name preceded by '!' excludes objects that have that component.
+ *         e.g. "Position & Motion & !Dead"
+ *
+ * \param queryStr The query to compile.
+ * \param query Receives the compiled query.
+ * \return True if the query was compiled. False if it is malformed or names an unbound component.
+ */
+bool ObjectManager::compileQuery(const std::string& queryStr, ObjectQuery& query) const
+{
+    query = ObjectQuery();
+
+    std::size_t pos = 0;
+    bool expectName = true;
+
+    while(true)
+    {
+        //Skip whitespace
+        while(pos < queryStr.size() && isspace(queryStr[pos]))
+            ++pos;
+
+        if(pos == queryStr.size())
+            break;
+
+        if(!expectName)
+        {
+            if(queryStr[pos] != '&')
+            {
+                std::cerr << "Error: Expected '&' at position " << pos << " of query '" << queryStr << "'\n";
+                return false;
+            }
+            ++pos;
+            expectName = true;
+            continue;
+        }
+
+        bool exclude = queryStr[pos] == '!';
+        if(exclude)
+            ++pos;
+
+        while(pos < queryStr.size() && isspace(queryStr[pos]))
+            ++pos;
+
+        std::size_t nameStart = pos;
+        while(pos < queryStr.size() && !isspace(queryStr[pos]) && queryStr[pos] != '&' && queryStr[pos] != '!')
+            ++pos;
+
+        std::string compName = queryStr.substr(nameStart, pos - nameStart);
+        auto found = stringToCompFamily.find(compName);
+
+        if(found == stringToCompFamily.end())
+        {
+            std::cerr << "Error: '" << compName << "' in query '" << queryStr << "' is not bound to a component\n";
+            return false;
+        }
+
+        if(!(exclude ? query.forbid({found->second}) : query.require({found->second})))
+        {
+            std::cerr << "Error: Component '" << compName << "' can not be used in queries. Its family is not below " << maxComponentFamilies << "\n";
+            return false;
+        }
+
+        expectName = false;
+    }
+
+    if(expectName)
+    {
+        std::cerr << "Error: Query '" << queryStr << "' is missing a component name\n";
+        return false;
+    }
+
+    return true;
+}
+
+/** \brief Get the objects that match a query string. The query is compiled the first time it is used.
+ *         The cache is locked, so systems running in parallel may call this.
+ *
+ * \param queryStr The query, e.g. "Position & Motion & !Dead".
+ * \return A vector of object ids that match. Empty if the query could not be compiled.
+ */
+std::vector<ID> ObjectManager::getObjects(const std::string& queryStr)
+{
+    ObjectQuery query;
+
+    {
+        std::lock_guard<std::mutex> lock(compiledQueriesMutex);
+        auto found = compiledQueries.find(queryStr);
+
+        if(found == compiledQueries.end())
+        {
+            if(!compileQuery(queryStr, query))
+                return std::vector<ID>();
+
+            compiledQueries.emplace(queryStr, query);
+        }
+        else
+            query = found->second;
+    }
+
+    return getObjects(query);
+}
+
+/** \brief Get the objects that match a compiled query.
+ *
+ * \return A vector of object ids that match.
+ */
+std::vector<ID> ObjectManager::getObjects(const ObjectQuery& query) const
+{
+    std::vector<ID> ids;
+    for(const auto& obj : objects)
+    {
+        if(query.matches(obj.componentMask))
+            ids.push_back(obj.objectID);
+    }
+    return ids;
+}
+
+/** \brief Start keeping the objects that match a query up to date. The current objects are scanned once, and
+ *         after that objects are added and removed as their components change. Each call must be paired with
+ *         a call to releaseQuery.
+ *
+ * \param query The query to track.
+ * \return The query's set, shared with anyone else tracking the same query.
+ */
+TrackedQuery& ObjectManager::trackQuery(const ObjectQuery& query)
+{
+    for(auto& trackedQuery : trackedQueries)
+    {
+        if(trackedQuery->query.include == query.include && trackedQuery->query.exclude == query.exclude)
+        {
+            ++trackedQuery->users;
+            return *trackedQuery;
+        }
+    }
+
+    trackedQueries.emplace_back(new TrackedQuery(query));
+    auto& trackedQuery = *trackedQueries.back();
+
+    for(const auto& obj : objects)
+        trackedQuery.update(obj.objectID, obj.componentMask);
+
+    return trackedQuery;
+}
+
+/** \brief Release a query returned by trackQuery. The set is destroyed once it has been released as many times
+ *         as it was tracked.
+ *
+ * \param trackedQuery The query to release.
+ */
+void ObjectManager::releaseQuery(TrackedQuery& trackedQuery)
+{
+    if(--trackedQuery.users > 0)
+        return;
+
+    trackedQueries.erase(std::remove_if(trackedQueries.begin(), trackedQueries.end(),
+                                        [&trackedQuery](const std::unique_ptr<TrackedQuery>& tracked) { return tracked.get() == &trackedQuery; }),
+                         trackedQueries.end());
+}
+
 /** \brief Gets the total number of existing objects.
  *
  *  \return The size of the array containing all objects.
@@ -218,11 +408,68 @@ ID ObjectManager::removeAllComponents(ID objectID)
             componentArray->remove(compIndex);
             ++componentsRemoved;
         }
+
+        componentArrays.clear();
+        objects[objectID].componentIndices.clear();
+        objects[objectID].componentMask.reset();
+        updateTrackedQueries(objectID);
     }
 
     return componentsRemoved;
 }
 
+/** \brief Make a component that is already stored in its array belong to an object.
+ *         If the object already has a component of the same family, the given component is removed instead.
+ *
+ *  \param objectID The id of the object that receives the component
+ *  \param compFamily The component's family
+ *  \param componentArray The array that stores the component
+ *  \param compIndex The component's index in the array
+ */
+void ObjectManager::attachComponent(ID objectID, Family compFamily, BaseComponentArray* componentArray, Index compIndex)
+{
+    auto& object = objects[objectID];
+
+    if(object.componentIndices.find(compFamily) != object.componentIndices.end())
+    {
+        componentArray->remove(compIndex);
+        return;
+    }
+
+    componentArray->getBaseComponent(compIndex).ownerID = objectID;
+    object.componentArrays[compFamily] = componentArray;
+    object.componentIndices[compFamily] = compIndex;
+    object.setMaskBit(compFamily, true);
+    updateTrackedQueries(objectID);
+}
+
+/** \brief Remove an object's component without knowing the component's type.
+ *
+ *  \param objectID The id of the object to remove the component from
+ *  \param compFamily The family of the component to remove
+ *  \return True if the object had the component. False if not.
+ */
+bool ObjectManager::detachComponent(ID objectID, Family compFamily)
+{
+    if(!objects.isValid(objectID))
+        return false;
+
+    auto& object = objects[objectID];
+    auto found = object.componentIndices.find(compFamily);
+
+    if(found == object.componentIndices.end())
+        return false;
+
+    object.componentArrays[compFamily]->remove(found->second);
+
+    object.componentArrays.erase(compFamily);
+    object.componentIndices.erase(found);
+    object.setMaskBit(compFamily, false);
+    updateTrackedQueries(objectID);
+
+    return true;
+}
+
 /** \brief Searches the prototype map for the given prototype name to see if the prototype exists.
  *
  * \param prototypeName The name of the prototype to search for.
@@ -0,0 +1,73 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Objects/TrackedQuery.hpp"
+
+namespace ocs
+{
+
+const std::size_t TrackedQuery::notTracked;
+
+bool TrackedQuery::contains(ID objectID) const
+{
+    return objectID < positions.size() && positions[objectID] != notTracked;
+}
+
+void TrackedQuery::update(ID objectID, const ComponentMask& mask)
+{
+    bool matches = query.matches(mask);
+
+    if(matches == contains(objectID))
+        return;
+
+    if(!matches)
+    {
+        remove(objectID);
+        return;
+    }
+
+    if(objectID >= positions.size())
+        positions.resize(objectID + 1, notTracked);
+
+    positions[objectID] = matching.size();
+    matching.push_back(objectID);
+}
+
+/** \brief Remove an object by moving the last id into its place.
+ *
+ * \param objectID The object to remove. Nothing happens if it is not in the set.
+ */
+void TrackedQuery::remove(ID objectID)
+{
+    if(!contains(objectID))
+        return;
+
+    std::size_t position = positions[objectID];
+
+    matching[position] = matching.back();
+    positions[matching[position]] = position;
+
+    matching.pop_back();
+    positions[objectID] = notTracked;
+}
+
+}//ocs
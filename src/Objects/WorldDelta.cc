@@ -0,0 +1,499 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Objects/WorldDelta.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ocs
+{
+
+namespace
+{
+
+//!What happened to a component since the baseline. Stored in the low bits of each operation.
+enum DeltaOperation
+{
+    AddComponent = 0,
+    RemoveComponent = 1,
+    PatchComponent = 2,
+    ReplaceComponent = 3
+};
+
+/** \brief Write the difference between two equally sized byte ranges. The XOR of the ranges is written as
+ *         pairs of (unchanged bytes, changed bytes) lengths followed by the changed bytes' XOR values.
+ */
+void writePatch(BinaryWriter& out, const char* oldBytes, const char* newBytes, std::size_t size)
+{
+    std::size_t i = 0;
+    while(i < size)
+    {
+        std::size_t unchangedStart = i;
+        while(i < size && oldBytes[i] == newBytes[i])
+            ++i;
+
+        std::size_t changedStart = i;
+        while(i < size && oldBytes[i] != newBytes[i])
+            ++i;
+
+        out.writeVarint(changedStart - unchangedStart);
+        out.writeVarint(i - changedStart);
+
+        for(std::size_t c = changedStart; c < i; ++c)
+            out.write(static_cast<char>(oldBytes[c] ^ newBytes[c]));
+    }
+}
+
+//!Apply a patch written by writePatch to the old bytes.
+bool readPatch(BinaryReader& in, std::string& bytes)
+{
+    std::size_t i = 0;
+    while(i < bytes.size())
+    {
+        uint64_t unchanged = 0, changed = 0;
+        if(!in.readVarint(unchanged) || !in.readVarint(changed))
+            return false;
+
+        //Checked separately so that huge lengths can not overflow the sum
+        if(unchanged > bytes.size() - i || changed > bytes.size() - i - unchanged)
+            return false;
+
+        i += unchanged;
+        for(uint64_t c = 0; c < changed; ++c, ++i)
+        {
+            char difference = 0;
+            if(!in.read(difference))
+                return false;
+            bytes[i] ^= difference;
+        }
+    }
+
+    return true;
+}
+
+//!Write a list of ascending ids as the gaps between them.
+void writeIDs(BinaryWriter& out, const std::vector<ID>& ids)
+{
+    out.writeVarint(ids.size());
+
+    ID previous = 0;
+    for(auto id : ids)
+    {
+        out.writeVarint(id - previous);
+        previous = id;
+    }
+}
+
+}//namespace
+
+WorldDeltaEncoder::WorldDeltaEncoder(ObjectManager& _objManager) :
+    objManager(_objManager),
+    namesSent(0)
+{
+
+}
+
+/** \brief Write everything that changed since the last call and make the current state the new baseline.
+ *
+ *         Delta layout:
+ *             New names: count, then each name
+ *             Destroyed objects: count, then id gaps
+ *             Created objects: count, then id gaps
+ *             Changed objects: count, then for each object its id gap, operation count and operations.
+ *             Each operation is (name index << 2 | operation) followed by the operation's bytes.
+ *
+ * \param out The writer to append the delta to.
+ */
+void WorldDeltaEncoder::encode(BinaryWriter& out)
+{
+    //Visit the objects in id order, so the ids can be written as gaps
+    ID totalIDs = baseline.size();
+    for(const auto& object : objManager.objects)
+        totalIDs = std::max<ID>(totalIDs, object.getObjectID() + 1);
+    baseline.resize(totalIDs);
+
+    destroyed.clear();
+    created.clear();
+    changed.clear();
+    changes.clear();
+
+    for(ID objectID = 0; objectID < totalIDs; ++objectID)
+    {
+        auto& state = baseline[objectID];
+
+        if(!objManager.objects.isValid(objectID))
+        {
+            if(state.exists)
+            {
+                destroyed.push_back(objectID);
+                state = ObjectState();
+            }
+            continue;
+        }
+
+        if(!state.exists)
+        {
+            created.push_back(objectID);
+            state.exists = true;
+        }
+
+        uint64_t totalOperations = diffObject(objManager.objects[objectID], state);
+
+        if(totalOperations > 0)
+        {
+            changes.writeVarint(objectID - (changed.empty() ? 0 : changed.back()));
+            changes.writeVarint(totalOperations);
+            changes.writeBytes(operations.getBuffer().data(), operations.size());
+            changed.push_back(objectID);
+        }
+    }
+
+    //Names that were first used in this delta
+    out.writeVarint(names.size() - namesSent);
+    for(; namesSent < names.size(); ++namesSent)
+        out.writeString(names[namesSent]);
+
+    writeIDs(out, destroyed);
+    writeIDs(out, created);
+
+    out.writeVarint(changed.size());
+    out.writeBytes(changes.getBuffer().data(), changes.size());
+}
+
+/** \brief Forget the baseline and the names that were sent, so the next delta holds the whole world.
+ */
+void WorldDeltaEncoder::reset()
+{
+    baseline.clear();
+    names.clear();
+    familyToName.clear();
+    namesSent = 0;
+}
+
+/** \brief Write the operations that turn an object's baseline into its current components, and update the
+ *         baseline in place. The bytes of unchanged components are compared without being copied.
+ *
+ * \param object The object as it is now.
+ * \param state The object's baseline, which is brought up to date.
+ * \return The number of operations written to the operations buffer.
+ */
+uint64_t WorldDeltaEncoder::diffObject(const Object& object, ObjectState& state)
+{
+    //Write every named component into one buffer, ordered by name
+    componentBytes.clear();
+    currentComponents.clear();
+
+    for(const auto& compIndex : object.componentIndices)
+    {
+        ComponentSlice slice;
+        if(!getNameIndex(compIndex.first, slice.nameIndex))
+            continue;
+
+        slice.offset = componentBytes.size();
+        object.componentArrays.at(compIndex.first)->getBaseComponent(compIndex.second).writeBinary(componentBytes);
+        slice.size = componentBytes.size() - slice.offset;
+
+        currentComponents.push_back(slice);
+    }
+
+    std::sort(currentComponents.begin(), currentComponents.end(),
+              [](const ComponentSlice& lhs, const ComponentSlice& rhs) { return lhs.nameIndex < rhs.nameIndex; });
+
+    //Walk both sorted component lists together
+    const char* currentBytes = componentBytes.getBuffer().data();
+    auto& oldComps = state.components;
+    const auto& newComps = currentComponents;
+
+    operations.clear();
+    uint64_t totalOperations = 0;
+    bool sameNames = true;
+    std::size_t o = 0, n = 0;
+
+    while(o < oldComps.size() || n < newComps.size())
+    {
+        if(n == newComps.size() || (o < oldComps.size() && oldComps[o].nameIndex < newComps[n].nameIndex))
+        {
+            operations.writeVarint(uint64_t(oldComps[o].nameIndex) << 2 | RemoveComponent);
+            sameNames = false;
+            ++totalOperations;
+            ++o;
+        }
+        else if(o == oldComps.size() || newComps[n].nameIndex < oldComps[o].nameIndex)
+        {
+            operations.writeVarint(uint64_t(newComps[n].nameIndex) << 2 | AddComponent);
+            operations.writeVarint(newComps[n].size);
+            operations.writeBytes(currentBytes + newComps[n].offset, newComps[n].size);
+            sameNames = false;
+            ++totalOperations;
+            ++n;
+        }
+        else
+        {
+            auto& oldBytes = oldComps[o].bytes;
+            const char* newBytes = currentBytes + newComps[n].offset;
+            std::size_t newSize = newComps[n].size;
+
+            if(oldBytes.size() != newSize)
+            {
+                operations.writeVarint(uint64_t(newComps[n].nameIndex) << 2 | ReplaceComponent);
+                operations.writeVarint(newSize);
+                operations.writeBytes(newBytes, newSize);
+                oldBytes.assign(newBytes, newSize);
+                ++totalOperations;
+            }
+            else if(newSize > 0 && std::memcmp(oldBytes.data(), newBytes, newSize) != 0)
+            {
+                operations.writeVarint(uint64_t(newComps[n].nameIndex) << 2 | PatchComponent);
+                writePatch(operations, oldBytes.data(), newBytes, newSize);
+                oldBytes.assign(newBytes, newSize);
+                ++totalOperations;
+            }
+
+            ++o;
+            ++n;
+        }
+    }
+
+    //Components were added or removed, so the baseline's list is rebuilt
+    if(!sameNames)
+    {
+        std::vector<ComponentState> components(newComps.size());
+        for(std::size_t i = 0; i < newComps.size(); ++i)
+        {
+            components[i].nameIndex = newComps[i].nameIndex;
+            components[i].bytes.assign(currentBytes + newComps[i].offset, newComps[i].size);
+        }
+        oldComps.swap(components);
+    }
+
+    return totalOperations;
+}
+
+bool WorldDeltaEncoder::getNameIndex(Family compFamily, uint32_t& nameIndex)
+{
+    auto found = familyToName.find(compFamily);
+    if(found != familyToName.end())
+    {
+        nameIndex = found->second;
+        return true;
+    }
+
+    //Use the first name (alphabetically) that the family was bound to
+    const std::string* compName = nullptr;
+    for(const auto& binding : objManager.stringToCompFamily)
+        if(binding.second == compFamily && (!compName || binding.first < *compName))
+            compName = &binding.first;
+
+    if(!compName)
+        return false;
+
+    nameIndex = names.size();
+    names.push_back(*compName);
+    familyToName[compFamily] = nameIndex;
+
+    return true;
+}
+
+WorldDeltaDecoder::WorldDeltaDecoder(ObjectManager& _objManager) :
+    objManager(_objManager)
+{
+
+}
+
+/** \brief Apply a delta written by WorldDeltaEncoder::encode.
+ *
+ * \param in The reader positioned at the start of the delta.
+ * \return True if the delta was applied. False if it could not be read, in which case it may be partly applied.
+ */
+bool WorldDeltaDecoder::apply(BinaryReader& in)
+{
+    //New names
+    uint64_t totalNames = 0;
+    in.readVarint(totalNames);
+    for(uint64_t i = 0; i < totalNames && in.isGood(); ++i)
+    {
+        std::string name;
+        in.readString(name);
+
+        auto binding = objManager.stringToCompFamily.find(name);
+        names.push_back(name);
+        nameFamilies.push_back(binding != objManager.stringToCompFamily.end() ? binding->second : Family(-1));
+    }
+
+    //Destroyed objects
+    uint64_t total = 0;
+    ID objectID = 0;
+    in.readVarint(total);
+    for(uint64_t i = 0; i < total && in.isGood(); ++i)
+    {
+        uint64_t gap = 0;
+        in.readVarint(gap);
+        objectID += gap;
+
+        auto mirrored = baseline.find(objectID);
+        if(mirrored != baseline.end())
+        {
+            objManager.destroyObject(mirrored->second.localID);
+            baseline.erase(mirrored);
+        }
+    }
+
+    //Created objects
+    objectID = 0;
+    in.readVarint(total);
+    for(uint64_t i = 0; i < total && in.isGood(); ++i)
+    {
+        uint64_t gap = 0;
+        in.readVarint(gap);
+        objectID += gap;
+
+        //Ids come from the wire, so they are looked up rather than used to size anything
+        auto& state = baseline[objectID];
+        if(state.localID == ID(-1))
+            state.localID = objManager.createObject();
+    }
+
+    //Changed objects
+    objectID = 0;
+    in.readVarint(total);
+    for(uint64_t i = 0; i < total && in.isGood(); ++i)
+    {
+        uint64_t gap = 0, totalOperations = 0;
+        in.readVarint(gap);
+        in.readVarint(totalOperations);
+        objectID += gap;
+
+        auto mirrored = baseline.find(objectID);
+        if(mirrored == baseline.end())
+            return false;
+
+        auto& state = mirrored->second;
+
+        for(uint64_t op = 0; op < totalOperations && in.isGood(); ++op)
+        {
+            uint64_t operation = 0;
+            if(!in.readVarint(operation) || (operation >> 2) >= names.size())
+                return false;
+
+            uint32_t nameIndex = operation >> 2;
+            auto compState = std::lower_bound(state.components.begin(), state.components.end(), nameIndex,
+                                              [](const ComponentState& lhs, uint32_t rhs) { return lhs.nameIndex < rhs; });
+            bool hasComponent = compState != state.components.end() && compState->nameIndex == nameIndex;
+
+            switch(operation & 3)
+            {
+                case AddComponent:
+                {
+                    ComponentState newState;
+                    newState.nameIndex = nameIndex;
+                    if(hasComponent || !in.readString(newState.bytes))
+                        return false;
+
+                    updateComponent(state.localID, nameIndex, newState.bytes, true);
+                    state.components.insert(compState, std::move(newState));
+                    break;
+                }
+                case RemoveComponent:
+                {
+                    if(!hasComponent)
+                        return false;
+
+                    if(nameFamilies[nameIndex] != Family(-1))
+                        objManager.detachComponent(state.localID, nameFamilies[nameIndex]);
+                    state.components.erase(compState);
+                    break;
+                }
+                case PatchComponent:
+                {
+                    if(!hasComponent || !readPatch(in, compState->bytes))
+                        return false;
+
+                    updateComponent(state.localID, nameIndex, compState->bytes, false);
+                    break;
+                }
+                case ReplaceComponent:
+                {
+                    if(!hasComponent || !in.readString(compState->bytes))
+                        return false;
+
+                    updateComponent(state.localID, nameIndex, compState->bytes, false);
+                    break;
+                }
+            }
+        }
+    }
+
+    return in.isGood();
+}
+
+/** \brief Get the local object that mirrors one of the encoder's objects.
+ *
+ * \param remoteID The object's id in the encoder's ObjectManager.
+ * \return The id of the local object, or -1 converted to an unsigned number if there is none.
+ */
+ID WorldDeltaDecoder::getLocalID(ID remoteID) const
+{
+    auto mirrored = baseline.find(remoteID);
+    if(mirrored != baseline.end())
+        return mirrored->second.localID;
+    return -1;
+}
+
+/** \brief Forget every mirrored object and name. The local objects are not destroyed.
+ */
+void WorldDeltaDecoder::reset()
+{
+    names.clear();
+    nameFamilies.clear();
+    baseline.clear();
+}
+
+/** \brief Give a local object a component from its bytes, or read the bytes into the component it already has.
+ */
+void WorldDeltaDecoder::updateComponent(ID localID, uint32_t nameIndex, const std::string& bytes, bool isNew)
+{
+    Family compFamily = nameFamilies[nameIndex];
+    if(compFamily == Family(-1))
+        return;
+
+    BinaryReader in(bytes.data(), bytes.size());
+
+    if(isNew)
+    {
+        auto compArray = objManager.compFamilyToCompArray[compFamily];
+        Index compIndex = compArray->add_item(in);
+
+        if(compIndex != BasePackedArray::INVALID_INDEX)
+            objManager.attachComponent(localID, compFamily, compArray, compIndex);
+    }
+    else
+    {
+        auto& object = objManager.objects[localID];
+        auto found = object.componentIndices.find(compFamily);
+
+        if(found != object.componentIndices.end())
+            object.componentArrays[compFamily]->getBaseComponent(found->second).readBinary(in);
+    }
+}
+
+}//ocs
@@ -0,0 +1,331 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Objects/WorldSerializer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+namespace ocs
+{
+
+namespace
+{
+
+const char worldMagic[4] = {'O', 'C', 'S', 'W'};
+
+//!Run the given function for every index in [0, total) spread over the available hardware threads.
+template<typename Function>
+void parallelFor(std::size_t total, Function function)
+{
+    std::size_t totalThreads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), total);
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for(std::size_t i = next++; i < total; i = next++)
+            function(i);
+    };
+
+    std::vector<std::thread> threads;
+    for(std::size_t i = 1; i < totalThreads; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for(auto& thread : threads)
+        thread.join();
+}
+
+}//namespace
+
+const uint32_t WorldSerializer::formatVersion;
+
+/** \brief Save every object to a file.
+ *
+ * \param objManager The manager that owns the objects.
+ * \param filePath The path of the file to write.
+ * \return True if the file could be written. False if not.
+ */
+bool WorldSerializer::saveWorld(ObjectManager& objManager, const std::string& filePath)
+{
+    BinaryWriter out;
+    encodeWorld(objManager, out);
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        std::cerr << "Error: Could not open '" << filePath << "' to save the world\n";
+        return false;
+    }
+
+    file.write(out.getBuffer().data(), out.size());
+
+    return file.good();
+}
+
+/** \brief Create every object that is stored in a file.
+ *
+ * \param objManager The manager to create the objects in.
+ * \param filePath The path of the file to read.
+ * \return True if the whole file was loaded. False if not.
+ */
+bool WorldSerializer::loadWorld(ObjectManager& objManager, const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if(!file)
+    {
+        std::cerr << "Error: Could not open '" << filePath << "' to load the world\n";
+        return false;
+    }
+
+    std::vector<char> bytes(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(bytes.data(), bytes.size());
+
+    BinaryReader in(bytes);
+    return decodeWorld(objManager, in);
+}
+
+/** \brief Write all objects and their named components to a buffer.
+ *         Every component family is encoded in parallel into its own section.
+ *
+ * \param objManager The manager that owns the objects.
+ * \param out The writer to append the world to.
+ */
+void WorldSerializer::encodeWorld(ObjectManager& objManager, BinaryWriter& out)
+{
+    auto familyNames = getFamilyNames(objManager);
+
+    for(const auto& compArray : objManager.compFamilyToCompArray)
+        if(familyNames.find(compArray.first) == familyNames.end() && compArray.second->size() > 0)
+            std::cerr << "Warning: Component family " << compArray.first << " is not bound to a string and will not be saved\n";
+
+    std::vector<BaseComponentArray*> compArrays;
+    for(const auto& familyName : familyNames)
+        compArrays.push_back(objManager.compFamilyToCompArray[familyName.first]);
+
+    //Encode each component array on its own
+    std::vector<BinaryWriter> sections(compArrays.size());
+    parallelFor(compArrays.size(), [&](std::size_t i)
+    {
+        compArrays[i]->writeBinary(sections[i]);
+    });
+
+    //Header
+    out.writeBytes(worldMagic, sizeof(worldMagic));
+    out.write(formatVersion);
+
+    //Name table
+    out.writeVarint(familyNames.size());
+    for(const auto& familyName : familyNames)
+        out.writeString(familyName.second);
+
+    //Objects
+    out.writeVarint(objManager.getTotalObjects());
+    for(const auto& object : objManager.objects)
+        out.writeVarint(object.getObjectID());
+
+    //Component sections
+    out.writeVarint(sections.size());
+    for(std::size_t i = 0; i < sections.size(); ++i)
+    {
+        out.writeVarint(i);
+        out.writeVarint(compArrays[i]->size());
+        out.writeVarint(sections[i].size());
+        out.writeBytes(sections[i].getBuffer().data(), sections[i].size());
+    }
+}
+
+/** \brief Create every object stored in a buffer written by encodeWorld. Objects are given new ids.
+ *         Sections for component names that are not bound in the manager are skipped.
+ *
+ * \param objManager The manager to create the objects in.
+ * \param in The reader positioned at the start of the world.
+ * \return True if the whole world was read. False if the data was invalid or incomplete, in which case the
+ *         objects it created are destroyed again.
+ */
+bool WorldSerializer::decodeWorld(ObjectManager& objManager, BinaryReader& in)
+{
+    if(!readHeader(in))
+        return false;
+
+    //Name table
+    uint64_t totalNames = 0;
+    in.readVarint(totalNames);
+
+    std::vector<std::string> names;
+    for(uint64_t i = 0; i < totalNames && in.isGood(); ++i)
+    {
+        std::string name;
+        in.readString(name);
+        names.push_back(name);
+    }
+
+    //Objects. The saved ids are mapped to the newly created ones.
+    uint64_t totalObjects = 0;
+    in.readVarint(totalObjects);
+
+    //Saved ids come straight from the data, so they are mapped rather than used as indices
+    std::vector<ID> savedIDs;
+    std::unordered_map<ID, ID> newIDs;
+    for(uint64_t i = 0; i < totalObjects && in.isGood(); ++i)
+    {
+        uint64_t savedID = 0;
+        if(!in.readVarint(savedID))
+            break;
+
+        if(!newIDs.emplace(savedID, ID(-1)).second)
+        {
+            std::cerr << "Error: Object id " << savedID << " is saved more than once\n";
+            return false;
+        }
+
+        savedIDs.push_back(savedID);
+    }
+
+    if(!in.isGood())
+    {
+        std::cerr << "Error: World data ended unexpectedly\n";
+        return false;
+    }
+
+    objManager.objects.reserve(objManager.objects.size() + savedIDs.size());
+
+    for(auto savedID : savedIDs)
+        newIDs[savedID] = objManager.createObject();
+
+    //A world that can not be read completely is not left half built
+    auto rollBack = [&]()
+    {
+        for(const auto& newID : newIDs)
+            objManager.destroyObject(newID.second);
+        return false;
+    };
+
+    //Component sections
+    uint64_t totalSections = 0;
+    in.readVarint(totalSections);
+
+    std::vector<ID> owners;
+    std::vector<Index> indices;
+
+    for(uint64_t i = 0; i < totalSections && in.isGood(); ++i)
+    {
+        uint64_t nameIndex = 0, totalComponents = 0, totalBytes = 0;
+        in.readVarint(nameIndex);
+        in.readVarint(totalComponents);
+        in.readVarint(totalBytes);
+
+        BinaryReader section(in.getCurrent(), std::min<uint64_t>(totalBytes, in.getRemaining()));
+        if(!in.skip(totalBytes))
+            break;
+
+        //Every component takes at least a byte, so larger counts can only come from bad data
+        if(nameIndex >= names.size() || totalComponents > section.getRemaining())
+        {
+            std::cerr << "Error: World data has an invalid component section\n";
+            return rollBack();
+        }
+
+        auto family = objManager.stringToCompFamily.find(names[nameIndex]);
+        if(family == objManager.stringToCompFamily.end())
+        {
+            std::cerr << "Error: " << names[nameIndex] << " not bound to a component\n";
+            continue;
+        }
+
+        auto compArray = objManager.compFamilyToCompArray[family->second];
+
+        owners.clear();
+        indices.clear();
+        Index totalRead = compArray->readBinary(section, totalComponents, owners, indices);
+
+        for(Index c = 0; c < totalRead; ++c)
+        {
+            auto owner = newIDs.find(owners[c]);
+
+            if(owner != newIDs.end())
+                objManager.attachComponent(owner->second, family->second, compArray, indices[c]);
+            else
+                compArray->remove(indices[c]);
+        }
+
+        if(totalRead != totalComponents)
+        {
+            std::cerr << "Error: Could not read all '" << names[nameIndex] << "' components\n";
+            return rollBack();
+        }
+    }
+
+    if(!in.isGood())
+    {
+        std::cerr << "Error: World data ended unexpectedly\n";
+        return rollBack();
+    }
+
+    return true;
+}
+
+/** \brief Read the header at the start of a world and check that it can be loaded.
+ *
+ * \param in The reader positioned at the start of the world.
+ * \return True if the data is a world in a supported version. False if not.
+ */
+bool WorldSerializer::readHeader(BinaryReader& in)
+{
+    char magic[sizeof(worldMagic)];
+    uint32_t version = 0;
+
+    if(!in.readBytes(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), worldMagic) || !in.read(version))
+    {
+        std::cerr << "Error: Data is not a world file\n";
+        return false;
+    }
+
+    if(version > formatVersion)
+    {
+        std::cerr << "Error: World format version " << version << " is newer than the supported version " << formatVersion << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+//!Use the first name (alphabetically) that each family was bound to, so saving is deterministic
+std::map<Family, std::string> WorldSerializer::getFamilyNames(const ObjectManager& objManager)
+{
+    std::map<Family, std::string> familyNames;
+    for(const auto& binding : objManager.stringToCompFamily)
+    {
+        auto found = familyNames.find(binding.second);
+        if(found == familyNames.end() || binding.first < found->second)
+            familyNames[binding.second] = binding.first;
+    }
+
+    return familyNames;
+}
+
+}//ocs
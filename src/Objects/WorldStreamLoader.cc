@@ -0,0 +1,446 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Objects/WorldStreamLoader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+#include "OCS/Messaging/MessageHub.hpp"
+#include "OCS/Objects/WorldSerializer.hpp"
+
+namespace ocs
+{
+
+namespace
+{
+
+/** \brief Keeps the unread part of a file in memory, reading more of it a chunk at a time when needed.
+ */
+class ChunkedFile
+{
+    public:
+
+        ChunkedFile(const std::string& filePath) : file(filePath, std::ios::binary | std::ios::ate), start(0), unread(0)
+        {
+            std::streamoff size = file.tellg();
+            if(size > 0)
+                unread = size;
+            file.seekg(0);
+        }
+
+        bool isOpen() const { return file.is_open(); }
+
+        //!Get the number of bytes left in the file that have not been read into the buffer.
+        std::size_t getUnreadBytes() const { return unread; }
+
+        //!A reader over all bytes that have been read but not consumed.
+        BinaryReader getReader() const { return BinaryReader(buffer.data() + start, buffer.size() - start); }
+
+        //!Mark bytes at the front of the reader as used.
+        void consume(std::size_t total) { start += total; }
+
+        //!Read another chunk, or enough to have the given number of unconsumed bytes. Returns false at the end of the file.
+        bool readMore(std::size_t wanted = 0)
+        {
+            //Drop the consumed bytes before growing the buffer
+            buffer.erase(buffer.begin(), buffer.begin() + start);
+            start = 0;
+
+            //Never grow the buffer past the end of the file, whatever size was asked for
+            std::size_t toRead = std::max(WorldStreamLoader::chunkSize, wanted > buffer.size() ? wanted - buffer.size() : 0);
+            toRead = std::min(toRead, unread);
+            std::size_t oldSize = buffer.size();
+
+            buffer.resize(oldSize + toRead);
+            file.read(buffer.data() + oldSize, toRead);
+            buffer.resize(oldSize + file.gcount());
+            unread -= buffer.size() - oldSize;
+
+            return buffer.size() > oldSize;
+        }
+
+    private:
+
+        std::ifstream file;
+        std::vector<char> buffer;
+        std::size_t start;
+        std::size_t unread;
+};
+
+}//namespace
+
+const std::size_t WorldStreamLoader::chunkSize;
+
+WorldStreamLoader::WorldStreamLoader(ObjectManager& _objManager) :
+    objManager(_objManager),
+    decoded(false),
+    decodeFailed(false),
+    cancelled(false),
+    decodedObjects(0),
+    loading(false),
+    failed(false),
+    nextObject(0),
+    totalObjects(0)
+{
+
+}
+
+WorldStreamLoader::~WorldStreamLoader()
+{
+    cancel();
+}
+
+/** \brief Begin loading a world file. The file is read and decoded on a background thread.
+ *         Only one world can be loaded at a time.
+ *
+ * \param filePath The path of the world file.
+ * \return True if loading started. False if another world is still loading or the file could not be opened.
+ */
+bool WorldStreamLoader::start(const std::string& filePath)
+{
+    if(loading)
+    {
+        std::cerr << "Error: A world is already being loaded\n";
+        return false;
+    }
+
+    if(!std::ifstream(filePath, std::ios::binary))
+    {
+        std::cerr << "Error: Could not open '" << filePath << "' to load the world\n";
+        return false;
+    }
+
+    //Copy the bindings now so the reader thread never touches the ObjectManager
+    bindings.clear();
+    for(const auto& binding : objManager.stringToCompFamily)
+        bindings[binding.first] = std::make_pair(binding.second, objManager.compFamilyToCompArray[binding.second]);
+
+    sections.clear();
+    firstComponent.clear();
+    components.clear();
+
+    decoded = false;
+    decodeFailed = false;
+    decodedObjects = 0;
+    cancelled = false;
+
+    loading = true;
+    failed = false;
+    nextObject = 0;
+    totalObjects = 0;
+
+    reader = std::thread(&WorldStreamLoader::readWorld, this, filePath);
+
+    return true;
+}
+
+/** \brief Create objects that have been decoded until the time budget is used up. Whole objects are created,
+ *         so a single large object may go over the budget. Posts a WorldLoadProgress message if any progress was made.
+ *
+ * \param msgHub The hub to post progress to.
+ * \param maxSeconds The time budget for this frame.
+ * \return True if loading has ended, either because all objects were created or the load failed.
+ */
+bool WorldStreamLoader::update(MessageHub& msgHub, double maxSeconds)
+{
+    if(!loading)
+        return true;
+
+    if(!decoded)
+        return false;
+
+    if(decodeFailed)
+    {
+        finish(msgHub, false);
+        return true;
+    }
+
+    totalObjects = decodedObjects;
+
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(maxSeconds));
+
+    ID loadedBefore = nextObject;
+
+    while(nextObject < totalObjects)
+    {
+        ID objectID = objManager.createObject();
+
+        for(auto c = firstComponent[nextObject]; c < firstComponent[nextObject + 1]; ++c)
+        {
+            auto& section = sections[components[c].section];
+            Index compIndex = section.staged->moveItem(components[c].index, section.compArray);
+            objManager.attachComponent(objectID, section.family, section.compArray, compIndex);
+        }
+
+        ++nextObject;
+
+        //Checking the clock is not free, so only do it every few objects
+        if(nextObject % 32 == 0 && Clock::now() >= deadline)
+            break;
+    }
+
+    if(nextObject == totalObjects)
+    {
+        finish(msgHub, true);
+        return true;
+    }
+
+    if(nextObject != loadedBefore)
+        msgHub.postMessage<WorldLoadProgress>(*this, nextObject, totalObjects, false, false);
+
+    return false;
+}
+
+/** \brief Stop the current load and wait for the background thread to exit.
+ */
+void WorldStreamLoader::cancel()
+{
+    cancelled = true;
+
+    if(reader.joinable())
+        reader.join();
+
+    sections.clear();
+    firstComponent.clear();
+    components.clear();
+
+    loading = false;
+}
+
+void WorldStreamLoader::finish(MessageHub& msgHub, bool succeeded)
+{
+    if(reader.joinable())
+        reader.join();
+
+    failed = !succeeded;
+    loading = false;
+
+    sections.clear();
+    firstComponent.clear();
+    components.clear();
+
+    msgHub.postMessage<WorldLoadProgress>(*this, nextObject, totalObjects, true, failed);
+}
+
+/** \brief Read and decode a world file a chunk at a time. Runs on the background thread.
+ *         When it is done every object's components are staged and grouped by object.
+ *
+ * \param filePath The path of the world file.
+ */
+void WorldStreamLoader::readWorld(const std::string& filePath)
+{
+    ChunkedFile file(filePath);
+    //The header is four magic characters and the format version
+    bool ok = file.isOpen() && file.readMore(4 + sizeof(uint32_t));
+
+    //Header
+    if(ok)
+    {
+        auto in = file.getReader();
+        ok = WorldSerializer::readHeader(in);
+        file.consume(in.getPosition());
+    }
+
+    //Bytes needed (from the start of the current reader) to finish the item that did not fit
+    std::size_t wanted = 0;
+
+    //Parse a list of items, reading more of the file whenever the current chunk runs out in the middle of one
+    auto readList = [&](std::function<bool(BinaryReader&)> readItem)
+    {
+        bool haveTotal = false;
+        uint64_t total = 0;
+        uint64_t done = 0;
+
+        while(ok && !cancelled)
+        {
+            auto in = file.getReader();
+            std::size_t position = 0;
+
+            if(!haveTotal)
+                haveTotal = in.readVarint(total);
+
+            if(haveTotal)
+            {
+                position = in.getPosition();
+                while(done < total && readItem(in))
+                {
+                    position = in.getPosition();
+                    ++done;
+                }
+            }
+
+            file.consume(position);
+
+            if(haveTotal && done == total)
+                return;
+
+            ok = ok && file.readMore(wanted > position ? wanted - position : 0);
+            wanted = 0;
+        }
+    };
+
+    //Name table
+    std::vector<std::string> names;
+    readList([&](BinaryReader& in)
+    {
+        std::string name;
+        if(!in.readString(name))
+            return false;
+        names.push_back(name);
+        return true;
+    });
+
+    //Objects. Saved ids come straight from the file, so each is mapped to its position in the object list.
+    std::unordered_map<ID, ID> objectOrder;
+    ID totalSaved = 0;
+    bool repeatedID = false;
+    readList([&](BinaryReader& in)
+    {
+        uint64_t savedID = 0;
+        if(!in.readVarint(savedID))
+            return false;
+
+        if(!objectOrder.emplace(savedID, totalSaved).second)
+            repeatedID = true;
+
+        ++totalSaved;
+        return true;
+    });
+
+    if(repeatedID)
+    {
+        std::cerr << "Error: World file '" << filePath << "' saves an object id more than once\n";
+        ok = false;
+    }
+
+    //Component sections. Each section is decoded as soon as all of its bytes have been read.
+    std::vector<std::vector<ID>> owners;
+    readList([&](BinaryReader& in)
+    {
+        uint64_t nameIndex = 0, totalComponents = 0, totalBytes = 0;
+        if(!in.readVarint(nameIndex) || !in.readVarint(totalComponents) || !in.readVarint(totalBytes))
+            return false;
+
+        //Sizes come from the file, so a section can not be larger than what is left of it, and every component
+        //takes at least one byte
+        if(totalBytes > in.getRemaining() && totalBytes - in.getRemaining() > file.getUnreadBytes())
+        {
+            std::cerr << "Error: A section in world file '" << filePath << "' is larger than the file\n";
+            ok = false;
+            return false;
+        }
+
+        if(totalBytes > in.getRemaining())
+        {
+            //Make sure the next attempt has the whole section
+            wanted = in.getPosition() + totalBytes;
+            return false;
+        }
+
+        BinaryReader sectionIn(in.getCurrent(), totalBytes);
+        in.skip(totalBytes);
+
+        if(totalComponents > totalBytes)
+        {
+            std::cerr << "Error: A section in world file '" << filePath << "' has more components than bytes\n";
+            ok = false;
+            return false;
+        }
+
+        if(nameIndex >= names.size())
+            return true;
+
+        auto binding = bindings.find(names[nameIndex]);
+        if(binding == bindings.end())
+        {
+            std::cerr << "Error: " << names[nameIndex] << " not bound to a component\n";
+            return true;
+        }
+
+        Section section;
+        section.family = binding->second.first;
+        section.compArray = binding->second.second;
+        section.staged.reset(section.compArray->createEmpty());
+
+        std::vector<ID> sectionOwners;
+        std::vector<Index> indices;
+        if(section.staged->readBinary(sectionIn, totalComponents, sectionOwners, indices) != totalComponents)
+        {
+            std::cerr << "Error: Could not read all '" << names[nameIndex] << "' components\n";
+            ok = false;
+        }
+
+        sections.push_back(std::move(section));
+        owners.push_back(std::move(sectionOwners));
+
+        return true;
+    });
+
+    if(ok && !cancelled)
+    {
+        //Count the components of each object, then place them so each object's components are together
+        firstComponent.assign(totalSaved + 1, 0);
+        for(const auto& sectionOwners : owners)
+        {
+            for(auto owner : sectionOwners)
+            {
+                auto order = objectOrder.find(owner);
+                if(order != objectOrder.end())
+                    ++firstComponent[order->second + 1];
+            }
+        }
+
+        for(std::size_t i = 1; i < firstComponent.size(); ++i)
+            firstComponent[i] += firstComponent[i - 1];
+
+        components.resize(firstComponent.back());
+        std::vector<std::size_t> filled(firstComponent.begin(), firstComponent.end() - 1);
+
+        for(uint32_t s = 0; s < owners.size(); ++s)
+        {
+            for(Index c = 0; c < owners[s].size(); ++c)
+            {
+                auto order = objectOrder.find(owners[s][c]);
+                if(order != objectOrder.end())
+                {
+                    auto& staged = components[filled[order->second]++];
+                    staged.section = s;
+                    staged.index = c;
+                }
+            }
+        }
+
+        decodedObjects = totalSaved;
+    }
+    else if(!cancelled)
+        std::cerr << "Error: Could not read world file '" << filePath << "'\n";
+
+    decodeFailed = !ok;
+    decoded = true;
+}
+
+}//ocs
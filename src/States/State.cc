@@ -22,13 +22,25 @@ freely, subject to the following restrictions:
 
 #include "OCS/States/State.hpp"
 
+#include <algorithm>
+#include <thread>
+
 namespace ocs
 {
 
-State::State() :
+const double State::spinTime = 0.001;
+
+State::State(JobSystem& _jobSystem) :
     sysManager(objManager, msgHub),
-    running(false)
+    jobSystem(_jobSystem),
+    running(false),
+    targetTickRate(0.0),
+    idle(false),
+    fixedTimestep(0.0),
+    maxCatchUpSteps(5),
+    accumulatedTime(0.0)
 {
+    sysManager.setJobSystem(&jobSystem);
 
 }
 
@@ -42,13 +54,161 @@ void State::run()
     running = true;
     timer.restart();
 
+    auto nextFrame = std::chrono::steady_clock::now();
+
     while(running)
-        update(timer.restart());
+    {
+        advance(timer.restart());
+
+        if(idle && running)
+            waitWhileIdle();
+
+        if(targetTickRate > 0.0 && running)
+            paceFrame(nextFrame);
+    }
+}
+
+/** \brief Sleep until the next frame is due, then spin for the last moment. A frame that ran late moves the
+ *         schedule back rather than running the frames after it back to back.
+ *
+ * \param nextFrame When the frame that just ran was due. Moved to when the next one is.
+ */
+void State::paceFrame(std::chrono::steady_clock::time_point& nextFrame)
+{
+    auto now = std::chrono::steady_clock::now();
+    nextFrame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / targetTickRate));
+
+    if(nextFrame <= now)
+    {
+        nextFrame = now;
+        return;
+    }
+
+    auto wakeTime = nextFrame - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(spinTime));
+    if(wakeTime > now)
+        std::this_thread::sleep_until(wakeTime);
+
+    while(std::chrono::steady_clock::now() < nextFrame)
+        std::this_thread::yield();
+}
+
+/** \brief Block until something can happen. The time spent waiting moves the hub's clock, so scheduled messages
+ *         are still posted on time, but is not passed to update, as nothing was simulated while idle.
+ */
+void State::waitWhileIdle()
+{
+    Timer idleTimer;
+    double dueTime = 0.0;
+
+    if(msgHub.getNextScheduledTime(dueTime))
+        msgHub.waitForMessages(std::max(0.0, dueTime - msgHub.getTime()));
+    else
+        msgHub.waitForMessages();
+
+    msgHub.advanceTime(idleTimer.getElapsedTime());
+    timer.restart();
+}
+
+/** \brief Simulate the time that has passed. With a fixed timestep the time is added to what is left over from
+ *         earlier frames and whole steps are run until less than a step remains. If more than the catch-up limit
+ *         has built up, e.g. after a long hitch, the extra time is dropped so the simulation does not spiral.
+ *
+ * \param dt The real time in seconds since the last call.
+ */
+void State::advance(double dt)
+{
+    if(fixedTimestep <= 0.0)
+    {
+        step(dt);
+        return;
+    }
+
+    accumulatedTime = std::min(accumulatedTime + dt, fixedTimestep * maxCatchUpSteps);
+
+    //Allow for rounding so a whole number of steps is not left a hair short
+    const double tolerance = fixedTimestep * 1e-6;
+
+    while(accumulatedTime + tolerance >= fixedTimestep)
+    {
+        step(fixedTimestep);
+        accumulatedTime = std::max(0.0, accumulatedTime - fixedTimestep);
+    }
+}
+
+void State::step(double dt)
+{
+    msgHub.advanceTime(dt);
+    update(dt);
+    msgHub.advanceFrame();
+}
+
+/** \brief Switch between fixed and variable steps. Leftover time from earlier frames is discarded.
+ *
+ * \param step The length of a step in seconds, e.g. 1.0 / 60.0, or 0 for variable steps.
+ * \param maxSteps The most steps one call to advance may run to catch up.
+ */
+void State::setFixedTimestep(double step, unsigned int maxSteps)
+{
+    fixedTimestep = step;
+    maxCatchUpSteps = std::max(1u, maxSteps);
+    accumulatedTime = 0.0;
+}
+
+double State::getInterpolationAlpha() const
+{
+    return (fixedTimestep > 0.0) ? accumulatedTime / fixedTimestep : 0.0;
+}
+
+/** \brief Step the state without sleeping or measuring frame times. Systems are not timed, and commands and messages
+ *         from systems on worker threads are applied in schedule order, so the same starting state always gives the
+ *         same result however many workers the pool has. The wall clock is only read to report how fast the steps
+ *         ran. Stops early if stop is called.
+ *
+ * \param totalTicks The number of steps to run.
+ * \param step The length of each step in seconds.
+ * \return The number of steps run, how long they took and the steps per second.
+ */
+HeadlessRunStats State::runHeadless(uint64_t totalTicks, double step)
+{
+    if(step <= 0.0)
+        step = (fixedTimestep > 0.0) ? fixedTimestep : 1.0 / 60.0;
+
+    bool wasTiming = sysManager.isTimingEnabled();
+    sysManager.setTimingEnabled(false);
+
+    running = true;
+    HeadlessRunStats stats = {0, 0.0, 0.0};
+    Timer headlessTimer;
+
+    for(; stats.ticks < totalTicks && running; ++stats.ticks)
+        this->step(step);
+
+    stats.seconds = headlessTimer.getElapsedTime();
+    stats.ticksPerSecond = (stats.seconds > 0.0) ? stats.ticks / stats.seconds : 0.0;
+
+    running = false;
+    sysManager.setTimingEnabled(wasTiming);
+
+    return stats;
+}
+
+void State::setTargetTickRate(double ticksPerSecond)
+{
+    targetTickRate = std::max(0.0, ticksPerSecond);
+}
+
+void State::setIdle(bool isIdle)
+{
+    idle = isIdle;
+
+    //Let run see the change if it is already waiting
+    msgHub.wake();
 }
 
 void State::stop()
 {
     running = false;
+    msgHub.wake();
 }
 
 }//ocs
@@ -0,0 +1,299 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Systems/JobSystem.hpp"
+
+#include "OCS/Commands/CommandBuffer.hpp"
+#include "OCS/Messaging/MessageQueue.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ocs
+{
+
+const unsigned int JobSystem::subKeyBits;
+
+namespace
+{
+
+//!The pool and worker index of the calling thread, if it is a worker.
+struct WorkerIdentity
+{
+    const JobSystem* system;
+    int index;
+};
+
+thread_local WorkerIdentity workerIdentity = {nullptr, -1};
+
+}//namespace
+
+JobSystem::JobSystem(unsigned int totalWorkers, bool pinWorkers) :
+    pendingJobs(0),
+    stopping(false)
+{
+    for(unsigned int i = 0; i < totalWorkers; ++i)
+        workers.emplace_back(new Worker());
+
+    //Start the threads once every deque exists, as workers steal from each other
+    for(unsigned int i = 0; i < totalWorkers; ++i)
+    {
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+
+        if(pinWorkers)
+            pinWorker(i);
+    }
+}
+
+/** \brief Stop the workers. Jobs that are still queued are run first.
+ */
+JobSystem::~JobSystem()
+{
+    while(runPendingJob())
+    {
+
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+
+    wakeCondition.notify_all();
+
+    for(auto& worker : workers)
+        worker->thread.join();
+}
+
+unsigned int JobSystem::getDefaultWorkerCount()
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+    return (cores > 1) ? cores - 1 : 0;
+}
+
+/** \brief Get the pool shared by every State that is not given its own. It is started the first time it is
+ *         asked for, with one fewer worker than the number of cores.
+ */
+JobSystem& JobSystem::getShared()
+{
+    static JobSystem shared;
+    return shared;
+}
+
+int JobSystem::getWorkerIndex()
+{
+    return workerIdentity.index;
+}
+
+void JobSystem::submit(Job job)
+{
+    push(QueuedJob{std::move(job), nullptr, getSortKey()});
+}
+
+void JobSystem::submit(JobCounter& counter, Job job)
+{
+    submit(counter, std::move(job), getSortKey());
+}
+
+void JobSystem::submit(JobCounter& counter, Job job, uint64_t sortKey)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    push(QueuedJob{std::move(job), &counter, sortKey});
+}
+
+/** \brief Set the sort key for everything the calling thread records from now on. Commands go through the
+ *         CommandBuffer's key and messages queued for other threads' hubs through the MessageQueue's key.
+ */
+void JobSystem::setSortKey(uint64_t sortKey)
+{
+    CommandBuffer::setSortKey(sortKey);
+    MessageQueue::setSortKey(sortKey);
+}
+
+uint64_t JobSystem::getSortKey()
+{
+    return CommandBuffer::getSortKey();
+}
+
+/** \brief Help with queued jobs until a counter reaches zero. The jobs run may be unrelated to the counter,
+ *         which keeps every thread busy without starting more threads.
+ *
+ * \param counter The counter to wait for.
+ */
+void JobSystem::wait(JobCounter& counter)
+{
+    while(!counter.isDone())
+        if(!runPendingJob())
+            std::this_thread::yield();
+}
+
+/** \brief Queue a job. A worker queues it on its own deque, where it is likely to run it next while its data is
+ *         still in cache. Other threads queue it on the shared queue.
+ *
+ * \param queued The job.
+ */
+void JobSystem::push(QueuedJob queued)
+{
+    //Counted before it is queued, so the count never drops below the number of queued jobs
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++pendingJobs;
+    }
+
+    if(workerIdentity.system == this)
+    {
+        Worker& worker = *workers[workerIdentity.index];
+        std::lock_guard<std::mutex> lock(worker.jobsMutex);
+        worker.jobs.push_back(std::move(queued));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        sharedJobs.push_back(std::move(queued));
+    }
+
+    wakeCondition.notify_one();
+}
+
+void JobSystem::runJob(QueuedJob& queued)
+{
+    uint64_t sortKey = getSortKey();
+    setSortKey(queued.sortKey);
+
+    queued.job();
+
+    setSortKey(sortKey);
+
+    if(queued.counter)
+        queued.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+bool JobSystem::runPendingJob()
+{
+    QueuedJob queued;
+    if(!takeJob(workerIdentity.system == this ? workerIdentity.index : -1, queued))
+        return false;
+
+    runJob(queued);
+    return true;
+}
+
+bool JobSystem::stealJob(std::deque<QueuedJob>& jobs, std::mutex& jobsMutex, QueuedJob& job)
+{
+    std::lock_guard<std::mutex> lock(jobsMutex);
+
+    if(jobs.empty())
+        return false;
+
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    --pendingJobs;
+
+    return true;
+}
+
+/** \brief Take a job for a thread to run.
+ *
+ * \param self The calling worker's index, or -1 for other threads.
+ * \param job Set to the job.
+ * \return True if a job was taken.
+ */
+bool JobSystem::takeJob(int self, QueuedJob& job)
+{
+    if(pendingJobs.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    if(self >= 0)
+    {
+        Worker& worker = *workers[self];
+        std::lock_guard<std::mutex> lock(worker.jobsMutex);
+
+        if(!worker.jobs.empty())
+        {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            --pendingJobs;
+            return true;
+        }
+    }
+
+    if(stealJob(sharedJobs, sharedMutex, job))
+        return true;
+
+    //Start with the next worker along, so thieves spread out over the victims
+    std::size_t total = workers.size();
+    for(std::size_t i = 1; i <= total; ++i)
+    {
+        std::size_t victim = (self + i) % total;
+        if(static_cast<int>(victim) != self && stealJob(workers[victim]->jobs, workers[victim]->jobsMutex, job))
+            return true;
+    }
+
+    return false;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    workerIdentity.system = this;
+    workerIdentity.index = index;
+
+    QueuedJob queued;
+
+    while(true)
+    {
+        if(takeJob(index, queued))
+        {
+            runJob(queued);
+            queued.job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || pendingJobs.load() > 0; });
+
+        if(stopping && pendingJobs.load() == 0)
+            break;
+    }
+}
+
+void JobSystem::pinWorker(unsigned int index)
+{
+#ifdef __linux__
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET((index + 1) % cores, &cpus);
+
+    if(pthread_setaffinity_np(workers[index]->thread.native_handle(), sizeof(cpus), &cpus) != 0)
+        std::cerr << "Error: Could not pin job worker " << index << " to a core\n";
+#else
+    (void)index;
+#endif
+}
+
+}//ocs
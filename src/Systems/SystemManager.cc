@@ -22,17 +22,62 @@ freely, subject to the following restrictions:
 
 #include "OCS/Systems/SystemManager.hpp"
 
+#include "OCS/Messaging/MessageHub.hpp"
 #include "OCS/Objects/ObjectManager.hpp"
+#include "OCS/Systems/JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
 
 namespace ocs
 {
 
+namespace
+{
+
+bool overlaps(const std::vector<Family>& first, const std::vector<Family>& second)
+{
+    for(auto family : first)
+        if(std::find(second.begin(), second.end(), family) != second.end())
+            return true;
+
+    return false;
+}
+
+}//namespace
+
+bool SystemAccess::conflictsWith(const SystemAccess& other) const
+{
+    if(!declared || !other.declared)
+        return true;
+
+    //Systems posting the same message type stay in order so the board's order does not depend on timing
+    return overlaps(writeComponents, other.writeComponents) ||
+           overlaps(writeComponents, other.readComponents) ||
+           overlaps(readComponents, other.writeComponents) ||
+           overlaps(producedMessages, other.producedMessages) ||
+           sharesMessagesWith(other);
+}
+
+bool SystemAccess::sharesMessagesWith(const SystemAccess& other) const
+{
+    if(!declared || !other.declared)
+        return true;
+
+    return overlaps(producedMessages, other.consumedMessages) || overlaps(consumedMessages, other.producedMessages);
+}
+
 ID SystemManager::versionCounter = 0;
 std::queue<ID> SystemManager::availableVersions;
 
 SystemManager::SystemManager(ObjectManager& _objManager, MessageHub& _msgHub) :
     objManager(_objManager),
-    msgHub(_msgHub)
+    msgHub(_msgHub),
+    jobSystem(nullptr),
+    tick(0),
+    timingEnabled(true),
+    inlineJobs(0),
+    scheduleChanged(true)
 {
     if(availableVersions.empty())
     {
@@ -47,13 +92,363 @@ SystemManager::SystemManager(ObjectManager& _objManager, MessageHub& _msgHub) :
 
 SystemManager::~SystemManager()
 {
+    for(auto removeSystem : systemRemovers)
+        (this->*removeSystem)();
+
     availableVersions.push(version);
 }
 
 void SystemManager::updateAllSystems(double dt)
 {
+    if(jobSystem && systemList.size() > 1)
+    {
+        updateSystemsInParallel(dt);
+        ++tick;
+        return;
+    }
+
+    //Commands recorded by a system are applied in the order the systems were added
+    uint64_t sortKey = 0;
+    for(auto sys = systemList.begin(); sys != systemList.end();)
+    {
+        SystemPhase phase = (*sys)->phase;
+
+        for(; sys != systemList.end() && (*sys)->phase == phase; ++sys)
+        {
+            JobSystem::setSortKey(sortKey++ << JobSystem::subKeyBits);
+
+            if(isSystemDue(**sys, dt))
+                runSystem(**sys, getJobSystem());
+        }
+
+        JobSystem::setSortKey(0);
+        syncPhase();
+    }
+
+    if(systemList.empty())
+        syncPhase();
+
+    ++tick;
+}
+
+/** \brief The sync point after a phase. Deferred message handlers run once all systems in the phase, on any
+ *         thread, have posted.
+ */
+void SystemManager::syncPhase()
+{
+    objManager.applyDeferredCommands();
+    msgHub.syncMessages();
+    msgHub.dispatchMessages();
+}
+
+bool SystemManager::isSystemDue(System& sys, double dt)
+{
+    sys.pendingTime += dt;
+
+    if(tick % sys.rateDivisor != sys.ratePhase)
+        return false;
+
+    //A system with nothing to work on has no time to catch up on
+    if(sys.trackedQuery && sys.trackedQuery->empty())
+    {
+        sys.pendingTime = 0.0;
+        return false;
+    }
+
+    return true;
+}
+
+void SystemManager::trackSystemQuery(System& sys)
+{
+    if(sys.queryDeclared && !sys.trackedQuery)
+        sys.trackedQuery = &objManager.trackQuery(sys.objectQuery);
+}
+
+void SystemManager::releaseSystemQuery(System& sys)
+{
+    if(sys.trackedQuery)
+    {
+        objManager.releaseQuery(*sys.trackedQuery);
+        sys.trackedQuery = nullptr;
+    }
+}
+
+void SystemManager::runSystem(System& sys, JobSystem& jobs)
+{
+    if(!timingEnabled)
+    {
+        sys.update(objManager, msgHub, jobs, sys.pendingTime);
+        sys.pendingTime = 0.0;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    sys.update(objManager, msgHub, jobs, sys.pendingTime);
+    sys.pendingTime = 0.0;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sys.timings.record(elapsed);
+
+    if(sys.timings.checkBudget(elapsed))
+        msgHub.postMessage<SystemOverBudget>(sys, elapsed, sys.timings.getBudget());
+}
+
+/** \brief Score each phase by how often a system on it would update on the same tick as each other system,
+ *         and return the lowest scoring phase.
+ *
+ * \param sys The system being given a divisor.
+ * \param divisor The new divisor.
+ * \return The phase, from 0 to divisor - 1.
+ */
+unsigned int SystemManager::pickRatePhase(const System& sys, unsigned int divisor) const
+{
+    unsigned int bestPhase = 0;
+    double bestOverlap = 0.0;
+
+    for(unsigned int phase = 0; phase < divisor; ++phase)
+    {
+        double overlap = 0.0;
+
+        for(const auto& other : systemList)
+        {
+            if(other.get() == &sys || other->rateDivisor == 1)
+                continue;
+
+            //Two systems share ticks if their phases match modulo the divisors' greatest common divisor
+            unsigned int a = divisor, b = other->rateDivisor;
+            while(b != 0)
+            {
+                unsigned int r = a % b;
+                a = b;
+                b = r;
+            }
+
+            if(phase % a == other->ratePhase % a)
+                overlap += static_cast<double>(a) / other->rateDivisor;
+        }
+
+        if(phase == 0 || overlap < bestOverlap)
+        {
+            bestPhase = phase;
+            bestOverlap = overlap;
+        }
+    }
+
+    return bestPhase;
+}
+
+void SystemManager::setJobSystem(JobSystem* _jobSystem)
+{
+    jobSystem = _jobSystem;
+}
+
+/** \brief Connect every pair of conflicting systems in the same phase from the one added first to the one added
+ *         later. Systems with no path between them may run at the same time.
+ */
+void SystemManager::buildSchedule()
+{
+    schedule.clear();
+    phaseStarts.clear();
+
     for(auto& sys : systemList)
-        sys->update(objManager, msgHub, dt);
+    {
+        if(schedule.empty() || schedule.back().system->phase != sys->phase)
+            phaseStarts.push_back(schedule.size());
+
+        schedule.push_back(SystemNode{sys.get(), std::vector<std::size_t>(), std::vector<bool>(), 0});
+
+        for(auto prepare : sys->getAccess().prepareArrays)
+            prepare(objManager);
+    }
+
+    phaseStarts.push_back(schedule.size());
+
+    for(std::size_t i = 0; i < schedule.size(); ++i)
+    {
+        const auto& access = schedule[i].system->getAccess();
+
+        for(std::size_t j = i + 1; j < schedule.size() && schedule[j].system->phase == schedule[i].system->phase; ++j)
+        {
+            const auto& laterAccess = schedule[j].system->getAccess();
+
+            if(access.conflictsWith(laterAccess))
+            {
+                schedule[i].successors.push_back(j);
+                schedule[i].successorNeedsSync.push_back(access.sharesMessagesWith(laterAccess));
+                ++schedule[j].totalPredecessors;
+            }
+        }
+    }
+
+    scheduleChanged = false;
+}
+
+/** \brief Run every system once, one phase at a time, with a sync point after each phase.
+ *
+ * \param dt The time elapsed since the last frame
+ */
+void SystemManager::updateSystemsInParallel(double dt)
+{
+    if(scheduleChanged)
+        buildSchedule();
+
+    std::vector<bool> due(schedule.size());
+
+    for(std::size_t phase = 0; phase + 1 < phaseStarts.size(); ++phase)
+    {
+        //Checked when the phase starts, as the sync points before it may have changed the systems' objects
+        for(std::size_t i = phaseStarts[phase]; i < phaseStarts[phase + 1]; ++i)
+            due[i] = isSystemDue(*schedule[i].system, dt);
+
+        auto ownerThread = msgHub.getOwnerThread();
+        msgHub.setOwnerThread(std::thread::id());
+
+        updatePhaseInParallel(phaseStarts[phase], phaseStarts[phase + 1], due, ownerThread);
+
+        msgHub.setOwnerThread(ownerThread);
+        syncPhase();
+    }
+}
+
+/** \brief Run every system in a phase, starting each as soon as the systems it conflicts with have finished. The
+ *         calling thread hands systems to the job system and helps run them. While systems run, every message
+ *         is queued, and the hub is only synced when no system is running.
+ *
+ * \param first The index of the phase's first system in the schedule.
+ * \param last The index after the phase's last system.
+ * \param due Whether each system in the schedule updates on this tick.
+ * \param ownerThread The hub's owner thread, given back to it while an undeclared system runs.
+ */
+void SystemManager::updatePhaseInParallel(std::size_t first, std::size_t last, const std::vector<bool>& due, std::thread::id ownerThread)
+{
+    std::vector<std::size_t> remaining(schedule.size());
+    std::vector<bool> waitingForSync(schedule.size(), false);
+    std::vector<std::size_t> ready;
+
+    for(std::size_t i = first; i < last; ++i)
+    {
+        remaining[i] = schedule[i].totalPredecessors;
+
+        if(remaining[i] == 0)
+            ready.push_back(i);
+    }
+
+    std::size_t running = 0;
+    std::size_t totalFinished = 0;
+    std::vector<std::size_t> finished;
+
+    //Let the systems waiting on a finished one start. Systems that did not run this tick posted nothing to sync.
+    auto releaseSuccessors = [&](std::size_t index, bool ran)
+    {
+        ++totalFinished;
+
+        const auto& node = schedule[index];
+        for(std::size_t s = 0; s < node.successors.size(); ++s)
+        {
+            std::size_t successor = node.successors[s];
+
+            if(ran && node.successorNeedsSync[s])
+                waitingForSync[successor] = true;
+
+            if(--remaining[successor] == 0)
+                ready.push_back(successor);
+        }
+    };
+
+    while(totalFinished < last - first)
+    {
+        //Start every ready system, except ones that need messages from a finished system while others still run
+        for(std::size_t r = 0; r < ready.size();)
+        {
+            std::size_t index = ready[r];
+
+            if(!due[index])
+            {
+                ready[r] = ready.back();
+                ready.pop_back();
+                releaseSuccessors(index, false);
+                continue;
+            }
+
+            if(waitingForSync[index])
+            {
+                if(running > 0)
+                {
+                    ++r;
+                    continue;
+                }
+
+                msgHub.syncMessages();
+                std::fill(waitingForSync.begin(), waitingForSync.end(), false);
+            }
+
+            ready[r] = ready.back();
+            ready.pop_back();
+
+            //Undeclared systems conflict with every other system, so nothing else is running. They may depend on
+            //the thread they run on, so they run here with the hub behaving as it does when updating in order.
+            if(!schedule[index].system->getAccess().declared)
+            {
+                msgHub.syncMessages();
+                msgHub.setOwnerThread(ownerThread);
+                runScheduledSystem(index);
+                msgHub.setOwnerThread(std::thread::id());
+
+                ++running;
+                continue;
+            }
+
+            ++running;
+            jobSystem->submit([this, index]() { runScheduledSystem(index); });
+        }
+
+        if(running == 0)
+            continue;
+
+        //Help run systems until at least one has finished
+        while(true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+
+                if(!finishedSystems.empty())
+                {
+                    finished.swap(finishedSystems);
+                    break;
+                }
+            }
+
+            if(jobSystem->runPendingJob())
+                continue;
+
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            finishedCondition.wait_for(lock, std::chrono::microseconds(100), [this]() { return !finishedSystems.empty(); });
+        }
+
+        for(auto index : finished)
+        {
+            --running;
+            releaseSuccessors(index, true);
+        }
+
+        finished.clear();
+    }
+}
+
+void SystemManager::runScheduledSystem(std::size_t index)
+{
+    //Commands and queued messages from a system are applied in the order the systems were added. The previous key
+    //is put back as this may run inside another system that is waiting for its own jobs.
+    uint64_t sortKey = JobSystem::getSortKey();
+    JobSystem::setSortKey(uint64_t(index) << JobSystem::subKeyBits);
+    runSystem(*schedule[index].system, *jobSystem);
+    JobSystem::setSortKey(sortKey);
+
+    //Notify while holding the lock, as the updating thread may return and destroy the manager once it sees the system finish
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    finishedSystems.push_back(index);
+    finishedCondition.notify_one();
 }
 
 ID SystemManager::getTotalSystems() const
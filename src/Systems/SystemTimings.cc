@@ -0,0 +1,88 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Systems/SystemTimings.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ocs
+{
+
+const std::size_t SystemTimings::windowSize;
+
+SystemTimings::SystemTimings() :
+    nextSample(0),
+    lastSample(0.0),
+    budget(0.0),
+    timesOverBudget(0)
+{
+
+}
+
+void SystemTimings::record(double seconds)
+{
+    if(samples.size() < windowSize)
+        samples.push_back(seconds);
+    else
+        samples[nextSample] = seconds;
+
+    nextSample = (nextSample + 1) % windowSize;
+    lastSample = seconds;
+}
+
+SystemTimingStats SystemTimings::getStats() const
+{
+    SystemTimingStats stats = {samples.size(), lastSample, 0.0, 0.0, 0.0, 0.0, timesOverBudget};
+
+    if(samples.empty())
+        return stats;
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    stats.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    stats.p50 = sorted[(sorted.size() - 1) / 2];
+    stats.p99 = sorted[(sorted.size() - 1) * 99 / 100];
+    stats.max = sorted.back();
+
+    return stats;
+}
+
+void SystemTimings::clear()
+{
+    samples.clear();
+    nextSample = 0;
+    lastSample = 0.0;
+    timesOverBudget = 0;
+}
+
+bool SystemTimings::checkBudget(double seconds)
+{
+    if(budget <= 0.0 || seconds <= budget)
+        return false;
+
+    ++timesOverBudget;
+    return true;
+}
+
+}//ocs
@@ -0,0 +1,108 @@
+/*Copyright (c) <2014> Kevin Miller - KevM1227@gmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "OCS/Utilities/BinaryStream.hpp"
+
+void BinaryWriter::writeVarint(uint64_t value)
+{
+    //Write 7 bits at a time, using the high bit to mark that more bytes follow
+    while(value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeString(const std::string& str)
+{
+    writeVarint(str.size());
+    writeBytes(str.data(), str.size());
+}
+
+void BinaryWriter::writeBytes(const void* bytes, std::size_t total)
+{
+    auto first = static_cast<const char*>(bytes);
+    buffer.insert(buffer.end(), first, first + total);
+}
+
+bool BinaryReader::readVarint(uint64_t& value)
+{
+    value = 0;
+
+    //A 64 bit value never takes more than 10 bytes
+    for(unsigned int shift = 0; shift < 70 && good; shift += 7)
+    {
+        if(position >= length)
+            break;
+
+        uint8_t byte = static_cast<uint8_t>(data[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0)
+            return true;
+    }
+
+    good = false;
+    return false;
+}
+
+bool BinaryReader::readString(std::string& str)
+{
+    uint64_t strLength = 0;
+    if(!readVarint(strLength) || strLength > getRemaining())
+    {
+        good = false;
+        return false;
+    }
+
+    str.assign(data + position, strLength);
+    position += strLength;
+
+    return true;
+}
+
+bool BinaryReader::readBytes(void* bytes, std::size_t total)
+{
+    if(!good || total > getRemaining())
+    {
+        good = false;
+        return false;
+    }
+
+    std::memcpy(bytes, data + position, total);
+    position += total;
+
+    return true;
+}
+
+bool BinaryReader::skip(std::size_t total)
+{
+    if(!good || total > getRemaining())
+    {
+        good = false;
+        return false;
+    }
+
+    position += total;
+    return true;
+}
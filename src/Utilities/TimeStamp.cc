@@ -24,10 +24,14 @@ freely, subject to the following restrictions:
 #include <ctime>
 
 std::string TimeStamp::getTimeStamp(const std::string& format)
+{
+    return getTimeStamp(format, time(0));
+}
+
+std::string TimeStamp::getTimeStamp(const std::string& format, time_t currentTime)
 {
     std::string timeStamp;
 
-    time_t currentTime = time(0);
     struct tm tStruct = *localtime(&currentTime);
     char buffer[256];
     strftime(buffer, sizeof(buffer), format.c_str(), &tStruct);
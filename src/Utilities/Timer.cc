@@ -24,20 +24,20 @@ freely, subject to the following restrictions:
 
 Timer::Timer()
 {
-    start = std::chrono::system_clock::now();
+    start = std::chrono::steady_clock::now();
 }
 
 double Timer::restart()
 {
     auto elapsedTime = getElapsedTime();
-    start = std::chrono::system_clock::now();
+    start = std::chrono::steady_clock::now();
 
     return elapsedTime;
 }
 
 double Timer::getElapsedTime()
 {
-    std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
+    std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
 
     std::chrono::duration<double> elapsedSeconds = end - start;
 